@@ -46,6 +46,7 @@ class BLEHandler(QObject):
         self.connected = False
         self.running = False
         self.device_address: Optional[str] = None
+        self.last_data: Optional[VehicleData] = None
         self.loop: Optional[asyncio.AbstractEventLoop] = None
         self.thread: Optional[QThread] = None
         
@@ -319,9 +320,10 @@ class BLEHandler(QObject):
             json_str = data.decode('utf-8')
             json_data = json.loads(json_str)
             
-            vehicle_data = VehicleData.from_dict(json_data)
+            vehicle_data = VehicleData.from_dict(json_data, self.last_data)
             
             if vehicle_data.is_valid():
+                self.last_data = vehicle_data
                 self.data_received.emit(vehicle_data)
             else:
                 logger.warning(f"Invalid data received: {json_data}")
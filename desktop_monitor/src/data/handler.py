@@ -42,6 +42,7 @@ class DataHandler(QObject):
         self.connection_type: str = "none"  # "serial", "ble", or "none"
         self.running = False
         self.read_thread: Optional[threading.Thread] = None
+        self.last_data: Optional[VehicleData] = None
         
         # Initialize BLE handler if available
         if BLEAK_AVAILABLE:
@@ -198,9 +199,10 @@ class DataHandler(QObject):
                             
                             try:
                                 json_data = json.loads(json_str)
-                                vehicle_data = VehicleData.from_dict(json_data)
+                                vehicle_data = VehicleData.from_dict(json_data, self.last_data)
                                 
                                 if vehicle_data.is_valid():
+                                    self.last_data = vehicle_data
                                     self.data_received.emit(vehicle_data)
                                 else:
                                     logger.warning(f"Invalid data received: {json_data}")
@@ -6,10 +6,16 @@ Defines the data structures used throughout the application
 """
 
 from dataclasses import dataclass, field
-from typing import Optional, Dict, Any
+from typing import Optional, Dict, Any, List
 from datetime import datetime
 from enum import Enum
 
+# Keys of device messages that are metadata rather than vehicle signals
+NON_SIGNAL_KEYS = {
+    'timestamp', 'system_state', 'wifi_connected', 'wifi_rssi', 'age', 'stale',
+    'quality', 'engine_running', 'data_valid', 'ble_connected', 'uptime'
+}
+
 class SystemState(Enum):
     """System operation states"""
     UNKNOWN = "UNKNOWN"
@@ -33,25 +39,47 @@ class VehicleData:
     system_state: SystemState = SystemState.UNKNOWN
     wifi_connected: bool = False
     wifi_rssi: int = 0
+    signals: Dict[str, float] = field(default_factory=dict)
+    signal_age_ms: Dict[str, int] = field(default_factory=dict)
+    stale_signals: List[str] = field(default_factory=list)
     
     @classmethod
-    def from_dict(cls, data: Dict[str, Any]) -> 'VehicleData':
-        """Create VehicleData from dictionary"""
+    def from_dict(cls, data: Dict[str, Any], previous: Optional['VehicleData'] = None) -> 'VehicleData':
+        """Create VehicleData from dictionary
+        
+        The firmware only sends signals that changed since its last update.
+        Missing fields are carried over from ``previous`` when given.
+        """
+        base = previous if previous is not None else cls()
+        
+        # Age comes either as an "age" object (BLE/HTTP) or "<signal>_age_ms" keys (serial)
+        ages = dict(data.get('age', {}))
+        signals = dict(base.signals)
+        for key, value in data.items():
+            if key.endswith('_age_ms'):
+                ages[key[:-len('_age_ms')]] = value
+            elif key not in NON_SIGNAL_KEYS and isinstance(value, (int, float)) and not isinstance(value, bool):
+                signals[key] = value
+        
         # Convert float to int for numeric fields
         return cls(
-            timestamp=int(data.get('timestamp', 0)),
-            rpm=int(data.get('rpm', 0)),
-            speed=int(data.get('speed', 0)),
-            coolant_temp=int(float(data.get('coolant_temp', 0))),
-            throttle_position=int(data.get('throttle_position', 0)),
-            system_state=SystemState(data.get('system_state', 'UNKNOWN')),
-            wifi_connected=bool(data.get('wifi_connected', False)),
-            wifi_rssi=int(data.get('wifi_rssi', 0))
+            timestamp=int(data.get('timestamp', base.timestamp)),
+            rpm=int(data.get('rpm', base.rpm)),
+            speed=int(data.get('speed', base.speed)),
+            coolant_temp=int(float(data.get('coolant_temp', base.coolant_temp))),
+            throttle_position=int(data.get('throttle_position', base.throttle_position)),
+            system_state=SystemState(data.get('system_state', base.system_state.value)),
+            wifi_connected=bool(data.get('wifi_connected', base.wifi_connected)),
+            wifi_rssi=int(data.get('wifi_rssi', base.wifi_rssi)),
+            signals=signals,
+            signal_age_ms={key: int(value) for key, value in ages.items()},
+            stale_signals=list(data.get('stale', []))
         )
     
     def to_dict(self) -> Dict[str, Any]:
         """Convert to dictionary"""
         return {
+            **self.signals,
             'timestamp': self.timestamp,
             'rpm': self.rpm,
             'speed': self.speed,
@@ -59,7 +87,9 @@ class VehicleData:
             'throttle_position': self.throttle_position,
             'system_state': self.system_state.value,
             'wifi_connected': self.wifi_connected,
-            'wifi_rssi': self.wifi_rssi
+            'wifi_rssi': self.wifi_rssi,
+            'age': dict(self.signal_age_ms),
+            'stale': list(self.stale_signals)
         }
     
     def is_valid(self) -> bool:
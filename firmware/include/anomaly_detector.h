@@ -0,0 +1,47 @@
+/**
+ * @file anomaly_detector.h
+ * @brief Rule and z-score based anomaly detection on tracked signals
+ * @version 1.0
+ * @date 2025-11-08
+ *
+ * Rules are evaluated against the signal store and the streaming
+ * statistics after every acquisition cycle. A rule raises its alert once
+ * the condition has held for hold_ms and clears with hysteresis at
+ * clear_threshold, or as soon as the rule cannot be evaluated (signal
+ * not valid, value below gate_min).
+ */
+
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include "common_types.h"
+
+#define ANOMALY_MAX_RULES           16
+
+/* Rule types */
+typedef enum {
+    ANOMALY_ABOVE = 0,              /* Value above threshold */
+    ANOMALY_BELOW = 1,              /* Value below threshold */
+    ANOMALY_ZSCORE = 2,             /* |z| against the EWMA baseline above threshold */
+    ANOMALY_TREND_ABOVE = 3         /* Trend (units/min) above threshold */
+} AnomalyType_t;
+
+/* Anomaly rule */
+typedef struct {
+    const char* name;               /* Alert name reported to clients */
+    const char* signal_key;         /* Signal store key (must be tracked by Stats for z-score/trend) */
+    AnomalyType_t type;
+    float threshold;                /* Raise level */
+    float clear_threshold;          /* Clear level (hysteresis) */
+    uint16_t hold_ms;               /* Condition time before raising */
+    float gate_min;                 /* Rule only evaluated while value >= gate_min */
+} AnomalyRule_t;
+
+/* Anomaly Detector Interface */
+Status_t Anomaly_Init(const AnomalyRule_t* rules, uint8_t count);
+void Anomaly_Evaluate(uint32_t now);
+uint32_t Anomaly_GetActiveMask(void);
+uint8_t Anomaly_GetActiveNames(const char** names, uint8_t max_names);
+uint32_t Anomaly_GetChangeCount(void);
+
+#endif /* ANOMALY_DETECTOR_H */
@@ -17,12 +17,24 @@
 #include <BLEUtils.h>
 #include <BLE2902.h>
 #include "common_types.h"
+#include "signal_store.h"
 
 // BLE Service UUIDs
 #define BLE_SERVICE_UUID        "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
 #define BLE_CHAR_DATA_UUID      "beb5483e-36e1-4688-b7f5-ea07361b26a8"
 #define BLE_CHAR_STATUS_UUID    "beb5483e-36e1-4688-b7f5-ea07361b26a9"
 
+// Interval of full notifications between signal deltas (ms)
+#define BLE_FULL_UPDATE_INTERVAL 5000
+
+// Largest notification payload (MTU 517 minus ATT header) and the fixed
+// part of each data notification (timestamp, flags, punctuation)
+#define BLE_MAX_PAYLOAD 512
+#define BLE_CHUNK_OVERHEAD 120
+
+// Status notification buffer (state, alerts, condensed health)
+#define BLE_STATUS_JSON_SIZE 512
+
 // BLE Device Name
 #define BLE_DEVICE_NAME         "Svartpilen401_OBD2"
 
@@ -49,10 +61,24 @@ private:
     BLEConnectionCallbacks* pCallbacks;
     
     uint32_t lastDataSend;
+    uint32_t lastFullSend;
+    int32_t lastSentRaw[SIGNAL_STORE_CAPACITY];     // Raw value last notified
+    uint64_t lastSentMask;                          // Signals whose lastSentRaw the client holds
+    
+    // Notification being assembled (values, ages and stale keys)
+    char chunkValues[BLE_MAX_PAYLOAD];
+    char chunkAges[BLE_MAX_PAYLOAD];
+    char chunkStale[BLE_MAX_PAYLOAD];
+    size_t chunkValuesLength;
+    size_t chunkAgesLength;
+    size_t chunkStaleLength;
     
     void setupCharacteristics();
-    String createDataJSON(const VehicleData_t* data);
-    String createStatusJSON(SystemState_t state, bool wifiConnected, int8_t rssi);
+    void resetChunk();
+    void flushChunk(const VehicleData_t* data, uint32_t now);
+    void sendSignalDeltas(const VehicleData_t* data, bool full, uint32_t now);
+    size_t createStatusJSON(char* buffer, size_t size, SystemState_t state, bool wifiConnected,
+                            int8_t rssi, const char* const* alerts, uint8_t alertCount);
     
 public:
     // Public for callback access
@@ -69,8 +95,9 @@ public:
     // Send vehicle data via BLE
     Status_t sendVehicleData(const VehicleData_t* data);
     
-    // Send system status via BLE
-    Status_t sendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi);
+    // Send system status (and active anomaly alerts) via BLE
+    Status_t sendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi,
+                              const char* const* alerts = nullptr, uint8_t alertCount = 0);
     
     // Check if device is connected
     bool isConnected() const { return deviceConnected; }
@@ -87,6 +114,9 @@ public:
     
     // Check for connection timeout (Windows BLE doesn't send disconnect)
     void checkConnectionTimeout();
+    
+    // Force the next notification to carry every signal
+    void resetDeltaState();
 };
 
 // Global BLE Service instance (declared in ble_service.cpp)
@@ -95,7 +125,8 @@ extern OBD2BLEService* g_bleService;
 // Helper functions
 Status_t BLE_Init(const BLEConfig_t* config);
 Status_t BLE_SendVehicleData(const VehicleData_t* data);
-Status_t BLE_SendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi);
+Status_t BLE_SendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi,
+                              const char* const* alerts = nullptr, uint8_t alertCount = 0);
 bool BLE_IsConnected();
 void BLE_UpdateStatus();
 void BLE_EnsureAdvertising(); // Ensure advertising is active when not connected
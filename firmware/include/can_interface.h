@@ -15,6 +15,21 @@
 extern "C" {
 #endif
 
+/* OBD2 addressing (ISO 15765-4, 11-bit) */
+#define CAN_OBD2_FUNCTIONAL_ID      0x7DF   /* Broadcast request to all ECUs */
+#define CAN_OBD2_REQUEST_BASE       0x7E0   /* Physical request to ECU n: 0x7E0 + n */
+#define CAN_OBD2_RESPONSE_BASE      0x7E8   /* Response from ECU n: 0x7E8 + n */
+#define CAN_OBD2_FUNCTIONAL         0xFF    /* Target value: no physical ECU assigned */
+#define CAN_OBD2_MAX_ECUS           8
+
+/* OBD2 addressing (ISO 15765-4, 29-bit normal fixed, tester address 0xF1) */
+#define CAN_OBD2_EXT_FUNCTIONAL_ID  0x18DB33F1  /* Broadcast request to all ECUs */
+#define CAN_OBD2_EXT_REQUEST_BASE   0x18DA00F1  /* | (ECU address << 8) */
+#define CAN_OBD2_EXT_RESPONSE_BASE  0x18DAF100  /* | ECU address */
+
+/* Set in an ID key to mark a 29-bit identifier (decode tables, CAN_FrameKey) */
+#define CAN_ID_EXTENDED_FLAG        0x80000000
+
 /* CAN frame structure */
 typedef struct {
     uint32_t id;                    /* CAN ID */
@@ -22,8 +37,14 @@ typedef struct {
     uint8_t data[8];                /* Data bytes */
     bool extended;                  /* Extended frame flag */
     bool remote;                    /* Remote frame flag */
+    uint32_t timestamp_us;          /* micros() when the frame was read from the controller */
 } CAN_Frame_t;
 
+/* One key for both ID widths, so lookups compare a single value */
+static inline uint32_t CAN_FrameKey(const CAN_Frame_t* frame) {
+    return frame->extended ? (frame->id | CAN_ID_EXTENDED_FLAG) : frame->id;
+}
+
 /* Hardware pin configuration for MCP2515 */
 typedef struct {
     uint8_t mcp2515_cs;             /* MCP2515 CS pin */
@@ -38,16 +59,133 @@ typedef struct {
 typedef struct {
     uint8_t rx_pin;                 /* CAN RX pin */
     uint8_t tx_pin;                 /* CAN TX pin */
-    uint32_t baudrate;              /* CAN baudrate */
+    uint32_t baudrate;              /* CAN baudrate, or CAN_BAUDRATE_AUTO */
 } CAN_Config_t;
 
+/* CAN_Config_t.baudrate: detect the bit rate from bus traffic (oscillator as configured) */
+#define CAN_BAUDRATE_AUTO           0
+
+/* MCP2515 controller configuration */
+typedef struct {
+    uint32_t spi_clock_hz;          /* SPI clock, up to 10 MHz */
+    uint32_t crystal_hz;            /* Oscillator on the MCP2515 board: 8 or 16 MHz */
+    uint32_t bitrate;               /* CAN bit rate: 125k, 250k, 500k or 1M */
+} MCP2515_Config_t;
+
+/* Receive queue depth between the RX task and CAN_ReceiveFrame() */
+#define CAN_RX_QUEUE_SIZE           64
+/* CAN_SetSequenceCheck() argument that disables the check */
+#define CAN_SEQUENCE_CHECK_OFF      0xFFFFFFFF
+
+/* Receive path and controller error statistics */
+typedef struct {
+    uint32_t frames;                /* Frames read from the controller */
+    uint32_t hw_overflows;          /* RX0OVR/RX1OVR events: frames lost in the controller */
+    uint32_t queue_overflows;       /* Frames dropped because the receive queue was full */
+    uint8_t max_burst;              /* Most frames taken in one drain */
+    uint8_t queue_high_water;
+    uint8_t eflg;                   /* Last error flags (EFLG) */
+    uint8_t tec;                    /* Transmit error counter */
+    uint8_t rec;                    /* Receive error counter */
+    uint8_t max_tec;
+    uint8_t max_rec;
+    uint32_t error_warnings;        /* Entries into error warning (a counter >= 96) */
+    uint32_t error_passive;         /* Entries into error passive (a counter >= 128) */
+    uint32_t bus_off;               /* Entries into bus-off (TEC > 255) */
+    uint32_t seq_frames;            /* Frames on the sequence-check ID */
+    uint32_t seq_lost;              /* Counter gaps on the sequence-check ID */
+} CAN_RxStats_t;
+
+/* Per-ID receive statistics, one entry per distinct CAN_FrameKey() */
+#define CAN_ID_STATS_SIZE           32      /* Power of two; later IDs are counted as untracked */
+typedef struct {
+    uint32_t key;                   /* CAN_FrameKey() */
+    uint32_t frames;
+    uint32_t last_us;               /* Receive time of the latest frame */
+    uint32_t min_period_us;         /* Between consecutive frames; UINT32_MAX until the second */
+    uint32_t max_period_us;
+    uint8_t length;                 /* DLC of the latest frame */
+} CAN_IdStats_t;
+
+/* Fault confinement state (ISO 11898) */
+typedef enum {
+    CAN_ERROR_ACTIVE = 0,           /* TEC and REC below 128 */
+    CAN_ERROR_PASSIVE = 1,          /* TEC or REC at 128 or above */
+    CAN_ERROR_BUS_OFF = 2           /* TEC above 255; recovered by a mode change */
+} CAN_ErrorState_t;
+
+/* Error state machine metrics */
+typedef struct {
+    uint8_t state;                  /* CAN_ErrorState_t */
+    uint32_t residency_ms[3];       /* Time spent in each state since boot */
+    uint32_t recovery_attempts;     /* Mode changes tried while bus-off */
+    uint32_t recoveries;            /* Bus-off periods that ended */
+    uint32_t last_recovery_ms;      /* Bus-off entry to error-active/passive */
+    uint32_t max_recovery_ms;
+    uint32_t backoff_ms;            /* Wait before the next attempt, 0 when not bus-off */
+} CAN_ErrorStats_t;
+
+/* Receive-path microbenchmark result (internal loopback) */
+typedef struct {
+    uint16_t frames;                /* Frames received during the run */
+    uint32_t spi_clock_hz;
+    uint32_t mean_ns;               /* Mean drain time (status burst + READ RX BUFFER) per frame */
+    uint32_t max_us;                /* Slowest single receive */
+    uint32_t max_frame_rate;        /* Frames/s the receive path sustains */
+    uint32_t bus_frame_rate;        /* Frames/s of a saturated bus (8-byte standard frames) */
+} CAN_Benchmark_t;
+
+/* Transmit queue depth (frames waiting for one of the three TX buffers) */
+#define CAN_TX_QUEUE_SIZE           16
+
+/* Transmit priority; also the MCP2515 TXP level of the loaded buffer */
+typedef enum {
+    CAN_TX_PRIORITY_LOW = 0,        /* Background polling */
+    CAN_TX_PRIORITY_NORMAL = 1,     /* Regular requests, CAN_SendFrame() */
+    CAN_TX_PRIORITY_HIGH = 2,       /* Tester present, shift-light critical PIDs */
+    CAN_TX_PRIORITY_URGENT = 3      /* ISO-TP flow control */
+} CAN_TxPriority_t;
+
+/* Transmit statistics */
+typedef struct {
+    uint32_t queued;                /* Frames accepted by CAN_QueueFrame() */
+    uint32_t sent;
+    uint32_t failed;                /* Aborted: transmit error, or no bus access within the TX limit */
+    uint32_t queue_full;            /* Frames rejected because the queue was full */
+    uint8_t max_queue_depth;
+    uint32_t max_latency_us;        /* Longest queue-to-bus time */
+} CAN_TxStats_t;
+
+/* Callback for frames not consumed by an OBD2 response wait */
+typedef void (*CAN_FrameCallback_t)(const CAN_Frame_t* frame);
+
+/* Transmit completion: sequence from CAN_QueueFrame(), time the frame left the controller */
+typedef void (*CAN_TxCallback_t)(uint16_t sequence, uint32_t can_id, uint32_t tx_time_us, bool sent);
+
 /* CAN Interface Functions */
+bool CAN_ConfigureController(const MCP2515_Config_t* config);
+const MCP2515_Config_t* CAN_GetControllerConfig(void);
+Status_t CAN_AutoDetect(uint32_t window_ms, MCP2515_Config_t* result);
 bool CAN_InitMCP2515(const HardwarePins_t* pins);
 bool CAN_Reset(void);
 bool CAN_SendFrame(const CAN_Frame_t* frame);
 bool CAN_ReceiveFrame(CAN_Frame_t* frame);
+uint16_t CAN_ReceiveFrames(CAN_Frame_t* frames, uint16_t max, uint32_t timeout_ms);
 bool CAN_Available(void);
+uint16_t CAN_RxPending(void);
 bool CAN_SetFilter(uint32_t filter_id, uint32_t mask_id);
+void CAN_SetPassiveFrameCallback(CAN_FrameCallback_t callback);
+Status_t CAN_QueueFrame(const CAN_Frame_t* frame, uint8_t priority, uint16_t* sequence);
+void CAN_ProcessTx(void);
+void CAN_SetTxCallback(CAN_TxCallback_t callback);
+void CAN_GetTxStats(CAN_TxStats_t* stats);
+void CAN_GetRxStats(CAN_RxStats_t* stats);
+uint8_t CAN_GetIdStats(CAN_IdStats_t* table, uint8_t max, uint32_t* untracked);
+void CAN_ClearIdStats(void);
+void CAN_SetSequenceCheck(uint32_t can_id);
+void CAN_GetErrorStats(CAN_ErrorStats_t* stats);
+const char* CAN_ErrorStateName(uint8_t state);
+Status_t CAN_RunBenchmark(uint16_t frame_count, CAN_Benchmark_t* result);
 
 /* Generic CAN Interface (for compatibility) */
 Status_t CAN_Init(const CAN_Config_t* config);
@@ -56,6 +194,22 @@ Status_t CAN_DeInit(void);
 /* OBD2 specific functions */
 Status_t CAN_SendOBD2Request(uint8_t pid);
 Status_t CAN_ReceiveOBD2Response(uint8_t pid, uint8_t* data, uint8_t* length, uint32_t timeout_ms);
+Status_t CAN_SendOBD2ModeRequest(uint8_t mode, const uint8_t* params, uint8_t param_count);
+Status_t CAN_ReceiveOBD2ModeResponse(uint8_t mode, uint8_t pid, uint8_t* data, uint8_t* length, uint32_t timeout_ms);
+Status_t CAN_ReceiveOBD2Stamped(uint8_t mode, uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us, uint32_t timeout_ms);
+Status_t CAN_ReceiveOBD2Timed(uint8_t mode, uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us, uint32_t timeout_ms);
+Status_t CAN_ReceiveOBD2MultiFrame(uint8_t mode, uint8_t pid, uint8_t* data, uint16_t max_length, uint16_t* length, uint32_t timeout_ms);
+
+/* OBD2 physical addressing */
+Status_t CAN_DiscoverOBD2Responders(uint8_t mode, const uint8_t* params, uint8_t param_count,
+                                    uint8_t* responder_mask, uint32_t timeout_ms);
+Status_t CAN_SetOBD2Target(uint8_t mode, uint8_t ecu);
+uint8_t CAN_GetOBD2Target(uint8_t mode);
+void CAN_SetOBD2Addressing(bool extended);
+bool CAN_IsOBD2Extended(void);
+uint32_t CAN_GetOBD2FunctionalId(void);
+uint32_t CAN_GetOBD2RequestId(uint8_t ecu);
+uint32_t CAN_GetOBD2ResponseId(uint8_t ecu);
 
 #ifdef __cplusplus
 }
@@ -21,8 +21,18 @@ typedef enum {
     STATUS_BUSY = 5
 } Status_t;
 
+/* OBD2 services (modes) */
+typedef enum {
+    OBD2_MODE_CURRENT_DATA = 0x01,
+    OBD2_MODE_FREEZE_FRAME = 0x02,
+    OBD2_MODE_VEHICLE_INFO = 0x09
+} OBD2_Mode_t;
+
 /* OBD2 PIDs for Husqvarna Svartpilen 401 */
 typedef enum {
+    PID_SUPPORTED_01_20 = 0x00,
+    PID_MONITOR_STATUS = 0x01,
+    PID_FREEZE_DTC = 0x02,
     PID_ENGINE_RPM = 0x0C,
     PID_VEHICLE_SPEED = 0x0D,
     PID_ENGINE_COOLANT_TEMP = 0x05,
@@ -30,9 +40,41 @@ typedef enum {
     PID_FUEL_LEVEL = 0x2F,
     PID_ENGINE_RUNTIME = 0x1F,
     PID_FUEL_TRIM_BANK1 = 0x06,
-    PID_INTAKE_MANIFOLD_PRESSURE = 0x0B
+    PID_INTAKE_MANIFOLD_PRESSURE = 0x0B,
+    PID_SUPPORTED_21_40 = 0x20,
+    PID_SUPPORTED_41_60 = 0x40
 } OBD2_PID_t;
 
+/* Mode 09 info types */
+#define INFOTYPE_VIN                0x02
+
+#define VIN_LENGTH                  17
+
+/* Signals carried in VehicleData_t */
+typedef enum {
+    SIGNAL_RPM = 0,
+    SIGNAL_SPEED = 1,
+    SIGNAL_COOLANT_TEMP = 2,
+    SIGNAL_THROTTLE_POSITION = 3,
+    SIGNAL_FUEL_LEVEL = 4,
+    SIGNAL_ENGINE_RUNTIME = 5,
+    SIGNAL_COUNT
+} VehicleSignal_t;
+
+/* Per-signal quality */
+typedef enum {
+    SIGNAL_QUALITY_NONE = 0,        /* Never received */
+    SIGNAL_QUALITY_VALID = 1,       /* Fresh value */
+    SIGNAL_QUALITY_STALE = 2,       /* Not refreshed within its stale limit */
+    SIGNAL_QUALITY_FAILED = 3       /* Last request failed, value is the previous good one */
+} SignalQuality_t;
+
+/* Capture time and quality of one signal */
+typedef struct {
+    uint32_t timestamp;             /* Capture timestamp of the value (ms) */
+    uint8_t quality;                /* SignalQuality_t */
+} SignalStatus_t;
+
 /* Vehicle data structure */
 typedef struct {
     uint16_t rpm;                   /* Engine RPM */
@@ -44,8 +86,21 @@ typedef struct {
     bool engineRunning;             /* Engine status */
     bool dataValid;                 /* Data validity flag */
     uint32_t lastUpdate;            /* Last update timestamp */
+    SignalStatus_t status[SIGNAL_COUNT]; /* Per-signal capture time and quality */
 } VehicleData_t;
 
+/* Freeze frame (Mode 02) stored by the ECU when a DTC sets */
+typedef struct {
+    uint16_t dtc;                   /* Raw DTC that stored the frame (0 = none) */
+    uint8_t frameNumber;            /* Freeze frame number */
+    uint16_t rpm;                   /* Engine RPM */
+    uint8_t speed;                  /* Vehicle speed in km/h */
+    int8_t coolantTemp;             /* Coolant temperature in C */
+    uint8_t throttlePosition;       /* Throttle position 0-100% */
+    bool valid;                     /* At least the DTC PID was answered */
+    uint32_t timestamp;             /* Retrieval timestamp */
+} FreezeFrame_t;
+
 /* System states */
 typedef enum {
     SYSTEM_STATE_INIT = 0,
@@ -62,5 +117,6 @@ typedef void (*DataUpdateCallback_t)(const VehicleData_t* data);
 /* Constants */
 #define CAN_TIMEOUT_MS              100
 #define OBD2_REQUEST_TIMEOUT_MS     500
+#define SIGNAL_STALE_MIN_MS         1000    /* Lower bound of per-signal stale limit */
 
 #endif /* COMMON_TYPES_H */
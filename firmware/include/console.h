@@ -0,0 +1,27 @@
+/**
+ * @file console.h
+ * @brief Line-oriented command console on the USB serial port
+ * @version 1.0
+ * @date 2025-11-16
+ *
+ * The console runs in its own low-priority task. It polls the serial
+ * port for complete lines, so the loop task never reads or waits on
+ * input, and holds the serial output lock only while it prints. Sinks
+ * in the loop skip a pass rather than wait for that lock.
+ *
+ * "help" lists the commands: settings (see settings.h) are read with
+ * "get", changed with "set ..." and "log N", stored with "save";
+ * "metrics", "health", "trace" and "canids" dump live statistics.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "common_types.h"
+
+#define CONSOLE_LINE_LENGTH         64
+
+/* Console Interface */
+Status_t Console_Init(void);
+
+#endif /* CONSOLE_H */
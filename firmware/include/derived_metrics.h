@@ -0,0 +1,31 @@
+/**
+ * @file derived_metrics.h
+ * @brief On-device derived metrics: gear, trip distance, fuel estimate, RPM bands
+ * @version 1.0
+ * @date 2025-11-07
+ *
+ * Consumes rpm/speed/throttle samples incrementally (O(1) per sample, fixed
+ * memory) and publishes the results as ordinary signals in the signal store.
+ */
+
+#ifndef DERIVED_METRICS_H
+#define DERIVED_METRICS_H
+
+#include "common_types.h"
+#include "vehicle_profile.h"
+
+#define DERIVED_RPM_BANDS           4
+
+/* Derived metrics configuration */
+typedef struct {
+    uint16_t rpm_band_edges[DERIVED_RPM_BANDS - 1];  /* Ascending band limits */
+    uint16_t fuel_coefficient;      /* Fuel flow calibration, 2793 = theoretical default */
+    uint8_t idle_load_pct;          /* Minimum engine load assumed for fuel flow */
+} DerivedConfig_t;
+
+/* Derived Metrics Interface */
+Status_t Derived_Init(const DerivedConfig_t* config, const VehicleProfile_t* profile);
+void Derived_ProcessSample(const VehicleData_t* data);
+void Derived_ResetTrip(void);
+
+#endif /* DERIVED_METRICS_H */
@@ -0,0 +1,72 @@
+/**
+ * @file event_capture.h
+ * @brief Pre/post-trigger event capture to flash
+ * @version 1.0
+ * @date 2025-11-03
+ *
+ * Keeps a rolling RAM ring of acquired samples. When a trigger fires
+ * (DTC set, coolant over limit, RPM spike) the samples from
+ * pre_trigger_ms before the trigger up to post_trigger_ms after it are
+ * frozen and written to LittleFS by a low-priority writer task, so the
+ * acquisition path never waits on flash.
+ */
+
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include "common_types.h"
+
+/* Ring capacity in samples (256 x 200 ms = ~51 s of history) */
+#define CAPTURE_RING_SIZE           256
+/* Number of event files kept on flash before the oldest is overwritten */
+#define CAPTURE_MAX_FILES           16
+
+/* Trigger sources */
+typedef enum {
+    CAPTURE_TRIGGER_NONE = 0,
+    CAPTURE_TRIGGER_DTC = 1,
+    CAPTURE_TRIGGER_COOLANT = 2,
+    CAPTURE_TRIGGER_RPM_SPIKE = 3,
+    CAPTURE_TRIGGER_MANUAL = 4
+} CaptureTrigger_t;
+
+/* Capture configuration */
+typedef struct {
+    uint32_t pre_trigger_ms;        /* History kept before the trigger */
+    uint32_t post_trigger_ms;       /* Recording continued after the trigger */
+    int8_t coolant_limit_c;         /* Coolant trigger threshold */
+    uint16_t rpm_spike_delta;       /* RPM change between two samples that triggers */
+} CaptureConfig_t;
+
+/* Raw sample as stored in the ring and on flash */
+typedef struct {
+    uint32_t timestamp;             /* Sample timestamp (ms) */
+    uint16_t rpm;                   /* Engine RPM */
+    uint8_t speed;                  /* Vehicle speed in km/h */
+    int8_t coolantTemp;             /* Coolant temperature in C */
+    uint8_t throttlePosition;       /* Throttle position 0-100% */
+    uint8_t reserved[3];
+} CaptureSample_t;
+
+/* Event file header, followed by sample_count CaptureSample_t records */
+typedef struct {
+    uint32_t magic;                 /* CAPTURE_FILE_MAGIC */
+    uint32_t event_index;           /* Monotonic event counter */
+    uint32_t trigger_time;          /* Timestamp of the newest sample at the trigger (ms) */
+    uint8_t trigger;                /* CaptureTrigger_t */
+    uint8_t reserved;
+    uint16_t sample_count;          /* Samples following the header */
+    FreezeFrame_t freeze_frame;     /* ECU freeze frame (valid for DTC triggers) */
+} CaptureFileHeader_t;
+
+#define CAPTURE_FILE_MAGIC          0x31565445  /* "ETV1" */
+
+/* Event Capture Interface */
+Status_t Capture_Init(const CaptureConfig_t* config);
+void Capture_AddSample(const VehicleData_t* data);
+Status_t Capture_Trigger(CaptureTrigger_t trigger, const FreezeFrame_t* freeze_frame);
+bool Capture_IsBusy(void);
+uint32_t Capture_GetEventCount(void);
+uint32_t Capture_GetDroppedCount(void);
+
+#endif /* EVENT_CAPTURE_H */
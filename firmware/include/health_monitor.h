@@ -0,0 +1,74 @@
+/**
+ * @file health_monitor.h
+ * @brief Task and loop health: execution time, overruns, stalls, watermarks
+ * @version 1.0
+ * @date 2025-11-13
+ *
+ * A monitor times one repeating unit of work: a task's loop body or a
+ * section inside it. Health_Begin()/Health_End() bracket each run; a run
+ * longer than the budget is an overrun. Monitors registered with
+ * HEALTH_FLAG_WATCHDOG subscribe their task to the ESP32 task watchdog
+ * and feed it from Health_End(), so a task stuck inside a run is reset
+ * by the watchdog. Before that, the health task reports any run still
+ * open after HEALTH_STALL_MS as a stall, naming the monitor.
+ *
+ * The health task also samples stack high-water marks of monitored tasks
+ * and the heap low-water mark and largest free block.
+ */
+
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#include <stddef.h>
+#include "common_types.h"
+
+#define HEALTH_MAX_MONITORS         8
+#define HEALTH_PERIOD_MS            1000    /* Health task sampling period */
+#define HEALTH_STALL_MS             2000    /* Open run reported as a stall */
+#define HEALTH_SUMMARY_MS           60000   /* Health_PrintSummary() from the health task */
+#define HEALTH_WATCHDOG_TIMEOUT_S   8       /* Task watchdog: reset after a stall this long */
+
+/* Health_Register() flags */
+#define HEALTH_FLAG_TASK            0x01    /* Track the calling task's stack */
+#define HEALTH_FLAG_WATCHDOG        0x02    /* Subscribe the calling task to the task watchdog */
+
+typedef struct {
+    const char* name;
+    void* task;                     /* TaskHandle_t, nullptr for a section */
+    uint32_t budget_us;
+    uint32_t runs;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t overruns;              /* Runs longer than budget_us */
+    uint32_t stalls;                /* Runs still open after HEALTH_STALL_MS */
+    uint32_t stack_free_min;        /* Bytes never used of the task's stack */
+    uint32_t started_us;
+    volatile bool running;
+    bool stall_reported;
+    bool watchdog;
+} HealthMonitor_t;
+
+typedef struct {
+    uint32_t uptime_s;
+    uint32_t heap_free;
+    uint32_t heap_min_free;         /* Low-water mark since boot */
+    uint32_t heap_largest_block;    /* Fragmentation indicator */
+    uint32_t stalls;                /* All monitors */
+    uint32_t overruns;
+    uint8_t reset_reason;           /* esp_reset_reason_t of this boot */
+    bool watchdog_reset;            /* This boot followed a task or interrupt watchdog reset */
+} HealthSystem_t;
+
+/* Health Monitor Interface */
+Status_t Health_Init(void);
+int8_t Health_Register(const char* name, uint32_t budget_us, uint8_t flags);
+void Health_Begin(int8_t monitor);
+void Health_End(int8_t monitor);
+uint8_t Health_Count(void);
+const HealthMonitor_t* Health_Get(int8_t monitor);
+void Health_GetSystem(HealthSystem_t* system);
+int Health_FormatJSON(char* buffer, size_t size);
+void Health_PrintSummary(void);
+
+#endif /* HEALTH_MONITOR_H */
@@ -0,0 +1,65 @@
+/**
+ * @file heap_audit.h
+ * @brief Allocation audit: fail on heap use after initialization
+ * @version 1.0
+ * @date 2025-11-14
+ *
+ * The firmware allocates during setup only; from then on every buffer is
+ * static or on the stack, so weeks of uptime cannot fragment the heap.
+ * The audit build (env:esp32dev_heap_audit) links malloc, calloc,
+ * realloc and heap_caps_malloc/calloc/realloc (which FreeRTOS's
+ * pvPortMalloc uses) through wrappers. Once HeapAudit_Arm() has run, an
+ * allocation from a watched task prints its size and caller and aborts;
+ * the panic backtrace shows the call site.
+ *
+ * Not covered: the other heap_caps_ entry points (_default, _prefer,
+ * aligned_alloc) and calls made inside the IDF heap component itself,
+ * which --wrap cannot redirect.
+ *
+ * Library calls that allocate internally by design (WebServer request
+ * and header handling, lwIP sends, Bluedroid notifications, LittleFS
+ * files) are bracketed with HEAP_AUDIT_EXEMPT(). HEAP_AUDIT_STRICT()
+ * re-enables checking inside an exempt section, e.g. in a web handler
+ * called from WebServer::handleClient(). Tasks owned by WiFi, BT and
+ * lwIP are not watched.
+ *
+ * In normal builds HEAP_AUDIT is 0 and every macro compiles to nothing.
+ */
+
+#ifndef HEAP_AUDIT_H
+#define HEAP_AUDIT_H
+
+#include "common_types.h"
+
+#ifndef HEAP_AUDIT
+#define HEAP_AUDIT                  0
+#endif
+
+#define HEAP_AUDIT_MAX_TASKS        8
+
+#if HEAP_AUDIT
+/* Heap Audit Interface */
+void HeapAudit_WatchTask(void);
+void HeapAudit_Arm(void);
+
+/* Exempt (or strict) section for the rest of the enclosing block, calling task only */
+class HeapAuditScope {
+public:
+    explicit HeapAuditScope(bool exempt);
+    ~HeapAuditScope();
+private:
+    int8_t slot_;
+    uint8_t saved_depth_;
+};
+#define HEAP_AUDIT_WATCH()          HeapAudit_WatchTask()
+#define HEAP_AUDIT_ARM()            HeapAudit_Arm()
+#define HEAP_AUDIT_EXEMPT()         HeapAuditScope heap_audit_scope_(true)
+#define HEAP_AUDIT_STRICT()         HeapAuditScope heap_audit_scope_(false)
+#else
+#define HEAP_AUDIT_WATCH()          do {} while (0)
+#define HEAP_AUDIT_ARM()            do {} while (0)
+#define HEAP_AUDIT_EXEMPT()         do {} while (0)
+#define HEAP_AUDIT_STRICT()         do {} while (0)
+#endif
+
+#endif /* HEAP_AUDIT_H */
@@ -0,0 +1,47 @@
+/**
+ * @file latency_monitor.h
+ * @brief CAN-receive-to-output latency per sink
+ * @version 1.0
+ * @date 2025-11-12
+ *
+ * Acquired samples carry the micros() time their CAN frame was read from
+ * the controller (SignalStore_GetRxTime). When a sink delivers a sample
+ * for the first time, the age of that sample goes into the sink's
+ * histogram; later repeats of the same sample (full BLE refreshes, HTTP
+ * polls) are not counted again. Histograms are log2 with four linear
+ * sub-buckets per octave, so a percentile is within 25% of the true
+ * value, in fixed memory.
+ */
+
+#ifndef LATENCY_MONITOR_H
+#define LATENCY_MONITOR_H
+
+#include "common_types.h"
+#include "signal_store.h"
+
+#define LATENCY_BUCKETS             100     /* Up to 2^26 us (67 s); older samples land in the last */
+
+typedef enum {
+    LATENCY_SINK_BLE = 0,           /* BLE notify */
+    LATENCY_SINK_HTTP = 1,          /* /data response */
+    LATENCY_SINK_SERIAL = 2,        /* JSON written to the serial port */
+    LATENCY_SINK_DISPLAY = 3,       /* Display filter tick */
+    LATENCY_SINK_COUNT
+} LatencySink_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t buckets[LATENCY_BUCKETS];
+} LatencyHistogram_t;
+
+/* Latency Monitor Interface */
+void Latency_Init(void);
+void Latency_Record(uint8_t sink, uint32_t latency_us);
+void Latency_RecordSignal(uint8_t sink, SignalId_t id, uint32_t now_us);
+void Latency_RecordSink(uint8_t sink, uint32_t now_us);
+const LatencyHistogram_t* Latency_Get(uint8_t sink);
+uint32_t Latency_Percentile(const LatencyHistogram_t* histogram, float q);
+const char* Latency_SinkName(uint8_t sink);
+
+#endif /* LATENCY_MONITOR_H */
@@ -0,0 +1,99 @@
+/**
+ * @file logger.h
+ * @brief Deferred logging: capture a format pointer and raw arguments now,
+ *        format on the low-priority log task later
+ * @version 1.0
+ * @date 2025-11-13
+ *
+ * A LOG_* call costs one slot claim in a lock-free multi-producer ring
+ * and a copy of at most LOG_MAX_ARGS 32-bit words; it never blocks and
+ * is safe from any task or ISR. The log task formats and writes records
+ * to the serial port. When the ring is full new records are dropped and
+ * counted.
+ *
+ * Levels above LOG_LEVEL are removed at compile time, arguments and all.
+ * Log_SetLevel() filters further at run time.
+ *
+ * Arguments are captured by value as 32-bit words. Integers, enums and
+ * pointers are accepted; floating-point and 64-bit values fail to
+ * compile. A %s argument is formatted later, so it must point to storage
+ * that outlives the call (string literals, static tables).
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include <type_traits>
+#include "common_types.h"
+
+#define LOG_LEVEL_NONE              0
+#define LOG_LEVEL_ERROR             1
+#define LOG_LEVEL_WARN              2
+#define LOG_LEVEL_INFO              3
+#define LOG_LEVEL_DEBUG             4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL                   LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SIZE               64      /* Records, power of two */
+#define LOG_MAX_ARGS                6
+#define LOG_LINE_LENGTH             160
+
+/* Logger Interface */
+Status_t Log_Init(void);
+void Log_Write(uint8_t level, const char* format, const uint32_t* args, uint8_t arg_count);
+void Log_SetLevel(uint8_t level);
+uint8_t Log_GetLevel(void);
+uint32_t Log_GetDropped(void);
+void Log_LockOutput(void);
+bool Log_TryLockOutput(void);
+void Log_UnlockOutput(void);
+
+/* Run-time threshold; compile-time filtering happens in the macros below */
+extern volatile uint8_t log_runtime_level;
+
+template <typename T>
+static inline uint32_t Log_Arg(T value) {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "LOG_* arguments must be integers, enums or pointers");
+    static_assert(sizeof(T) <= sizeof(uintptr_t), "LOG_* arguments must fit one word (32 bits on the ESP32)");
+    return (uint32_t)(uintptr_t)value;
+}
+
+template <typename... Args>
+static inline void Log_Emit(uint8_t level, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many LOG_* arguments");
+    if (level > log_runtime_level) {
+        return;
+    }
+    const uint32_t values[] = { Log_Arg(args)..., 0 };
+    Log_Write(level, format, values, sizeof...(Args));
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...)              Log_Emit(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...)              do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...)               Log_Emit(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...)               do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...)               Log_Emit(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)               do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...)              Log_Emit(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)              do {} while (0)
+#endif
+
+#endif /* LOGGER_H */
@@ -0,0 +1,140 @@
+/**
+ * @file mcp2515_registers.h
+ * @brief MCP2515 SPI instructions, register map and bit definitions
+ * @details Names follow the Microchip MCP2515 datasheet (DS20001801)
+ * @version 1.0
+ * @date 2025-11-11
+ */
+
+#ifndef MCP2515_REGISTERS_H
+#define MCP2515_REGISTERS_H
+
+#include <stdint.h>
+
+/* SPI instructions */
+#define MCP_INSTR_RESET             0xC0
+#define MCP_INSTR_READ              0x03
+#define MCP_INSTR_WRITE             0x02
+#define MCP_INSTR_BIT_MODIFY        0x05
+#define MCP_INSTR_READ_STATUS       0xA0
+#define MCP_INSTR_RX_STATUS         0xB0
+#define MCP_INSTR_READ_RXB0         0x90    /* READ RX BUFFER from RXB0SIDH; clears RX0IF on CS high */
+#define MCP_INSTR_READ_RXB1         0x94    /* READ RX BUFFER from RXB1SIDH; clears RX1IF on CS high */
+#define MCP_INSTR_LOAD_TXB(n)       (0x40 + 2 * (n))    /* LOAD TX BUFFER n from TXBnSIDH */
+#define MCP_INSTR_RTS(n)            (0x80 | (1 << (n))) /* Request-to-send buffer n */
+
+/* Control and status registers */
+#define MCP_REG_RXF0SIDH            0x00
+#define MCP_REG_RXF1SIDH            0x04
+#define MCP_REG_RXF2SIDH            0x08
+#define MCP_REG_BFPCTRL             0x0C
+#define MCP_REG_TXRTSCTRL           0x0D
+#define MCP_REG_CANSTAT             0x0E
+#define MCP_REG_CANCTRL             0x0F
+#define MCP_REG_RXF3SIDH            0x10
+#define MCP_REG_RXF4SIDH            0x14
+#define MCP_REG_RXF5SIDH            0x18
+#define MCP_REG_TEC                 0x1C
+#define MCP_REG_REC                 0x1D
+#define MCP_REG_RXM0SIDH            0x20
+#define MCP_REG_RXM1SIDH            0x24
+#define MCP_REG_CNF3                0x28
+#define MCP_REG_CNF2                0x29
+#define MCP_REG_CNF1                0x2A
+#define MCP_REG_CANINTE             0x2B
+#define MCP_REG_CANINTF             0x2C
+#define MCP_REG_EFLG                0x2D
+#define MCP_REG_TXBCTRL(n)          (0x30 + 0x10 * (n))
+#define MCP_REG_RXB0CTRL            0x60
+#define MCP_REG_RXB1CTRL            0x70
+
+/* CANCTRL.REQOP / CANSTAT.OPMOD */
+#define MCP_MODE_MASK               0xE0
+#define MCP_MODE_NORMAL             0x00
+#define MCP_MODE_SLEEP              0x20
+#define MCP_MODE_LOOPBACK           0x40
+#define MCP_MODE_LISTEN_ONLY        0x60
+#define MCP_MODE_CONFIG             0x80
+#define MCP_CANCTRL_ABAT            0x10
+
+/* CANINTE / CANINTF */
+#define MCP_INT_RX0                 0x01
+#define MCP_INT_RX1                 0x02
+#define MCP_INT_TX0                 0x04
+#define MCP_INT_TX1                 0x08
+#define MCP_INT_TX2                 0x10
+#define MCP_INT_ERR                 0x20
+#define MCP_INT_WAKE                0x40
+#define MCP_INT_MERR                0x80
+
+/* EFLG */
+#define MCP_EFLG_EWARN              0x01
+#define MCP_EFLG_RXWAR              0x02
+#define MCP_EFLG_TXWAR              0x04
+#define MCP_EFLG_RXEP               0x08
+#define MCP_EFLG_TXEP               0x10
+#define MCP_EFLG_TXBO               0x20
+#define MCP_EFLG_RX0OVR             0x40
+#define MCP_EFLG_RX1OVR             0x80
+
+/* TXBnCTRL */
+#define MCP_TXB_TXREQ               0x08
+#define MCP_TXB_TXERR               0x10
+#define MCP_TXB_MLOA                0x20
+#define MCP_TXB_ABTF                0x40
+#define MCP_TXB_TXP_MASK            0x03
+
+/* RXBnCTRL */
+#define MCP_RXB_RXM_ANY             0x60    /* Filters off, receive all frames */
+#define MCP_RXB_RXM_FILTER          0x00    /* Receive frames matching the filters */
+#define MCP_RXB0_BUKT               0x04    /* Roll over into RXB1 when RXB0 is full */
+
+/* READ STATUS result */
+#define MCP_STATUS_RX0IF            0x01
+#define MCP_STATUS_RX1IF            0x02
+#define MCP_STATUS_TXREQ(n)         (0x04 << (2 * (n)))
+#define MCP_STATUS_TXIF(n)          (0x08 << (2 * (n)))
+
+/* RX STATUS result */
+#define MCP_RXSTAT_RXB0             0x40
+#define MCP_RXSTAT_RXB1             0x80
+
+/* ID and DLC bits in the buffer header (SIDH, SIDL, EID8, EID0, DLC) */
+#define MCP_SIDL_IDE                0x08    /* Extended identifier */
+#define MCP_SIDL_SRR                0x10    /* Standard remote request (receive only) */
+#define MCP_DLC_RTR                 0x40
+#define MCP_DLC_MASK                0x0F
+
+/* Outcome of a loaded TX buffer, decoded from TXBnCTRL */
+typedef enum {
+    MCP_TX_PENDING = 0,     /* Keep waiting */
+    MCP_TX_SENT,            /* On the bus; TXnIF was never drained */
+    MCP_TX_FAILED           /* Abort (if still requested) and report failure */
+} MCP_TxVerdict_t;
+
+/**
+ * @brief Decide what to do with a TX buffer that has not reported completion
+ * @details A buffer losing arbitration (MLOA) or waiting for the bus keeps
+ *          TXREQ set and is retried by the controller, so it only fails
+ *          once limit_us has passed. An error during transmission (TXERR)
+ *          or an abort (ABTF) fails at once. TXREQ clear without either
+ *          means the frame went out and its completion is still on the way
+ *          from the RX task; after limit_us it is taken as sent.
+ * @param txbctrl TXBnCTRL
+ * @param loaded_for_us Time since the buffer was loaded
+ * @param limit_us Longest a frame may wait for the bus
+ */
+static inline MCP_TxVerdict_t MCP_TxVerdict(uint8_t txbctrl, uint32_t loaded_for_us, uint32_t limit_us) {
+    if (txbctrl & MCP_TXB_ABTF) {
+        return MCP_TX_FAILED;
+    }
+    if (txbctrl & MCP_TXB_TXREQ) {
+        if (txbctrl & MCP_TXB_TXERR) {
+            return MCP_TX_FAILED;
+        }
+        return (loaded_for_us > limit_us) ? MCP_TX_FAILED : MCP_TX_PENDING;
+    }
+    return (loaded_for_us > limit_us) ? MCP_TX_SENT : MCP_TX_PENDING;
+}
+
+#endif /* MCP2515_REGISTERS_H */
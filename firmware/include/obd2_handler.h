@@ -9,6 +9,7 @@
 #define OBD2_HANDLER_H
 
 #include "common_types.h"
+#include "vehicle_profile.h"
 
 /* OBD2 Configuration */
 typedef struct {
@@ -18,6 +19,12 @@ typedef struct {
     uint32_t update_interval_ms;    /* Data update interval */
 } OBD2_Config_t;
 
+/* Response cache counters */
+typedef struct {
+    uint32_t hits;                  /* Served from memory inside the TTL */
+    uint32_t bus_requests;          /* Mode 01 requests sent */
+} OBD2_CacheStats_t;
+
 /* OBD2 Interface Functions */
 Status_t OBD2_Init(const OBD2_Config_t* config);
 Status_t OBD2_RegisterCallback(DataUpdateCallback_t callback);
@@ -28,4 +35,23 @@ Status_t OBD2_ReadCoolantTemp(int8_t* temp);
 Status_t OBD2_ReadThrottlePosition(uint8_t* throttle);
 const VehicleData_t* OBD2_GetVehicleData(void);
 
+/* Cached Mode 01 access; bus load does not grow with the number of readers */
+Status_t OBD2_QueryPID(uint8_t pid, uint8_t* data, uint8_t* length);
+Status_t OBD2_SetPIDTTL(uint8_t pid, uint16_t ttl_ms);
+void OBD2_GetCacheStats(OBD2_CacheStats_t* stats);
+Status_t OBD2_MeasurePID(uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us, uint32_t timeout_ms);
+
+/* Vehicle identification and profile selection */
+Status_t OBD2_ReadVIN(char* vin, size_t size);
+Status_t OBD2_DiscoverSupportedPIDs(uint32_t supported_pids[3]);
+Status_t OBD2_ApplyProfile(const VehicleProfile_t* profile);
+const VehicleProfile_t* OBD2_GetActiveProfile(void);
+Status_t OBD2_SetPIDPeriod(uint8_t pid, uint16_t period_ms);
+uint16_t OBD2_GetPIDPeriod(uint8_t pid);
+Status_t OBD2_SetupAddressing(uint8_t* ecu);
+
+/* Diagnostics (Mode 01 PID 01 / Mode 02) */
+Status_t OBD2_ReadMonitorStatus(bool* mil_on, uint8_t* dtc_count);
+Status_t OBD2_ReadFreezeFrame(uint8_t frame_number, FreezeFrame_t* frame);
+
 #endif /* OBD2_HANDLER_H */
@@ -0,0 +1,122 @@
+/**
+ * @file output_sinks.h
+ * @brief Output sinks as compile-time policies
+ * @version 1.0
+ * @date 2025-11-15
+ *
+ * A sink is a class with static begin() and service(now) and a constexpr
+ * ram_bytes for the static buffers it owns. ActiveSinks lists every sink
+ * through SinkIf<flag, Sink>, which turns a disabled sink into NullSink;
+ * SinkSet calls the remaining ones in order and adds up their RAM. The
+ * loop calls ActiveSinks::service() once per pass, so a disabled sink
+ * costs no code, no RAM and no branch.
+ *
+ * Sinks that are disabled must not be referenced outside this list;
+ * their definitions are compiled out with the same SINK_* flags.
+ */
+
+#ifndef OUTPUT_SINKS_H
+#define OUTPUT_SINKS_H
+
+#include <stddef.h>
+#include <type_traits>
+#include "common_types.h"
+#include "signal_store.h"
+#include "sink_config.h"
+
+/* Disabled sink: every call inlines to nothing */
+struct NullSink {
+    static constexpr size_t ram_bytes = 0;
+    static void begin(void) {}
+    static void service(uint32_t now) { (void)now; }
+};
+
+template <bool Enabled, typename Sink>
+using SinkIf = typename std::conditional<Enabled, Sink, NullSink>::type;
+
+/* Sinks called in list order */
+template <typename... Sinks>
+struct SinkSet;
+
+template <>
+struct SinkSet<> {
+    static constexpr size_t ram_bytes = 0;
+    static void begin(void) {}
+    static void service(uint32_t now) { (void)now; }
+};
+
+template <typename First, typename... Rest>
+struct SinkSet<First, Rest...> {
+    static constexpr size_t ram_bytes = First::ram_bytes + SinkSet<Rest...>::ram_bytes;
+
+    static void begin(void) {
+        First::begin();
+        SinkSet<Rest...>::begin();
+    }
+
+    static void service(uint32_t now) {
+        First::service(now);
+        SinkSet<Rest...>::service(now);
+    }
+};
+
+/* WiFi station and web server (dashboard, /data, /stats, /perf, /can, /trace, /health) */
+struct HttpSink {
+    static constexpr size_t ram_bytes = HTTP_RESPONSE_SIZE;
+    static void begin(void);
+    static void service(uint32_t now);
+};
+
+/* Smoothed values at display rate */
+struct DisplaySink {
+    static constexpr size_t ram_bytes = 0;      /* Filter state belongs to signal_filter */
+    static void begin(void);
+    static void service(uint32_t now) {}        /* Ticks in its own task */
+};
+
+/* BLE GATT server: signal deltas and system status */
+struct BleSink {
+    static constexpr size_t ram_bytes = BLE_SERVICE_RAM_SIZE;
+    static void begin(void);
+    static void service(uint32_t now);
+};
+
+/* Refreshed values as a JSON block for the desktop app and serial monitor */
+struct SerialJsonSink {
+    static constexpr size_t ram_bytes = SIGNAL_STORE_CAPACITY * sizeof(uint32_t);
+    static void begin(void) {}
+    static void service(uint32_t now);
+};
+
+/* Refreshed values as binary frames for headless logging (format in serial_sink.cpp) */
+struct SerialBinarySink {
+    static constexpr size_t ram_bytes = SERIAL_BINARY_FRAME_SIZE + SIGNAL_STORE_CAPACITY * (sizeof(uint32_t) + 1);
+    static void begin(void) {}
+    static void service(uint32_t now);
+};
+
+/* Core values through the logger */
+struct LogSink {
+    static constexpr size_t ram_bytes = 0;
+    static void begin(void) {}
+    static void service(uint32_t now);
+};
+
+typedef SinkSet<
+    SinkIf<SINK_HTTP, HttpSink>,
+    SinkIf<SINK_DISPLAY, DisplaySink>,
+    SinkIf<SINK_BLE, BleSink>,
+    SinkIf<SINK_SERIAL_JSON, SerialJsonSink>,
+    SinkIf<SINK_SERIAL_BINARY, SerialBinarySink>,
+    SinkIf<SINK_LOGGER, LogSink>
+> ActiveSinks;
+
+static_assert(ActiveSinks::ram_bytes <= SINK_RAM_BUDGET,
+              "Enabled sinks exceed SINK_RAM_BUDGET for this build");
+
+/* Application state the sinks report (main.cpp) */
+#define ALERT_MAX_ACTIVE 8
+extern SystemState_t current_state;
+extern VehicleData_t last_vehicle_data;
+
+#endif /* OUTPUT_SINKS_H */
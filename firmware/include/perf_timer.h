@@ -0,0 +1,84 @@
+/**
+ * @file perf_timer.h
+ * @brief Performance-run timer (0-100 km/h, 60-120 km/h, quarter mile)
+ * @version 1.0
+ * @date 2025-11-09
+ *
+ * While a run is armed or in progress the timer owns the bus: vehicle
+ * speed is requested back to back (or taken from a speed broadcast when
+ * the vehicle profile has one) and every sample is stamped with its CAN
+ * receive time. Start and finish are interpolated between the two samples
+ * around each threshold. Each result is stored on LittleFS together with
+ * its raw speed trace and the measured sample interval, which bounds the
+ * timing resolution of that run.
+ */
+
+#ifndef PERF_TIMER_H
+#define PERF_TIMER_H
+
+#include "common_types.h"
+
+/* Raw trace capacity (1024 samples = ~20 s at 50 Hz) */
+#define PERF_TRACE_SIZE             1024
+/* Result files kept on flash before the oldest is overwritten */
+#define PERF_MAX_FILES              8
+
+/* Run types */
+typedef enum {
+    PERF_RUN_0_100 = 0,             /* Standing start to 100 km/h */
+    PERF_RUN_60_120 = 1,            /* Roll-on 60 to 120 km/h */
+    PERF_RUN_QUARTER_MILE = 2       /* Standing start over 402.336 m */
+} PerfRunType_t;
+
+/* Timer state */
+typedef enum {
+    PERF_STATE_IDLE = 0,
+    PERF_STATE_ARMED = 1,           /* Waiting for the start threshold */
+    PERF_STATE_RUNNING = 2
+} PerfState_t;
+
+/* Speed source */
+typedef enum {
+    PERF_SOURCE_OBD2 = 0,           /* Mode 01 PID 0x0D polled back to back */
+    PERF_SOURCE_BROADCAST = 1       /* Speed broadcast from the vehicle profile */
+} PerfSource_t;
+
+/* Raw trace sample */
+typedef struct {
+    uint32_t time_us;               /* CAN receive time, micros() */
+    uint16_t speed_x100;            /* km/h x 100 */
+    uint16_t reserved;
+} PerfSample_t;
+
+/* Run result */
+typedef struct {
+    uint32_t run_index;
+    uint8_t type;                   /* PerfRunType_t */
+    uint8_t source;                 /* PerfSource_t */
+    bool valid;                     /* False if aborted (timeout, trace full) */
+    uint32_t elapsed_us;            /* Interpolated start to finish */
+    uint16_t finish_speed_x100;     /* Speed at the finish (trap speed for the quarter mile) */
+    uint32_t distance_mm;           /* Distance covered from start to finish */
+    uint16_t sample_count;
+    uint32_t mean_interval_us;      /* Measured sample interval = timing resolution */
+    uint32_t max_interval_us;       /* Largest gap between two samples */
+    uint16_t speed_step_x100;       /* Speed quantisation of the source */
+} PerfResult_t;
+
+/* On-flash result file header, followed by sample_count PerfSample_t */
+typedef struct {
+    char magic[4];                  /* "PRF1" */
+    PerfResult_t result;
+    uint32_t start_us;              /* Interpolated start time on the trace time base */
+} PerfFileHeader_t;
+
+/* Performance Timer Interface */
+Status_t Perf_Init(void);
+Status_t Perf_Start(PerfRunType_t type);
+void Perf_Cancel(void);
+bool Perf_Process(void);
+PerfState_t Perf_GetState(void);
+const PerfResult_t* Perf_GetLastResult(void);
+const char* Perf_RunName(uint8_t type);
+
+#endif /* PERF_TIMER_H */
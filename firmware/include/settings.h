@@ -0,0 +1,71 @@
+/**
+ * @file settings.h
+ * @brief Run-time settings: sink rates, poll periods, display filters, log level
+ * @version 1.0
+ * @date 2025-11-16
+ *
+ * Settings start from the compiled defaults and are replaced at boot by
+ * the copy saved in NVS, if one of the current version exists. Setters
+ * take effect immediately and may be called from any task: values read
+ * by the loop are single words, filter changes are handed to the filter
+ * module to apply at its next update. Settings_Save() stores the current
+ * values for the next boot; the flash write briefly stalls CAN reception.
+ * Filter changes need the display sink, which applies them.
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include "common_types.h"
+#include "vehicle_profile.h"
+#include "signal_filter.h"
+
+#define SETTINGS_NVS_NAMESPACE      "settings"
+#define SETTINGS_VERSION            1       /* A saved blob of another version is ignored */
+
+/* Sinks with a run-time output interval */
+typedef enum {
+    SETTINGS_RATE_BLE = 0,
+    SETTINGS_RATE_SERIAL_JSON = 1,
+    SETTINGS_RATE_SERIAL_BINARY = 2,
+    SETTINGS_RATE_LOGGER = 3,
+    SETTINGS_RATE_DISPLAY = 4,
+    SETTINGS_RATE_COUNT
+} SettingsRate_t;
+
+/* Display filter parameters of one slot (FilterConfig_t without the key) */
+typedef struct {
+    uint8_t median_window;
+    uint8_t smoother;               /* FilterSmoother_t */
+    uint8_t ema_alpha_q8;
+    bool extrapolate;
+    uint32_t kalman_q;
+    uint32_t kalman_r;
+} SettingsFilter_t;
+
+/* Everything saved to NVS, as one blob */
+typedef struct {
+    uint16_t version;
+    uint8_t log_level;
+    uint8_t pid_count;                              /* Entries used in pid_periods */
+    uint32_t sink_interval_ms[SETTINGS_RATE_COUNT]; /* 0 = sink paused */
+    ProfilePid_t pid_periods[PROFILE_MAX_PIDS];     /* Overrides of profile poll periods */
+    uint32_t filter_mask;                           /* Slots whose parameters are overridden */
+    SettingsFilter_t filters[FILTER_MAX_SIGNALS];
+} Settings_t;
+
+/* Settings Interface */
+Status_t Settings_Init(void);
+Status_t Settings_Save(void);
+void Settings_Reset(void);
+const Settings_t* Settings_Get(void);
+uint32_t Settings_GetSinkInterval(uint8_t rate);
+Status_t Settings_SetSinkInterval(uint8_t rate, uint32_t interval_ms);
+Status_t Settings_SetPIDPeriod(uint8_t pid, uint16_t period_ms);
+void Settings_ApplyPIDPeriods(void);
+Status_t Settings_SetFilter(uint8_t slot, const SettingsFilter_t* filter);
+void Settings_SetLogLevel(uint8_t level);
+const char* Settings_RateName(uint8_t rate);
+bool Settings_RateAvailable(uint8_t rate);
+
+#endif /* SETTINGS_H */
@@ -0,0 +1,58 @@
+/**
+ * @file signal_filter.h
+ * @brief Display-rate smoothing and interpolation of acquired signals
+ * @version 1.0
+ * @date 2025-11-10
+ *
+ * Each filtered signal passes new acquisition samples through an optional
+ * median (3 or 5 samples) and an EMA or scalar Kalman smoother, all in
+ * fixed point (Q8 of the signal's store units). Filter_Tick() then renders
+ * a display value at any rate: it ramps from the value on screen to the
+ * newest filtered value, or to one sample period ahead of it when linear
+ * extrapolation is enabled, over the measured sample period. The output
+ * is continuous between bus samples and a tick is a few integer
+ * operations per signal.
+ */
+
+#ifndef SIGNAL_FILTER_H
+#define SIGNAL_FILTER_H
+
+#include "common_types.h"
+#include "signal_store.h"
+
+#define FILTER_MAX_SIGNALS          8
+#define FILTER_MAX_MEDIAN           5
+
+/* Smoother applied after the median */
+typedef enum {
+    FILTER_SMOOTH_NONE = 0,
+    FILTER_SMOOTH_EMA = 1,
+    FILTER_SMOOTH_KALMAN = 2
+} FilterSmoother_t;
+
+/* Per-signal filter configuration */
+typedef struct {
+    const char* key;                /* Signal store key */
+    uint8_t median_window;          /* 0 = off, 3 or 5 */
+    uint8_t smoother;               /* FilterSmoother_t */
+    uint8_t ema_alpha_q8;           /* EMA weight of a new sample, x/256 */
+    uint32_t kalman_q;              /* Process noise per sample, store units^2 */
+    uint32_t kalman_r;              /* Measurement noise, store units^2 */
+    bool extrapolate;               /* Lead the display by one sample period */
+} FilterConfig_t;
+
+/* Signal Filter Interface */
+Status_t Filter_Init(const FilterConfig_t* configs, uint8_t count);
+Status_t Filter_SetConfig(uint8_t slot, const FilterConfig_t* config);
+const FilterConfig_t* Filter_GetConfig(uint8_t slot);
+Status_t Filter_GetLatestConfig(uint8_t slot, FilterConfig_t* config);
+void Filter_Update(void);
+void Filter_Tick(uint32_t now);
+uint8_t Filter_Count(void);
+SignalId_t Filter_GetSignal(uint8_t slot);
+int32_t Filter_GetDisplayQ8(uint8_t slot);
+int32_t Filter_GetDisplay(uint8_t slot);
+bool Filter_IsValid(uint8_t slot);
+uint32_t Filter_GetMaxTickUs(void);
+
+#endif /* SIGNAL_FILTER_H */
@@ -0,0 +1,73 @@
+/**
+ * @file signal_stats.h
+ * @brief Per-signal streaming statistics
+ * @version 1.0
+ * @date 2025-11-08
+ *
+ * For each tracked signal: Welford mean/variance over the session,
+ * exponentially weighted mean/variance (baseline for z-scores), a smoothed
+ * trend in units per minute and a small merging t-digest for percentiles.
+ * All state is fixed-size; cost per sample is bounded by the t-digest
+ * merge of TDIGEST_CENTROIDS + TDIGEST_BUFFER points every TDIGEST_BUFFER
+ * samples.
+ */
+
+#ifndef SIGNAL_STATS_H
+#define SIGNAL_STATS_H
+
+#include "common_types.h"
+#include "signal_store.h"
+
+#define STATS_MAX_TRACKED           8
+#define TDIGEST_CENTROIDS           32
+#define TDIGEST_BUFFER              16
+#define TDIGEST_COMPRESSION         25.0f
+
+/* t-digest centroid */
+typedef struct {
+    float mean;
+    float weight;
+} TDigestCentroid_t;
+
+/* Merging t-digest with a fixed centroid budget */
+typedef struct {
+    TDigestCentroid_t centroids[TDIGEST_CENTROIDS];
+    uint8_t count;
+    float buffer[TDIGEST_BUFFER];
+    uint8_t buffered;
+    float total_weight;
+    float min;
+    float max;
+} TDigest_t;
+
+/* Statistics of one tracked signal */
+typedef struct {
+    SignalId_t signal;
+    SignalId_t trend_signal;        /* Published "<key>_trend" or SIGNAL_ID_INVALID */
+    uint32_t last_timestamp;        /* Capture time of the last sample taken */
+    uint32_t count;
+    float mean;                     /* Welford */
+    float m2;
+    float ewma;                     /* Exponentially weighted mean/variance */
+    float ewm_var;
+    float alpha;
+    float trend_per_min;            /* Smoothed slope of ewma, units per minute */
+    float last_value;
+    float last_z;                   /* z-score of last_value against the prior baseline */
+    TDigest_t digest;
+} SignalStats_t;
+
+/* Streaming Statistics Interface */
+Status_t Stats_Init(void);
+int8_t Stats_Track(const char* key, float ewma_alpha, bool publish_trend);
+void Stats_Update(void);
+uint8_t Stats_Count(void);
+const SignalStats_t* Stats_Get(uint8_t slot);
+const SignalStats_t* Stats_Find(SignalId_t signal);
+float Stats_Variance(const SignalStats_t* stats);
+
+void TDigest_Reset(TDigest_t* digest);
+void TDigest_Add(TDigest_t* digest, float value);
+float TDigest_Quantile(TDigest_t* digest, float q);
+
+#endif /* SIGNAL_STATS_H */
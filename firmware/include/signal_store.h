@@ -0,0 +1,66 @@
+/**
+ * @file signal_store.h
+ * @brief Fixed-capacity signal registry stored as parallel arrays
+ * @version 1.0
+ * @date 2025-11-06
+ *
+ * Every acquired or derived value lives here: signal ID -> value,
+ * capture timestamp, CAN receive time, quality, key, unit and scale. Values are fixed point
+ * (physical value = raw / scale, scale 1, 10, 100...; other scales are rejected). The built-in vehicle signals are
+ * registered first, so their IDs equal VehicleSignal_t; VehicleData_t is
+ * filled from the store as a view for existing consumers.
+ *
+ * Encoders iterate IDs 0..SignalStore_Count()-1, so adding a signal needs
+ * no serialization changes.
+ *
+ * Samples are written by the loop task. Readers in other tasks use
+ * SignalStore_GetSample(), which copies value, times and quality together.
+ */
+
+#ifndef SIGNAL_STORE_H
+#define SIGNAL_STORE_H
+
+#include <stddef.h>
+#include "common_types.h"
+
+#define SIGNAL_STORE_CAPACITY       64
+#define SIGNAL_ID_INVALID           0xFF
+
+typedef uint8_t SignalId_t;
+
+/* One consistent copy of a signal's sample */
+typedef struct {
+    int32_t raw;
+    uint32_t timestamp;
+    uint32_t rx_time_us;
+    uint8_t quality;
+} SignalSample_t;
+
+/* Signal Store Interface */
+Status_t SignalStore_Init(void);
+SignalId_t SignalStore_Register(const char* key, const char* label, const char* unit, uint16_t scale, uint32_t stale_ms);
+SignalId_t SignalStore_Find(const char* key);
+uint8_t SignalStore_Count(void);
+
+void SignalStore_Set(SignalId_t id, int32_t raw, uint32_t timestamp);
+void SignalStore_SetSample(SignalId_t id, int32_t raw, uint32_t timestamp, uint32_t rx_time_us);
+void SignalStore_MarkFailed(SignalId_t id);
+void SignalStore_SetStaleLimit(SignalId_t id, uint32_t stale_ms);
+void SignalStore_AgeOut(uint32_t now);
+
+int32_t SignalStore_GetRaw(SignalId_t id);
+uint32_t SignalStore_GetTimestamp(SignalId_t id);
+uint32_t SignalStore_GetRxTime(SignalId_t id);
+uint8_t SignalStore_GetQuality(SignalId_t id);
+bool SignalStore_GetSample(SignalId_t id, SignalSample_t* sample);
+const char* SignalStore_GetKey(SignalId_t id);
+const char* SignalStore_GetLabel(SignalId_t id);
+const char* SignalStore_GetUnit(SignalId_t id);
+uint16_t SignalStore_GetScale(SignalId_t id);
+
+int SignalStore_FormatValue(SignalId_t id, char* buffer, size_t size);
+int SignalStore_FormatRaw(SignalId_t id, int32_t raw, char* buffer, size_t size);
+const char* SignalStore_QualityName(uint8_t quality);
+void SignalStore_FillVehicleData(VehicleData_t* view);
+
+#endif /* SIGNAL_STORE_H */
@@ -0,0 +1,60 @@
+/**
+ * @file sink_config.h
+ * @brief Compile-time selection of output sinks
+ * @version 1.0
+ * @date 2025-11-15
+ *
+ * Each sink is enabled with a SINK_* flag (0 or 1), normally set per
+ * PlatformIO environment. A disabled sink is not compiled at all: its
+ * source files, library includes and static buffers drop out of the
+ * build. SINK_HTTP also owns WiFi, so a build without it contains no
+ * WiFi code; SINK_BLE likewise for Bluetooth.
+ *
+ * SINK_RAM_BUDGET bounds the static buffers of the enabled sinks; the
+ * build fails when the sum exceeds it (see output_sinks.h).
+ */
+
+#ifndef SINK_CONFIG_H
+#define SINK_CONFIG_H
+
+#ifndef SINK_BLE
+#define SINK_BLE                    1       /* BLE notifications to the desktop app */
+#endif
+#ifndef SINK_HTTP
+#define SINK_HTTP                   1       /* WiFi and the web dashboard/API */
+#endif
+#ifndef SINK_SERIAL_JSON
+#define SINK_SERIAL_JSON            1       /* JSON blocks on the USB serial port */
+#endif
+#ifndef SINK_SERIAL_BINARY
+#define SINK_SERIAL_BINARY          0       /* Framed binary samples on the USB serial port */
+#endif
+#ifndef SINK_LOGGER
+#define SINK_LOGGER                 1       /* Periodic core values as LOG_INFO lines */
+#endif
+#ifndef SINK_DISPLAY
+#define SINK_DISPLAY                1       /* Display-rate filter ticks */
+#endif
+
+#if SINK_SERIAL_JSON && SINK_SERIAL_BINARY
+#error "SINK_SERIAL_JSON and SINK_SERIAL_BINARY share the serial port; enable one"
+#endif
+
+/* Default sink output intervals (ms); changed at run time through settings.h */
+#define SINK_BLE_INTERVAL_MS        200
+#define SINK_SERIAL_JSON_INTERVAL_MS 1000
+#define SINK_SERIAL_BINARY_INTERVAL_MS 200
+#define SINK_LOGGER_INTERVAL_MS     1000
+#define SINK_DISPLAY_INTERVAL_MS    16      /* ~60 Hz */
+
+/* Sink buffers */
+#define HTTP_RESPONSE_SIZE          8192    /* /data with every signal is the largest response */
+#define BLE_SERVICE_RAM_SIZE        2048    /* OBD2BLEService: notification chunks and delta state */
+#define SERIAL_BINARY_FRAME_SIZE    528     /* Header, 64 records of 8 bytes, checksum */
+
+/* Static RAM allowed for the enabled sinks' buffers */
+#ifndef SINK_RAM_BUDGET
+#define SINK_RAM_BUDGET             12288
+#endif
+
+#endif /* SINK_CONFIG_H */
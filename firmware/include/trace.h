@@ -0,0 +1,109 @@
+/**
+ * @file trace.h
+ * @brief Hot-path event tracing into per-core ring buffers
+ * @version 1.0
+ * @date 2025-11-12
+ *
+ * Each record is 12 bytes: CPU cycle count, event ID, phase and one
+ * argument. Every core writes its own ring; a slot is claimed with an
+ * atomic increment, so tasks and ISRs on the same core can trace without
+ * a lock. The oldest records are overwritten. A sync record pairing the
+ * cycle count with esp_timer microseconds is written at least every
+ * TRACE_SYNC_INTERVAL_MS per core so the host can align both cores and
+ * unwrap the 32-bit cycle counter.
+ *
+ * Build with -DTRACE_ENABLED=0 to compile every TRACE_* macro out.
+ * tools/trace_to_chrome.py converts a dump to Chrome trace-event JSON.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include "common_types.h"
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED               1
+#endif
+
+#define TRACE_RING_SIZE             512     /* Records per core, power of two */
+#define TRACE_CORES                 2
+#define TRACE_SYNC_INTERVAL_MS      250     /* Well inside the 17.9 s cycle counter wrap at 240 MHz */
+
+/* Event IDs; names are in trace.cpp and written into every dump */
+typedef enum {
+    TRACE_EV_SYNC = 0,              /* arg: esp_timer microseconds (low 32 bits) */
+    TRACE_EV_CAN_IRQ,               /* MCP2515 INT edge */
+    TRACE_EV_CAN_DRAIN,             /* RX task reading the controller; arg: frames read */
+    TRACE_EV_CAN_RECEIVE,           /* Consumer taking frames from the queue; arg: frames taken */
+    TRACE_EV_OBD_POLL,              /* OBD2_ReadAllData cycle; arg: PIDs read */
+    TRACE_EV_OBD_BROADCAST,         /* Broadcast decode; arg: frames */
+    TRACE_EV_OBD_DECODE,            /* One PID response decoded; arg: PID */
+    TRACE_EV_DATA_CALLBACK,         /* Vehicle data callback */
+    TRACE_EV_BLE_SEND,              /* BLE vehicle data notify; arg: payload bytes */
+    TRACE_EV_HTTP_REQUEST,          /* Web server handler; arg: TraceHttpRoute_t */
+    TRACE_EV_COUNT
+} TraceEventId_t;
+
+typedef enum {
+    TRACE_PHASE_BEGIN = 0,
+    TRACE_PHASE_END = 1,
+    TRACE_PHASE_INSTANT = 2
+} TracePhase_t;
+
+/* TRACE_EV_HTTP_REQUEST argument */
+typedef enum {
+    TRACE_HTTP_ROOT = 0,
+    TRACE_HTTP_DATA,
+    TRACE_HTTP_STATS,
+    TRACE_HTTP_PERF,
+    TRACE_HTTP_CAN,
+    TRACE_HTTP_TRACE
+} TraceHttpRoute_t;
+
+typedef struct {
+    uint32_t cycles;                /* CCOUNT of the writing core */
+    uint32_t arg;
+    uint16_t event;                 /* TraceEventId_t */
+    uint8_t phase;                  /* TracePhase_t */
+    uint8_t reserved;
+} TraceRecord_t;
+
+/* Receives dump text; context is passed through from Trace_Dump() */
+typedef void (*TraceWriter_t)(const char* text, size_t length, void* context);
+
+/* Tracing Interface */
+void Trace_Record(uint16_t event, uint8_t phase, uint32_t arg);
+void Trace_SetEnabled(bool enabled);
+bool Trace_IsEnabled(void);
+void Trace_Clear(void);
+void Trace_Dump(TraceWriter_t writer, void* context);
+const char* Trace_EventName(uint16_t event);
+
+#if TRACE_ENABLED
+#define TRACE_BEGIN(event, arg)     Trace_Record((event), TRACE_PHASE_BEGIN, (uint32_t)(arg))
+#define TRACE_END(event, arg)       Trace_Record((event), TRACE_PHASE_END, (uint32_t)(arg))
+#define TRACE_INSTANT(event, arg)   Trace_Record((event), TRACE_PHASE_INSTANT, (uint32_t)(arg))
+
+/* Begin/end pair around the rest of the enclosing block */
+class TraceScope {
+public:
+    TraceScope(uint16_t event, uint32_t arg) : event_(event), arg_(arg) {
+        Trace_Record(event, TRACE_PHASE_BEGIN, arg);
+    }
+    ~TraceScope() {
+        Trace_Record(event_, TRACE_PHASE_END, arg_);
+    }
+private:
+    uint16_t event_;
+    uint32_t arg_;
+};
+#define TRACE_SCOPE(event, arg)     TraceScope trace_scope_((event), (uint32_t)(arg))
+#else
+#define TRACE_BEGIN(event, arg)     do {} while (0)
+#define TRACE_END(event, arg)       do {} while (0)
+#define TRACE_INSTANT(event, arg)   do {} while (0)
+#define TRACE_SCOPE(event, arg)     do {} while (0)
+#endif
+
+#endif /* TRACE_H */
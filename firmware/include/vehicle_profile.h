@@ -0,0 +1,60 @@
+/**
+ * @file vehicle_profile.h
+ * @brief Vehicle profiles selected from the VIN at connect
+ * @version 1.0
+ * @date 2025-11-04
+ *
+ * A profile describes which Mode 01 PIDs a bike answers, how often each
+ * one is polled, and which passively broadcast CAN signals it carries.
+ * Known profiles are compiled into flash; an unknown VIN falls back to
+ * a generic profile built from the ECU's supported-PID bitmaps, or to
+ * the default profile if the bitmaps list no PID the handler decodes.
+ */
+
+#ifndef VEHICLE_PROFILE_H
+#define VEHICLE_PROFILE_H
+
+#include "common_types.h"
+
+#define PROFILE_MAX_PIDS            16
+#define PROFILE_MAX_GEARS           6
+
+/* Polled PID and its scheduler period */
+typedef struct {
+    uint8_t pid;                    /* Mode 01 PID */
+    uint16_t period_ms;             /* Poll period */
+} ProfilePid_t;
+
+/* Passively broadcast signal, decoded as the equivalent Mode 01 PID value:
+ * value = raw * scale_num / scale_den + offset */
+typedef struct {
+    uint32_t can_id;                /* Broadcast ID; 29-bit IDs | CAN_ID_EXTENDED_FLAG */
+    uint8_t start_byte;             /* First payload byte (big-endian) */
+    uint8_t length;                 /* 1 or 2 bytes */
+    uint8_t pid;                    /* PID whose value the signal replaces */
+    int16_t scale_num;
+    int16_t scale_den;
+    int16_t offset;
+} ProfileBroadcast_t;
+
+/* Vehicle profile */
+typedef struct {
+    const char* name;
+    const char* vin_pattern;        /* VIN prefix, '?' matches any character */
+    uint32_t supported_pids[3];     /* Mode 01 bitmaps for PIDs 01-20, 21-40, 41-60 */
+    const ProfilePid_t* pids;
+    uint8_t pid_count;
+    const ProfileBroadcast_t* broadcasts;
+    uint8_t broadcast_count;
+    uint16_t displacement_cc;       /* Engine displacement (fuel flow estimate) */
+    uint8_t gear_count;             /* 0 = unknown, derived gear is disabled */
+    uint16_t gear_ratio_x10[PROFILE_MAX_GEARS]; /* Nominal rpm per km/h x10, 1st gear first */
+} VehicleProfile_t;
+
+/* Vehicle Profile Interface */
+const VehicleProfile_t* Profile_FindByVIN(const char* vin);
+const VehicleProfile_t* Profile_GetDefault(void);
+const VehicleProfile_t* Profile_BuildGeneric(const uint32_t supported_pids[3]);
+bool Profile_IsPIDSupported(const uint32_t supported_pids[3], uint8_t pid);
+
+#endif /* VEHICLE_PROFILE_H */
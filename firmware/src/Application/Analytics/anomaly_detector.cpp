@@ -0,0 +1,133 @@
+/**
+ * @file anomaly_detector.cpp
+ * @brief Anomaly detection - Application layer
+ * @version 1.0
+ * @date 2025-11-08
+ */
+
+#include <Arduino.h>
+#include "anomaly_detector.h"
+#include "signal_stats.h"
+
+static const AnomalyRule_t* anomaly_rules = nullptr;
+static uint8_t rule_count = 0;
+static SignalId_t rule_signal[ANOMALY_MAX_RULES];
+static uint32_t condition_since[ANOMALY_MAX_RULES];    /* 0 = condition not holding */
+static uint32_t active_mask = 0;
+static uint32_t change_count = 0;
+
+/* Quantity the rule compares; false if it cannot be evaluated now */
+static bool Anomaly_Measure(const AnomalyRule_t* rule, SignalId_t signal, float* measure) {
+    if (SignalStore_GetQuality(signal) != SIGNAL_QUALITY_VALID) {
+        return false;
+    }
+
+    float value = (float)SignalStore_GetRaw(signal) / SignalStore_GetScale(signal);
+    if (value < rule->gate_min) {
+        return false;
+    }
+
+    const SignalStats_t* stats = Stats_Find(signal);
+    switch (rule->type) {
+        case ANOMALY_ABOVE:
+        case ANOMALY_BELOW:
+            *measure = value;
+            return true;
+        case ANOMALY_ZSCORE:
+            if (stats == nullptr) {
+                return false;
+            }
+            *measure = fabsf(stats->last_z);
+            return true;
+        case ANOMALY_TREND_ABOVE:
+            if (stats == nullptr) {
+                return false;
+            }
+            *measure = stats->trend_per_min;
+            return true;
+        default:
+            return false;
+    }
+}
+
+Status_t Anomaly_Init(const AnomalyRule_t* rules, uint8_t count) {
+    if ((rules == nullptr && count > 0) || count > ANOMALY_MAX_RULES) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    anomaly_rules = rules;
+    rule_count = count;
+    active_mask = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        rule_signal[i] = SignalStore_Find(rules[i].signal_key);
+        condition_since[i] = 0;
+        if (rule_signal[i] == SIGNAL_ID_INVALID) {
+            return STATUS_INVALID_PARAM;
+        }
+    }
+
+    return STATUS_OK;
+}
+
+void Anomaly_Evaluate(uint32_t now) {
+    uint32_t previous_mask = active_mask;
+
+    for (uint8_t i = 0; i < rule_count; i++) {
+        const AnomalyRule_t* rule = &anomaly_rules[i];
+        uint32_t bit = 1UL << i;
+        float measure;
+
+        if (!Anomaly_Measure(rule, rule_signal[i], &measure)) {
+            // Gated off or no data: the condition can no longer be confirmed
+            condition_since[i] = 0;
+            active_mask &= ~bit;
+            continue;
+        }
+
+        bool below_rule = (rule->type == ANOMALY_BELOW);
+        bool raise = below_rule ? (measure < rule->threshold) : (measure > rule->threshold);
+        bool clear = below_rule ? (measure > rule->clear_threshold) : (measure < rule->clear_threshold);
+
+        if (active_mask & bit) {
+            if (clear) {
+                active_mask &= ~bit;
+            }
+            continue;
+        }
+
+        if (!raise) {
+            condition_since[i] = 0;
+        } else if (condition_since[i] == 0) {
+            condition_since[i] = now | 1;   // 0 is reserved for "not holding"
+            if (rule->hold_ms == 0) {
+                active_mask |= bit;
+            }
+        } else if ((now - condition_since[i]) >= rule->hold_ms) {
+            active_mask |= bit;
+        }
+    }
+
+    if (active_mask != previous_mask) {
+        change_count++;
+    }
+}
+
+uint32_t Anomaly_GetActiveMask(void) {
+    return active_mask;
+}
+
+uint8_t Anomaly_GetActiveNames(const char** names, uint8_t max_names) {
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < rule_count && count < max_names; i++) {
+        if (active_mask & (1UL << i)) {
+            names[count++] = anomaly_rules[i].name;
+        }
+    }
+    return count;
+}
+
+uint32_t Anomaly_GetChangeCount(void) {
+    return change_count;
+}
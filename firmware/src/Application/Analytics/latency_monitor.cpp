@@ -0,0 +1,111 @@
+/**
+ * @file latency_monitor.cpp
+ * @brief CAN-receive-to-output latency - Application layer
+ * @version 1.0
+ * @date 2025-11-12
+ */
+
+#include <Arduino.h>
+#include "latency_monitor.h"
+
+static LatencyHistogram_t histograms[LATENCY_SINK_COUNT];
+
+/* Receive time of the last sample each sink delivered, per signal */
+static uint32_t delivered_rx_us[LATENCY_SINK_COUNT][SIGNAL_STORE_CAPACITY];
+
+static const char* const sink_names[LATENCY_SINK_COUNT] = {
+    "ble",
+    "http",
+    "serial",
+    "display"
+};
+
+/* Values 0-3 map to themselves; above that, 4 buckets per power of two */
+static uint8_t Latency_Bucket(uint32_t us) {
+    if (us < 4) {
+        return us;
+    }
+    uint8_t msb = 31 - __builtin_clz(us);
+    uint32_t bucket = 4 * (msb - 1) + ((us >> (msb - 2)) & 3);
+    return (bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS - 1;
+}
+
+/* Smallest value that falls in a bucket */
+static uint32_t Latency_BucketLow(uint8_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    uint8_t msb = bucket / 4 + 1;
+    return (uint32_t)(4 + bucket % 4) << (msb - 2);
+}
+
+void Latency_Init(void) {
+    memset(histograms, 0, sizeof(histograms));
+    memset(delivered_rx_us, 0, sizeof(delivered_rx_us));
+}
+
+void Latency_Record(uint8_t sink, uint32_t latency_us) {
+    if (sink >= LATENCY_SINK_COUNT) {
+        return;
+    }
+    LatencyHistogram_t* h = &histograms[sink];
+    h->buckets[Latency_Bucket(latency_us)]++;
+    h->count++;
+    if (latency_us > h->max_us) {
+        h->max_us = latency_us;
+    }
+}
+
+/* Count one signal's sample if this sink has not delivered it before */
+void Latency_RecordSignal(uint8_t sink, SignalId_t id, uint32_t now_us) {
+    SignalSample_t sample;
+    if (sink >= LATENCY_SINK_COUNT || id >= SIGNAL_STORE_CAPACITY ||
+        !SignalStore_GetSample(id, &sample) || sample.quality != SIGNAL_QUALITY_VALID) {
+        return;
+    }
+
+    // 0: computed on the ESP32 rather than received from the bus
+    uint32_t rx_us = sample.rx_time_us;
+    if (rx_us == 0 || rx_us == delivered_rx_us[sink][id]) {
+        return;
+    }
+    delivered_rx_us[sink][id] = rx_us;
+    Latency_Record(sink, now_us - rx_us);
+}
+
+/* Count every signal in the store that is new to this sink */
+void Latency_RecordSink(uint8_t sink, uint32_t now_us) {
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        Latency_RecordSignal(sink, id, now_us);
+    }
+}
+
+const LatencyHistogram_t* Latency_Get(uint8_t sink) {
+    return (sink < LATENCY_SINK_COUNT) ? &histograms[sink] : nullptr;
+}
+
+/* Value at quantile q, interpolated inside its bucket and capped at the maximum seen */
+uint32_t Latency_Percentile(const LatencyHistogram_t* histogram, float q) {
+    if (histogram == nullptr || histogram->count == 0) {
+        return 0;
+    }
+
+    float rank = q * histogram->count;
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        uint32_t n = histogram->buckets[i];
+        if (n == 0 || cumulative + n < rank) {
+            cumulative += n;
+            continue;
+        }
+        uint32_t low = Latency_BucketLow(i);
+        uint32_t high = (i + 1 < LATENCY_BUCKETS) ? Latency_BucketLow(i + 1) : histogram->max_us;
+        uint32_t value = low + (uint32_t)((high - low) * ((rank - cumulative) / n));
+        return (value < histogram->max_us) ? value : histogram->max_us;
+    }
+    return histogram->max_us;
+}
+
+const char* Latency_SinkName(uint8_t sink) {
+    return (sink < LATENCY_SINK_COUNT) ? sink_names[sink] : "unknown";
+}
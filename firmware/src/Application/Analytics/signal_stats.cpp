@@ -0,0 +1,239 @@
+/**
+ * @file signal_stats.cpp
+ * @brief Streaming statistics - Application layer
+ * @version 1.0
+ * @date 2025-11-08
+ */
+
+#include <Arduino.h>
+#include "signal_stats.h"
+
+#define STATS_TREND_ALPHA           0.1f
+#define STATS_TREND_STALE_MS        3000
+
+static SignalStats_t stats[STATS_MAX_TRACKED];
+static uint8_t stats_count = 0;
+static char trend_keys[STATS_MAX_TRACKED][24];
+
+/* ---------------------------------------------------------------------------
+ * t-digest
+ * ------------------------------------------------------------------------- */
+
+void TDigest_Reset(TDigest_t* digest) {
+    digest->count = 0;
+    digest->buffered = 0;
+    digest->total_weight = 0.0f;
+    digest->min = 0.0f;
+    digest->max = 0.0f;
+}
+
+/* Fold the buffered points into the centroid list */
+static void TDigest_Merge(TDigest_t* digest) {
+    if (digest->buffered == 0) {
+        return;
+    }
+
+    TDigestCentroid_t merged[TDIGEST_CENTROIDS + TDIGEST_BUFFER];
+    uint8_t n = digest->count;
+    memcpy(merged, digest->centroids, n * sizeof(TDigestCentroid_t));
+
+    // Centroids are sorted; insertion sort the few new points into place
+    for (uint8_t i = 0; i < digest->buffered; i++) {
+        float value = digest->buffer[i];
+        uint8_t j = n++;
+        while (j > 0 && merged[j - 1].mean > value) {
+            merged[j] = merged[j - 1];
+            j--;
+        }
+        merged[j].mean = value;
+        merged[j].weight = 1.0f;
+    }
+
+    float total = digest->total_weight + digest->buffered;
+    float cumulative = 0.0f;
+    uint8_t out = 0;
+    digest->centroids[0] = merged[0];
+
+    for (uint8_t i = 1; i < n; i++) {
+        TDigestCentroid_t* current = &digest->centroids[out];
+        float q = (cumulative + current->weight / 2.0f) / total;
+        float limit = 4.0f * total * q * (1.0f - q) / TDIGEST_COMPRESSION;
+
+        if (current->weight + merged[i].weight <= limit || out == TDIGEST_CENTROIDS - 1) {
+            float weight = current->weight + merged[i].weight;
+            current->mean += (merged[i].mean - current->mean) * merged[i].weight / weight;
+            current->weight = weight;
+        } else {
+            cumulative += current->weight;
+            digest->centroids[++out] = merged[i];
+        }
+    }
+
+    digest->count = out + 1;
+    digest->total_weight = total;
+    digest->buffered = 0;
+}
+
+void TDigest_Add(TDigest_t* digest, float value) {
+    if (digest->total_weight == 0.0f && digest->buffered == 0) {
+        digest->min = value;
+        digest->max = value;
+    }
+    if (value < digest->min) {
+        digest->min = value;
+    }
+    if (value > digest->max) {
+        digest->max = value;
+    }
+
+    digest->buffer[digest->buffered++] = value;
+    if (digest->buffered == TDIGEST_BUFFER) {
+        TDigest_Merge(digest);
+    }
+}
+
+float TDigest_Quantile(TDigest_t* digest, float q) {
+    TDigest_Merge(digest);
+
+    if (digest->count == 0) {
+        return 0.0f;
+    }
+    if (q <= 0.0f) {
+        return digest->min;
+    }
+    if (q >= 1.0f) {
+        return digest->max;
+    }
+
+    // Interpolate between centroid centres by cumulative weight
+    float target = q * digest->total_weight;
+    float cumulative = 0.0f;
+    float previous_center = 0.0f;
+    float previous_mean = digest->min;
+
+    for (uint8_t i = 0; i < digest->count; i++) {
+        const TDigestCentroid_t* c = &digest->centroids[i];
+        float center = cumulative + c->weight / 2.0f;
+
+        if (target < center) {
+            float span = center - previous_center;
+            float fraction = (span > 0.0f) ? (target - previous_center) / span : 0.0f;
+            return previous_mean + fraction * (c->mean - previous_mean);
+        }
+
+        cumulative += c->weight;
+        previous_center = center;
+        previous_mean = c->mean;
+    }
+
+    float span = digest->total_weight - previous_center;
+    float fraction = (span > 0.0f) ? (target - previous_center) / span : 1.0f;
+    return previous_mean + fraction * (digest->max - previous_mean);
+}
+
+/* ---------------------------------------------------------------------------
+ * Per-signal statistics
+ * ------------------------------------------------------------------------- */
+
+static void Stats_AddSample(SignalStats_t* s, float value, uint32_t timestamp) {
+    float previous_ewma = s->ewma;
+    uint32_t dt = timestamp - s->last_timestamp;
+
+    // Score against the baseline before it absorbs this sample
+    float sigma = sqrtf(s->ewm_var);
+    s->last_z = (s->count > 1 && sigma > 1e-3f) ? (value - s->ewma) / sigma : 0.0f;
+
+    // Welford
+    s->count++;
+    float delta = value - s->mean;
+    s->mean += delta / s->count;
+    s->m2 += delta * (value - s->mean);
+
+    // Exponentially weighted mean and variance
+    if (s->count == 1) {
+        s->ewma = value;
+        s->ewm_var = 0.0f;
+    } else {
+        float diff = value - s->ewma;
+        float increment = s->alpha * diff;
+        s->ewma += increment;
+        s->ewm_var = (1.0f - s->alpha) * (s->ewm_var + diff * increment);
+
+        if (dt > 0) {
+            float slope = (s->ewma - previous_ewma) * 60000.0f / dt;
+            s->trend_per_min += STATS_TREND_ALPHA * (slope - s->trend_per_min);
+        }
+    }
+
+    s->last_value = value;
+    s->last_timestamp = timestamp;
+    TDigest_Add(&s->digest, value);
+
+    if (s->trend_signal != SIGNAL_ID_INVALID) {
+        SignalStore_Set(s->trend_signal, (int32_t)(s->trend_per_min * 10.0f), timestamp);
+    }
+}
+
+Status_t Stats_Init(void) {
+    stats_count = 0;
+    return STATUS_OK;
+}
+
+int8_t Stats_Track(const char* key, float ewma_alpha, bool publish_trend) {
+    SignalId_t signal = SignalStore_Find(key);
+    if (signal == SIGNAL_ID_INVALID || stats_count >= STATS_MAX_TRACKED || ewma_alpha <= 0.0f || ewma_alpha > 1.0f) {
+        return -1;
+    }
+
+    uint8_t slot = stats_count++;
+    SignalStats_t* s = &stats[slot];
+    memset(s, 0, sizeof(*s));
+    s->signal = signal;
+    s->alpha = ewma_alpha;
+    s->trend_signal = SIGNAL_ID_INVALID;
+    TDigest_Reset(&s->digest);
+
+    if (publish_trend) {
+        snprintf(trend_keys[slot], sizeof(trend_keys[slot]), "%s_trend", key);
+        s->trend_signal = SignalStore_Register(trend_keys[slot], trend_keys[slot], "/min", 10, STATS_TREND_STALE_MS);
+    }
+
+    return (int8_t)slot;
+}
+
+void Stats_Update(void) {
+    for (uint8_t i = 0; i < stats_count; i++) {
+        SignalStats_t* s = &stats[i];
+        uint32_t timestamp = SignalStore_GetTimestamp(s->signal);
+
+        // Only fresh values that have not been sampled yet
+        if (SignalStore_GetQuality(s->signal) != SIGNAL_QUALITY_VALID ||
+            (s->count > 0 && timestamp == s->last_timestamp)) {
+            continue;
+        }
+
+        float value = (float)SignalStore_GetRaw(s->signal) / SignalStore_GetScale(s->signal);
+        Stats_AddSample(s, value, timestamp);
+    }
+}
+
+uint8_t Stats_Count(void) {
+    return stats_count;
+}
+
+const SignalStats_t* Stats_Get(uint8_t slot) {
+    return (slot < stats_count) ? &stats[slot] : nullptr;
+}
+
+const SignalStats_t* Stats_Find(SignalId_t signal) {
+    for (uint8_t i = 0; i < stats_count; i++) {
+        if (stats[i].signal == signal) {
+            return &stats[i];
+        }
+    }
+    return nullptr;
+}
+
+float Stats_Variance(const SignalStats_t* s) {
+    return (s != nullptr && s->count > 1) ? s->m2 / (s->count - 1) : 0.0f;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file event_capture.cpp
+ * @brief Pre/post-trigger event capture - Application layer
+ * @version 1.0
+ * @date 2025-11-03
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "event_capture.h"
+#include "heap_audit.h"
+
+#define CAPTURE_DIR                 "/capture"
+#define CAPTURE_COOLANT_HYSTERESIS  5       /* C below the limit before re-arming */
+#define CAPTURE_WRITER_STACK        4096
+#define CAPTURE_WRITER_PRIORITY     1       /* Below the Arduino loop task */
+
+typedef enum {
+    CAPTURE_STATE_IDLE = 0,
+    CAPTURE_STATE_POST_TRIGGER = 1
+} CaptureState_t;
+
+static CaptureConfig_t capture_config;
+static bool capture_initialized = false;
+
+/* Rolling ring, written only from the acquisition context */
+static CaptureSample_t ring[CAPTURE_RING_SIZE];
+static uint16_t ring_head = 0;             /* Next slot to write */
+static uint16_t ring_count = 0;
+
+static CaptureState_t state = CAPTURE_STATE_IDLE;
+static CaptureFileHeader_t pending_header;
+
+/* Frozen event handed over to the writer task */
+static CaptureSample_t snapshot[CAPTURE_RING_SIZE];
+static CaptureFileHeader_t snapshot_header;
+static volatile bool snapshot_busy = false;
+static SemaphoreHandle_t snapshot_ready = nullptr;
+
+static uint32_t event_count = 0;
+static uint32_t dropped_count = 0;
+static bool coolant_armed = true;
+static bool have_previous = false;
+static uint16_t previous_rpm = 0;
+
+static void Capture_WriterTask(void* param) {
+    char path[32];
+    HEAP_AUDIT_WATCH();
+
+    for (;;) {
+        if (xSemaphoreTake(snapshot_ready, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), CAPTURE_DIR "/evt_%02u.bin",
+                 (unsigned)(snapshot_header.event_index % CAPTURE_MAX_FILES));
+
+        {
+            HEAP_AUDIT_EXEMPT();    // File handles are allocated and freed by LittleFS within this block
+            File file = LittleFS.open(path, FILE_WRITE);
+            if (file) {
+                file.write((const uint8_t*)&snapshot_header, sizeof(snapshot_header));
+                file.write((const uint8_t*)snapshot, snapshot_header.sample_count * sizeof(CaptureSample_t));
+                file.close();
+            } else {
+                dropped_count++;
+            }
+        }
+
+        snapshot_busy = false;
+    }
+}
+
+/* Copy the trigger window out of the ring and wake the writer */
+static void Capture_Freeze(void) {
+    uint32_t window_start = pending_header.trigger_time - capture_config.pre_trigger_ms;
+    uint16_t count = 0;
+
+    // Walk back from the newest sample until the pre-trigger window is covered
+    while (count < ring_count) {
+        uint16_t idx = (ring_head + CAPTURE_RING_SIZE - 1 - count) % CAPTURE_RING_SIZE;
+        if ((int32_t)(ring[idx].timestamp - window_start) < 0) {
+            break;
+        }
+        count++;
+    }
+
+    uint16_t first = (ring_head + CAPTURE_RING_SIZE - count) % CAPTURE_RING_SIZE;
+    uint16_t tail = CAPTURE_RING_SIZE - first;
+    if (count <= tail) {
+        memcpy(snapshot, &ring[first], count * sizeof(CaptureSample_t));
+    } else {
+        memcpy(snapshot, &ring[first], tail * sizeof(CaptureSample_t));
+        memcpy(&snapshot[tail], ring, (count - tail) * sizeof(CaptureSample_t));
+    }
+
+    snapshot_header = pending_header;
+    snapshot_header.sample_count = count;
+    snapshot_busy = true;
+    state = CAPTURE_STATE_IDLE;
+
+    xSemaphoreGive(snapshot_ready);
+}
+
+Status_t Capture_Init(const CaptureConfig_t* config) {
+    if (config == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    capture_config = *config;
+
+    if (!LittleFS.begin(true)) {
+        return STATUS_ERROR;
+    }
+    if (!LittleFS.exists(CAPTURE_DIR)) {
+        LittleFS.mkdir(CAPTURE_DIR);
+    }
+
+    snapshot_ready = xSemaphoreCreateBinary();
+    if (snapshot_ready == nullptr) {
+        return STATUS_ERROR;
+    }
+
+    if (xTaskCreatePinnedToCore(Capture_WriterTask, "capture_wr", CAPTURE_WRITER_STACK,
+                                nullptr, CAPTURE_WRITER_PRIORITY, nullptr, tskNO_AFFINITY) != pdPASS) {
+        return STATUS_ERROR;
+    }
+
+    capture_initialized = true;
+    return STATUS_OK;
+}
+
+void Capture_AddSample(const VehicleData_t* data) {
+    if (!capture_initialized || data == nullptr) {
+        return;
+    }
+
+    CaptureSample_t* sample = &ring[ring_head];
+    sample->timestamp = data->lastUpdate;
+    sample->rpm = data->rpm;
+    sample->speed = data->speed;
+    sample->coolantTemp = data->coolantTemp;
+    sample->throttlePosition = data->throttlePosition;
+
+    ring_head = (ring_head + 1) % CAPTURE_RING_SIZE;
+    if (ring_count < CAPTURE_RING_SIZE) {
+        ring_count++;
+    }
+
+    // Built-in triggers
+    if (data->coolantTemp >= capture_config.coolant_limit_c) {
+        if (coolant_armed) {
+            coolant_armed = false;
+            Capture_Trigger(CAPTURE_TRIGGER_COOLANT, nullptr);
+        }
+    } else if (data->coolantTemp < capture_config.coolant_limit_c - CAPTURE_COOLANT_HYSTERESIS) {
+        coolant_armed = true;
+    }
+
+    if (have_previous && capture_config.rpm_spike_delta > 0) {
+        uint16_t delta = (data->rpm > previous_rpm) ? (data->rpm - previous_rpm) : (previous_rpm - data->rpm);
+        if (delta >= capture_config.rpm_spike_delta) {
+            Capture_Trigger(CAPTURE_TRIGGER_RPM_SPIKE, nullptr);
+        }
+    }
+    previous_rpm = data->rpm;
+    have_previous = true;
+
+    // Close the window once enough post-trigger samples are in the ring
+    if (state == CAPTURE_STATE_POST_TRIGGER &&
+        (sample->timestamp - pending_header.trigger_time) >= capture_config.post_trigger_ms) {
+        Capture_Freeze();
+    }
+}
+
+Status_t Capture_Trigger(CaptureTrigger_t trigger, const FreezeFrame_t* freeze_frame) {
+    if (!capture_initialized) {
+        return STATUS_NOT_INITIALIZED;
+    }
+
+    // One window at a time; the writer must have released the snapshot too
+    if (state != CAPTURE_STATE_IDLE || snapshot_busy) {
+        dropped_count++;
+        return STATUS_BUSY;
+    }
+
+    memset(&pending_header, 0, sizeof(pending_header));
+    pending_header.magic = CAPTURE_FILE_MAGIC;
+    pending_header.event_index = event_count++;
+    // Windows are measured on the sample time base, not the call time
+    pending_header.trigger_time = (ring_count > 0)
+        ? ring[(ring_head + CAPTURE_RING_SIZE - 1) % CAPTURE_RING_SIZE].timestamp
+        : millis();
+    pending_header.trigger = (uint8_t)trigger;
+    if (freeze_frame != nullptr) {
+        pending_header.freeze_frame = *freeze_frame;
+    }
+
+    state = CAPTURE_STATE_POST_TRIGGER;
+    return STATUS_OK;
+}
+
+bool Capture_IsBusy(void) {
+    return state != CAPTURE_STATE_IDLE || snapshot_busy;
+}
+
+uint32_t Capture_GetEventCount(void) {
+    return event_count;
+}
+
+uint32_t Capture_GetDroppedCount(void) {
+    return dropped_count;
+}
@@ -0,0 +1,370 @@
+/**
+ * @file console.cpp
+ * @brief Serial command console - Application layer
+ * @version 1.0
+ * @date 2025-11-16
+ */
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "console.h"
+#include "settings.h"
+#include "signal_store.h"
+#include "signal_filter.h"
+#include "obd2_handler.h"
+#include "can_interface.h"
+#include "latency_monitor.h"
+#include "health_monitor.h"
+#include "trace.h"
+#include "logger.h"
+#include "heap_audit.h"
+
+#define CONSOLE_TASK_STACK          4096
+#define CONSOLE_TASK_PRIORITY       1       /* Same as the log task, below acquisition */
+#define CONSOLE_POLL_MS             20
+#define CONSOLE_MAX_TOKENS          6
+
+static TaskHandle_t console_task = nullptr;
+
+static const char* const smoother_names[] = { "none", "ema", "kalman" };
+
+static const char help_text[] =
+    "get                              settings\n"
+    "set rate <sink> <ms>             sink interval, 0 pauses (ble json binary log display)\n"
+    "set pid <hex> <ms>               poll period of a profile PID, 0 = profile default\n"
+    "set filter <key> median <0|3|5>\n"
+    "set filter <key> ema <1-255>     smoother weight of a new sample, x/256\n"
+    "set filter <key> kalman <q> <r>\n"
+    "set filter <key> none|default\n"
+    "set filter <key> extrapolate <0|1>\n"
+    "log <0-4>                        log level\n"
+    "save                             store settings in NVS (CAN reception stalls briefly)\n"
+    "defaults                         compiled settings (save to keep)\n"
+    "metrics                          latency, CAN, OBD2 cache, heap\n"
+    "health                           task timing and stack\n"
+    "trace [clear]                    trace rings\n"
+    "canids [clear]                   per-ID receive table\n";
+
+// Print::printf would allocate for long lines; the caller holds the output lock
+static void console_printf(const char* format, ...) {
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (length > (int)sizeof(line) - 1) {
+        length = sizeof(line) - 1;
+    }
+    if (length > 0) {
+        Serial.write((const uint8_t*)line, length);
+    }
+}
+
+static void trace_serial_writer(const char* text, size_t length, void* context) {
+    Serial.write((const uint8_t*)text, length);
+}
+
+static bool parse_number(const char* text, uint32_t* value, int base) {
+    if (text == nullptr || *text == '\0') {
+        return false;
+    }
+    char* end;
+    *value = strtoul(text, &end, base);
+    return *end == '\0';
+}
+
+static int8_t find_filter_slot(const char* key) {
+    for (uint8_t slot = 0; slot < Filter_Count(); slot++) {
+        if (strcmp(SignalStore_GetKey(Filter_GetSignal(slot)), key) == 0) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+static void print_settings(void) {
+    const Settings_t* s = Settings_Get();
+
+    console_printf("log %u (compiled max %u)\n", Log_GetLevel(), LOG_LEVEL);
+    for (uint8_t rate = 0; rate < SETTINGS_RATE_COUNT; rate++) {
+        if (!Settings_RateAvailable(rate)) {
+            console_printf("rate %-8s not in this build\n", Settings_RateName(rate));
+        } else if (s->sink_interval_ms[rate] == 0) {
+            console_printf("rate %-8s paused\n", Settings_RateName(rate));
+        } else {
+            console_printf("rate %-8s %lu ms\n", Settings_RateName(rate), (unsigned long)s->sink_interval_ms[rate]);
+        }
+    }
+
+    const VehicleProfile_t* profile = OBD2_GetActiveProfile();
+    if (profile != nullptr) {
+        for (uint8_t i = 0; i < profile->pid_count; i++) {
+            uint16_t period = OBD2_GetPIDPeriod(profile->pids[i].pid);
+            console_printf("pid %02X %u ms%s\n", profile->pids[i].pid, period,
+                           (period != profile->pids[i].period_ms) ? " (set)" : "");
+        }
+    }
+
+    for (uint8_t slot = 0; slot < Filter_Count(); slot++) {
+        FilterConfig_t f;
+        Filter_GetLatestConfig(slot, &f);
+        console_printf("filter %s: median %u, %s, alpha %u, q %lu, r %lu, extrapolate %u%s\n",
+                       f.key, f.median_window, smoother_names[f.smoother <= FILTER_SMOOTH_KALMAN ? f.smoother : 0],
+                       f.ema_alpha_q8, (unsigned long)f.kalman_q, (unsigned long)f.kalman_r, f.extrapolate,
+                       (s->filter_mask & (1UL << slot)) ? " (set)" : "");
+    }
+}
+
+static void print_metrics(void) {
+    HealthSystem_t system;
+    Health_GetSystem(&system);
+    console_printf("up %lu s, heap %lu free (min %lu, largest %lu), %lu overruns, %lu stalls, log dropped %lu\n",
+                   (unsigned long)system.uptime_s, (unsigned long)system.heap_free,
+                   (unsigned long)system.heap_min_free, (unsigned long)system.heap_largest_block,
+                   (unsigned long)system.overruns, (unsigned long)system.stalls, (unsigned long)Log_GetDropped());
+
+    for (uint8_t sink = 0; sink < LATENCY_SINK_COUNT; sink++) {
+        const LatencyHistogram_t* h = Latency_Get(sink);
+        console_printf("latency %-8s %lu samples, p50 %lu us, p99 %lu us, max %lu us\n",
+                       Latency_SinkName(sink), (unsigned long)h->count,
+                       (unsigned long)Latency_Percentile(h, 0.5f), (unsigned long)Latency_Percentile(h, 0.99f),
+                       (unsigned long)h->max_us);
+    }
+
+    CAN_RxStats_t rx;
+    CAN_GetRxStats(&rx);
+    console_printf("can rx %lu frames, %lu hw overflows, %lu queue overflows, queue high water %u, burst %u\n",
+                   (unsigned long)rx.frames, (unsigned long)rx.hw_overflows, (unsigned long)rx.queue_overflows,
+                   rx.queue_high_water, rx.max_burst);
+
+    CAN_TxStats_t tx;
+    CAN_GetTxStats(&tx);
+    console_printf("can tx %lu queued, %lu sent, %lu failed, %lu queue full, max latency %lu us\n",
+                   (unsigned long)tx.queued, (unsigned long)tx.sent, (unsigned long)tx.failed,
+                   (unsigned long)tx.queue_full, (unsigned long)tx.max_latency_us);
+
+    CAN_ErrorStats_t err;
+    CAN_GetErrorStats(&err);
+    console_printf("can %s, tec %u rec %u, %lu bus-off recoveries (max %lu ms)\n",
+                   CAN_ErrorStateName(err.state), rx.tec, rx.rec, (unsigned long)err.recoveries,
+                   (unsigned long)err.max_recovery_ms);
+
+    OBD2_CacheStats_t cache;
+    OBD2_GetCacheStats(&cache);
+    console_printf("obd2 cache %lu hits, %lu bus requests\n",
+                   (unsigned long)cache.hits, (unsigned long)cache.bus_requests);
+
+    console_printf("display tick max %lu us\n", (unsigned long)Filter_GetMaxTickUs());
+}
+
+static void print_can_ids(void) {
+    CAN_IdStats_t table[CAN_ID_STATS_SIZE];
+    uint32_t untracked = 0;
+    uint8_t count = CAN_GetIdStats(table, CAN_ID_STATS_SIZE, &untracked);
+
+    // Ascending ID; the table is small
+    for (uint8_t i = 1; i < count; i++) {
+        CAN_IdStats_t entry = table[i];
+        uint8_t j = i;
+        while (j > 0 && table[j - 1].key > entry.key) {
+            table[j] = table[j - 1];
+            j--;
+        }
+        table[j] = entry;
+    }
+
+    uint32_t now = micros();
+    console_printf("id        frames     min ms   max ms  dlc  age ms\n");
+    for (uint8_t i = 0; i < count; i++) {
+        const CAN_IdStats_t* s = &table[i];
+        bool extended = (s->key & CAN_ID_EXTENDED_FLAG) != 0;
+        bool periodic = s->frames > 1;
+        console_printf(extended ? "%08lX %7lu  %8lu %8lu  %3u %7lu\n" : "%03lX      %7lu  %8lu %8lu  %3u %7lu\n",
+                       (unsigned long)(s->key & ~CAN_ID_EXTENDED_FLAG), (unsigned long)s->frames,
+                       periodic ? (unsigned long)(s->min_period_us / 1000) : 0UL,
+                       periodic ? (unsigned long)(s->max_period_us / 1000) : 0UL,
+                       s->length, (unsigned long)((now - s->last_us) / 1000));
+    }
+    console_printf("%u IDs, %lu frames of untracked IDs\n", count, (unsigned long)untracked);
+}
+
+// "set filter <key> <param> [value] [value]", starting after "filter"
+static bool set_filter(char** tokens, uint8_t count) {
+    int8_t slot = (count >= 2) ? find_filter_slot(tokens[0]) : -1;
+    if (slot < 0) {
+        return false;
+    }
+    if (strcmp(tokens[1], "default") == 0) {
+        return Settings_SetFilter(slot, nullptr) == STATUS_OK;
+    }
+
+    // Start from the last change, which the display sink may not have applied yet
+    FilterConfig_t current;
+    Filter_GetLatestConfig(slot, &current);
+    SettingsFilter_t filter = {
+        current.median_window, current.smoother, current.ema_alpha_q8,
+        current.extrapolate, current.kalman_q, current.kalman_r
+    };
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    if (strcmp(tokens[1], "none") == 0) {
+        filter.smoother = FILTER_SMOOTH_NONE;
+    } else if (strcmp(tokens[1], "median") == 0 && count == 3 && parse_number(tokens[2], &a, 10) &&
+               (a == 0 || a == 3 || a == 5)) {
+        filter.median_window = a;
+    } else if (strcmp(tokens[1], "ema") == 0 && count == 3 && parse_number(tokens[2], &a, 10) && a >= 1 && a <= 255) {
+        filter.smoother = FILTER_SMOOTH_EMA;
+        filter.ema_alpha_q8 = a;
+    } else if (strcmp(tokens[1], "kalman") == 0 && count == 4 && parse_number(tokens[2], &a, 10) &&
+               parse_number(tokens[3], &b, 10)) {
+        filter.smoother = FILTER_SMOOTH_KALMAN;
+        filter.kalman_q = a;
+        filter.kalman_r = b;
+    } else if (strcmp(tokens[1], "extrapolate") == 0 && count == 3 && parse_number(tokens[2], &a, 10) && a <= 1) {
+        filter.extrapolate = (a == 1);
+    } else {
+        return false;
+    }
+    return Settings_SetFilter(slot, &filter) == STATUS_OK;
+}
+
+static bool set_command(char** tokens, uint8_t count) {
+    uint32_t value;
+    uint32_t pid;
+
+    if (count == 3 && strcmp(tokens[0], "rate") == 0 && parse_number(tokens[2], &value, 10)) {
+        for (uint8_t rate = 0; rate < SETTINGS_RATE_COUNT; rate++) {
+            if (strcmp(tokens[1], Settings_RateName(rate)) == 0) {
+                return Settings_SetSinkInterval(rate, value) == STATUS_OK;
+            }
+        }
+        return false;
+    }
+    if (count == 3 && strcmp(tokens[0], "pid") == 0 && parse_number(tokens[1], &pid, 16) && pid <= 0xFF &&
+        parse_number(tokens[2], &value, 10) && value <= 0xFFFF) {
+        return Settings_SetPIDPeriod(pid, value) == STATUS_OK;
+    }
+    if (count >= 1 && strcmp(tokens[0], "filter") == 0) {
+        return set_filter(tokens + 1, count - 1);
+    }
+    return false;
+}
+
+static void execute(char* line) {
+    char* tokens[CONSOLE_MAX_TOKENS];
+    uint8_t count = 0;
+    char* save = nullptr;
+    for (char* token = strtok_r(line, " \t", &save); token != nullptr && count < CONSOLE_MAX_TOKENS;
+         token = strtok_r(nullptr, " \t", &save)) {
+        tokens[count++] = token;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    const char* command = tokens[0];
+    bool has_clear = (count == 2 && strcmp(tokens[1], "clear") == 0);
+    bool ok = true;
+
+    // NVS and the trace clear print nothing long; everything else holds the port while printing
+    if (strcmp(command, "save") == 0 && count == 1) {
+        Status_t status = Settings_Save();
+        Log_LockOutput();
+        Serial.println(status == STATUS_OK ? "Settings saved" : "Settings not saved (NVS)");
+        Log_UnlockOutput();
+        return;
+    }
+
+    Log_LockOutput();
+    if (strcmp(command, "help") == 0 && count == 1) {
+        Serial.print(help_text);
+    } else if (strcmp(command, "get") == 0 && count == 1) {
+        print_settings();
+    } else if (strcmp(command, "set") == 0) {
+        ok = set_command(tokens + 1, count - 1);
+        if (ok) {
+            Serial.println("ok");
+        }
+    } else if (strcmp(command, "defaults") == 0 && count == 1) {
+        Settings_Reset();
+        Serial.println("Compiled defaults restored; save to keep them");
+    } else if (strcmp(command, "log") == 0 && count == 2 && tokens[1][0] >= '0' && tokens[1][0] <= '4' &&
+               tokens[1][1] == '\0') {
+        Settings_SetLogLevel(tokens[1][0] - '0');
+        console_printf("Log level %u (max %u), %lu dropped\n",
+                       Log_GetLevel(), LOG_LEVEL, (unsigned long)Log_GetDropped());
+    } else if (strcmp(command, "metrics") == 0 && count == 1) {
+        print_metrics();
+    } else if (strcmp(command, "health") == 0 && count == 1) {
+        Log_UnlockOutput();     // Takes the lock itself
+        Health_PrintSummary();
+        return;
+    } else if (strcmp(command, "trace") == 0 && count == 1) {
+        Trace_Dump(trace_serial_writer, nullptr);
+    } else if (strcmp(command, "trace") == 0 && has_clear) {
+        Trace_Clear();
+        Serial.println("Trace cleared");
+    } else if (strcmp(command, "canids") == 0 && count == 1) {
+        print_can_ids();
+    } else if (strcmp(command, "canids") == 0 && has_clear) {
+        CAN_ClearIdStats();
+        Serial.println("CAN ID table cleared");
+    } else {
+        ok = false;
+    }
+    if (!ok) {
+        Serial.println("? (help lists the commands)");
+    }
+    Log_UnlockOutput();
+}
+
+static void Console_Task(void* param) {
+    static char line[CONSOLE_LINE_LENGTH];
+    uint8_t length = 0;
+    bool overflow = false;
+    Health_Register("console", 0, HEALTH_FLAG_TASK);     // Stack watermark only; dumps have no budget
+    HEAP_AUDIT_WATCH();
+
+    for (;;) {
+        while (Serial.available()) {
+            char c = Serial.read();
+            if (c != '\n' && c != '\r') {
+                if (length < sizeof(line) - 1) {
+                    line[length++] = c;
+                } else {
+                    overflow = true;
+                }
+                continue;
+            }
+            line[length] = '\0';
+            if (overflow) {
+                Log_LockOutput();
+                Serial.println("? (line too long)");
+                Log_UnlockOutput();
+            } else {
+                execute(line);
+            }
+            length = 0;
+            overflow = false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONSOLE_POLL_MS));
+    }
+}
+
+/**
+ * @brief Start the console task
+ * @return STATUS_OK, STATUS_ERROR if the task could not be created
+ */
+Status_t Console_Init(void) {
+    if (console_task != nullptr) {
+        return STATUS_OK;
+    }
+    if (xTaskCreatePinnedToCore(Console_Task, "console", CONSOLE_TASK_STACK, nullptr,
+                                CONSOLE_TASK_PRIORITY, &console_task, tskNO_AFFINITY) != pdPASS) {
+        console_task = nullptr;
+        return STATUS_ERROR;
+    }
+    return STATUS_OK;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file derived_metrics.cpp
+ * @brief Derived metrics engine - Application layer
+ * @version 1.0
+ * @date 2025-11-07
+ */
+
+#include <Arduino.h>
+#include "derived_metrics.h"
+#include "signal_store.h"
+
+#define DERIVED_MAX_GAP_MS          2000    /* Longer sample gaps are not integrated */
+#define DERIVED_STALE_MS            3000
+#define GEAR_MIN_SPEED_KMH          10
+#define GEAR_MIN_RPM                1500
+#define GEAR_MATCH_PCT              12      /* Max distance to a centroid */
+#define GEAR_DRIFT_PCT              15      /* Max centroid drift from nominal */
+#define GEAR_CONFIRM_SAMPLES        2       /* Consecutive matches before a shift is published */
+#define GEAR_LEARN_SHIFT            5       /* Centroid learning rate 1/32 */
+
+static DerivedConfig_t derived_config;
+static bool derived_initialized = false;
+
+/* Profile data */
+static uint16_t displacement_cc = 0;
+static uint8_t gear_count = 0;
+static uint16_t gear_nominal_x10[PROFILE_MAX_GEARS];
+static int32_t gear_centroid_x10[PROFILE_MAX_GEARS];
+
+/* Incremental state */
+static uint8_t current_gear = 0;
+static uint8_t candidate_gear = 0;
+static uint8_t candidate_hits = 0;
+static uint32_t last_sample_time = 0;
+static uint32_t last_speed_time = 0;
+static uint8_t last_speed = 0;
+static uint64_t distance_mm = 0;
+static uint64_t fuel_ul = 0;
+static uint32_t band_ms[DERIVED_RPM_BANDS];
+
+/* Published signals */
+static SignalId_t id_gear = SIGNAL_ID_INVALID;
+static SignalId_t id_trip_distance = SIGNAL_ID_INVALID;
+static SignalId_t id_fuel_flow = SIGNAL_ID_INVALID;
+static SignalId_t id_fuel_used = SIGNAL_ID_INVALID;
+static SignalId_t id_fuel_economy = SIGNAL_ID_INVALID;
+static SignalId_t id_band[DERIVED_RPM_BANDS];
+static char band_keys[DERIVED_RPM_BANDS][16];
+static char band_labels[DERIVED_RPM_BANDS][24];
+
+/* Nearest gear centroid for an rpm/speed ratio; 0 if none is close enough */
+static uint8_t Derived_ClassifyGear(int32_t ratio_x10) {
+    uint8_t best = 0;
+    int32_t best_error = INT32_MAX;
+
+    for (uint8_t i = 0; i < gear_count; i++) {
+        int32_t error = abs(ratio_x10 - gear_centroid_x10[i]);
+        if (error < best_error) {
+            best_error = error;
+            best = i + 1;
+        }
+    }
+
+    if (best == 0 || best_error * 100 > gear_centroid_x10[best - 1] * GEAR_MATCH_PCT) {
+        return 0;
+    }
+
+    // Online k-means step, bounded around the nominal ratio
+    int32_t* centroid = &gear_centroid_x10[best - 1];
+    int32_t nominal = gear_nominal_x10[best - 1];
+    *centroid += (ratio_x10 - *centroid) >> GEAR_LEARN_SHIFT;
+    *centroid = constrain(*centroid, nominal * (100 - GEAR_DRIFT_PCT) / 100, nominal * (100 + GEAR_DRIFT_PCT) / 100);
+
+    return best;
+}
+
+static void Derived_UpdateGear(uint16_t rpm, uint8_t speed, bool speed_valid) {
+    uint8_t gear = 0;
+
+    // Clutch pulled or stopped looks like neutral
+    if (speed_valid && speed >= GEAR_MIN_SPEED_KMH && rpm >= GEAR_MIN_RPM) {
+        gear = Derived_ClassifyGear((int32_t)rpm * 10 / speed);
+    }
+
+    if (gear == candidate_gear) {
+        if (candidate_hits < GEAR_CONFIRM_SAMPLES) {
+            candidate_hits++;
+        }
+    } else {
+        candidate_gear = gear;
+        candidate_hits = 1;
+    }
+
+    if (candidate_hits >= GEAR_CONFIRM_SAMPLES) {
+        current_gear = candidate_gear;
+    }
+}
+
+Status_t Derived_Init(const DerivedConfig_t* config, const VehicleProfile_t* profile) {
+    if (config == nullptr || profile == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    derived_config = *config;
+    displacement_cc = profile->displacement_cc;
+    gear_count = (profile->gear_count <= PROFILE_MAX_GEARS) ? profile->gear_count : 0;
+    for (uint8_t i = 0; i < gear_count; i++) {
+        gear_nominal_x10[i] = profile->gear_ratio_x10[i];
+        gear_centroid_x10[i] = profile->gear_ratio_x10[i];
+    }
+
+    // Register once; a later profile change only swaps the calibration
+    if (!derived_initialized) {
+        id_gear = SignalStore_Register("gear", "Gear", "", 1, DERIVED_STALE_MS);
+        id_trip_distance = SignalStore_Register("trip_distance", "Trip", "km", 1000, DERIVED_STALE_MS);
+        id_fuel_flow = SignalStore_Register("fuel_flow", "Fuel flow (est.)", "L/h", 100, DERIVED_STALE_MS);
+        id_fuel_used = SignalStore_Register("fuel_used", "Fuel used (est.)", "L", 1000, DERIVED_STALE_MS);
+        id_fuel_economy = SignalStore_Register("fuel_economy", "Economy (est.)", "L/100km", 10, DERIVED_STALE_MS);
+
+        for (uint8_t i = 0; i < DERIVED_RPM_BANDS; i++) {
+            snprintf(band_keys[i], sizeof(band_keys[i]), "rpm_band_%u", (unsigned)i);
+            if (i == 0) {
+                snprintf(band_labels[i], sizeof(band_labels[i]), "RPM < %u", config->rpm_band_edges[0]);
+            } else if (i == DERIVED_RPM_BANDS - 1) {
+                snprintf(band_labels[i], sizeof(band_labels[i]), "RPM >= %u", config->rpm_band_edges[i - 1]);
+            } else {
+                snprintf(band_labels[i], sizeof(band_labels[i]), "RPM %u-%u",
+                         config->rpm_band_edges[i - 1], config->rpm_band_edges[i]);
+            }
+            id_band[i] = SignalStore_Register(band_keys[i], band_labels[i], "s", 1, DERIVED_STALE_MS);
+        }
+    }
+
+    Derived_ResetTrip();
+    derived_initialized = true;
+    return STATUS_OK;
+}
+
+void Derived_ResetTrip(void) {
+    distance_mm = 0;
+    fuel_ul = 0;
+    last_sample_time = 0;
+    last_speed_time = 0;
+    for (uint8_t i = 0; i < DERIVED_RPM_BANDS; i++) {
+        band_ms[i] = 0;
+    }
+}
+
+void Derived_ProcessSample(const VehicleData_t* data) {
+    if (!derived_initialized || data == nullptr ||
+        data->status[SIGNAL_RPM].quality != SIGNAL_QUALITY_VALID) {
+        return;
+    }
+
+    uint32_t now = data->lastUpdate;
+    uint16_t rpm = data->rpm;
+    bool speed_valid = (data->status[SIGNAL_SPEED].quality == SIGNAL_QUALITY_VALID);
+    bool throttle_valid = (data->status[SIGNAL_THROTTLE_POSITION].quality == SIGNAL_QUALITY_VALID);
+
+    uint32_t dt = (last_sample_time != 0) ? (now - last_sample_time) : 0;
+    if (dt > DERIVED_MAX_GAP_MS) {
+        dt = 0;
+    }
+    last_sample_time = now;
+
+    // Time in RPM band
+    uint8_t band = 0;
+    while (band < DERIVED_RPM_BANDS - 1 && rpm >= derived_config.rpm_band_edges[band]) {
+        band++;
+    }
+    band_ms[band] += dt;
+
+    // Fuel flow from a speed-density estimate: flow ~ rpm x load x displacement
+    uint8_t load = derived_config.idle_load_pct;
+    if (throttle_valid && data->throttlePosition > load) {
+        load = data->throttlePosition;
+    }
+    uint32_t flow_mlh = (uint32_t)((uint64_t)rpm * load * displacement_cc * derived_config.fuel_coefficient / 100000000ULL);
+    fuel_ul += (uint64_t)flow_mlh * dt / 3600;
+
+    // Distance: trapezoid over new speed samples (km/h x ms -> mm)
+    uint32_t speed_time = data->status[SIGNAL_SPEED].timestamp;
+    if (speed_valid && speed_time != last_speed_time) {
+        uint32_t speed_dt = speed_time - last_speed_time;
+        if (last_speed_time != 0 && speed_dt <= DERIVED_MAX_GAP_MS) {
+            distance_mm += (uint64_t)(last_speed + data->speed) * speed_dt * 10 / 72;
+        }
+        last_speed_time = speed_time;
+        last_speed = data->speed;
+    }
+
+    if (gear_count > 0) {
+        Derived_UpdateGear(rpm, data->speed, speed_valid);
+        SignalStore_Set(id_gear, current_gear, now);
+    }
+
+    uint32_t distance_m = (uint32_t)(distance_mm / 1000);
+    SignalStore_Set(id_trip_distance, distance_m, now);
+    if (displacement_cc > 0) {
+        SignalStore_Set(id_fuel_flow, flow_mlh / 10, now);
+        SignalStore_Set(id_fuel_used, (int32_t)(fuel_ul / 1000), now);
+        if (distance_m >= 100) {
+            // L/100km x10 = mL x 1000 / m = uL / m
+            SignalStore_Set(id_fuel_economy, (int32_t)(fuel_ul / distance_m), now);
+        }
+    }
+    for (uint8_t i = 0; i < DERIVED_RPM_BANDS; i++) {
+        SignalStore_Set(id_band[i], band_ms[i] / 1000, now);
+    }
+}
@@ -8,11 +8,247 @@
 #include <Arduino.h>
 #include "obd2_handler.h"
 #include "can_interface.h"
+#include "signal_store.h"
+#include "trace.h"
+
+/* Frames drained from the bus per cycle before polling */
+#define OBD2_MAX_BROADCAST_DRAIN    32
+/* Response cache covers Mode 01 PIDs 0x00-0x5F */
+#define OBD2_CACHE_PIDS             0x60
+#define OBD2_DEFAULT_TTL_MS         250
+/* Window for collecting responses to a functional discovery request */
+#define OBD2_DISCOVERY_WINDOW_MS    100
+
+/* Last response per PID, shared by all consumers; written with the bus held */
+typedef struct {
+    uint32_t sequence;              /* Odd while being rewritten */
+    uint8_t data[5];
+    uint8_t length;
+    bool filled;
+    Status_t status;
+    uint32_t timestamp;             /* Completion time of the bus transaction */
+    uint32_t rx_time_us;            /* micros() when the response frame was read */
+} OBD2_CacheEntry_t;
 
 static VehicleData_t vehicle_data = {0};
 static bool obd2_initialized = false;
 static DataUpdateCallback_t data_callback = nullptr;
 
+/* Scheduler state for the active profile */
+static const VehicleProfile_t* active_profile = nullptr;
+static uint32_t pid_last_read[PROFILE_MAX_PIDS];
+static uint16_t pid_period_ms[PROFILE_MAX_PIDS];    /* Profile periods, retunable at run time */
+static bool pid_from_broadcast[PROFILE_MAX_PIDS];
+static Status_t last_cycle_status = STATUS_NOT_INITIALIZED;
+static uint32_t broadcast_updates = 0;
+
+/* Response cache and bus arbitration */
+static OBD2_CacheEntry_t pid_cache[OBD2_CACHE_PIDS];
+static uint16_t pid_ttl_ms[OBD2_CACHE_PIDS];
+static SemaphoreHandle_t bus_mutex = nullptr;
+static OBD2_CacheStats_t cache_stats = {0};
+
+/* Map a PID to the signal it feeds, SIGNAL_COUNT if none */
+static VehicleSignal_t OBD2_SignalForPID(uint8_t pid) {
+    switch (pid) {
+        case PID_ENGINE_RPM:            return SIGNAL_RPM;
+        case PID_VEHICLE_SPEED:         return SIGNAL_SPEED;
+        case PID_ENGINE_COOLANT_TEMP:   return SIGNAL_COOLANT_TEMP;
+        case PID_THROTTLE_POSITION:     return SIGNAL_THROTTLE_POSITION;
+        case PID_FUEL_LEVEL:            return SIGNAL_FUEL_LEVEL;
+        case PID_ENGINE_RUNTIME:        return SIGNAL_ENGINE_RUNTIME;
+        default:                        return SIGNAL_COUNT;
+    }
+}
+
+/* Store a decoded value into the signal that the PID maps to */
+static void OBD2_StoreValue(uint8_t pid, int32_t value, uint32_t timestamp, uint32_t rx_time_us) {
+    VehicleSignal_t signal = OBD2_SignalForPID(pid);
+    if (signal != SIGNAL_COUNT) {
+        SignalStore_SetSample(signal, value, timestamp, rx_time_us);
+    }
+}
+
+/* Decode broadcast frames described by the active profile */
+static void OBD2_HandleBroadcast(const CAN_Frame_t* frame) {
+    const VehicleProfile_t* profile = active_profile;
+    if (profile == nullptr) {
+        return;
+    }
+    
+    uint32_t key = CAN_FrameKey(frame);
+    for (uint8_t i = 0; i < profile->broadcast_count; i++) {
+        const ProfileBroadcast_t* signal = &profile->broadcasts[i];
+        
+        if (signal->can_id != key || signal->start_byte + signal->length > frame->length) {
+            continue;
+        }
+        
+        int32_t raw = frame->data[signal->start_byte];
+        if (signal->length == 2) {
+            raw = (raw << 8) | frame->data[signal->start_byte + 1];
+        }
+        OBD2_StoreValue(signal->pid, raw * signal->scale_num / signal->scale_den + signal->offset, millis(),
+                        frame->timestamp_us);
+        broadcast_updates++;
+    }
+}
+
+static void OBD2_LockBus(void) {
+    xSemaphoreTake(bus_mutex, portMAX_DELAY);
+}
+
+static void OBD2_UnlockBus(void) {
+    xSemaphoreGive(bus_mutex);
+}
+
+/* Single Mode 01 bus transaction; caller holds the bus */
+static Status_t OBD2_RequestPID(uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us) {
+    Status_t status = CAN_SendOBD2Request(pid);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    
+    return CAN_ReceiveOBD2Stamped(OBD2_MODE_CURRENT_DATA, pid, data, length, rx_time_us, OBD2_REQUEST_TIMEOUT_MS);
+}
+
+/* Copy of a cache entry without the bus lock; false if a rewrite overlapped */
+static bool OBD2_CacheSnapshot(const OBD2_CacheEntry_t* entry, OBD2_CacheEntry_t* copy) {
+    uint32_t sequence = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+    if (sequence & 1) {
+        return false;
+    }
+    memcpy(copy, entry, sizeof(*copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&entry->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+/* Mode 01 read through the response cache.
+ * A response younger than ttl_ms is served from memory; otherwise the
+ * PID is requested on the bus and the cache entry refreshed. ttl_ms = 0
+ * always reaches the bus (scheduler polls). */
+static Status_t OBD2_Transact(uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us, uint32_t ttl_ms) {
+    uint32_t requested_at = millis();
+    uint32_t rx_unused;
+    if (rx_time_us == nullptr) {
+        rx_time_us = &rx_unused;
+    }
+    
+    if (pid >= OBD2_CACHE_PIDS) {
+        OBD2_LockBus();
+        Status_t status = OBD2_RequestPID(pid, data, length, rx_time_us);
+        cache_stats.bus_requests++;
+        OBD2_UnlockBus();
+        return status;
+    }
+    
+    // Fresh enough: served without the bus; a torn copy falls through to the locked path
+    OBD2_CacheEntry_t* entry = &pid_cache[pid];
+    OBD2_CacheEntry_t cached;
+    if (OBD2_CacheSnapshot(entry, &cached) && cached.filled && cached.status == STATUS_OK &&
+        (requested_at - cached.timestamp) < ttl_ms) {
+        memcpy(data, cached.data, sizeof(cached.data));
+        *length = cached.length;
+        *rx_time_us = cached.rx_time_us;
+        cache_stats.hits++;
+        return STATUS_OK;
+    }
+    
+    OBD2_LockBus();
+    Status_t status = OBD2_RequestPID(pid, data, length, rx_time_us);
+    cache_stats.bus_requests++;
+    
+    uint32_t sequence = entry->sequence;
+    __atomic_store_n(&entry->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (status == STATUS_OK) {
+        memcpy(entry->data, data, sizeof(entry->data));
+        entry->length = *length;
+        entry->rx_time_us = *rx_time_us;
+    }
+    entry->status = status;
+    entry->timestamp = millis();
+    entry->filled = true;
+    __atomic_store_n(&entry->sequence, sequence + 2, __ATOMIC_RELEASE);
+    
+    OBD2_UnlockBus();
+    return status;
+}
+
+/* Convert a Mode 01 response into the value stored for its signal */
+static Status_t OBD2_DecodePID(uint8_t pid, const uint8_t* data, uint8_t length, int32_t* value) {
+    switch (pid) {
+        case PID_ENGINE_RPM:
+            if (length < 2) {
+                return STATUS_ERROR;
+            }
+            *value = ((int32_t)data[0] * 256 + data[1]) / 4;
+            return STATUS_OK;
+        case PID_VEHICLE_SPEED:
+            if (length < 1) {
+                return STATUS_ERROR;
+            }
+            *value = data[0];
+            return STATUS_OK;
+        case PID_ENGINE_COOLANT_TEMP:
+            if (length < 1) {
+                return STATUS_ERROR;
+            }
+            *value = (int32_t)data[0] - 40;
+            return STATUS_OK;
+        case PID_THROTTLE_POSITION:
+        case PID_FUEL_LEVEL:
+            if (length < 1) {
+                return STATUS_ERROR;
+            }
+            *value = (data[0] * 100) / 255;
+            return STATUS_OK;
+        case PID_ENGINE_RUNTIME:
+            if (length < 2) {
+                return STATUS_ERROR;
+            }
+            *value = (int32_t)data[0] * 256 + data[1];
+            return STATUS_OK;
+        default:
+            return STATUS_INVALID_PARAM;
+    }
+}
+
+/* Read and decode one PID through the cache */
+static Status_t OBD2_ReadValue(uint8_t pid, int32_t* value, uint32_t* rx_time_us, uint32_t ttl_ms) {
+    uint8_t data[5];
+    uint8_t length = 0;
+    
+    Status_t status = OBD2_Transact(pid, data, &length, rx_time_us, ttl_ms);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    TRACE_BEGIN(TRACE_EV_OBD_DECODE, pid);
+    status = OBD2_DecodePID(pid, data, length, value);
+    TRACE_END(TRACE_EV_OBD_DECODE, pid);
+    return status;
+}
+
+/* Poll one PID and update the signal store; failed reads keep the previous value */
+static Status_t OBD2_ReadPID(uint8_t pid) {
+    VehicleSignal_t signal = OBD2_SignalForPID(pid);
+    int32_t value = 0;
+    uint32_t rx_time_us = 0;
+    
+    if (signal == SIGNAL_COUNT) {
+        return STATUS_INVALID_PARAM;
+    }
+    
+    // Scheduled polls always go to the bus; the cache serves everyone else
+    Status_t status = OBD2_ReadValue(pid, &value, &rx_time_us, 0);
+    if (status == STATUS_OK) {
+        SignalStore_SetSample(signal, value, millis(), rx_time_us);
+    } else {
+        SignalStore_MarkFailed(signal);
+    }
+    return status;
+}
+
 Status_t OBD2_Init(const OBD2_Config_t* config) {
     if (config == nullptr) {
         return STATUS_INVALID_PARAM;
@@ -32,59 +268,323 @@ Status_t OBD2_Init(const OBD2_Config_t* config) {
     vehicle_data.engineRunning = false;
     vehicle_data.lastUpdate = 0;
     
+    if (bus_mutex == nullptr) {
+        bus_mutex = xSemaphoreCreateMutex();
+        if (bus_mutex == nullptr) {
+            return STATUS_ERROR;
+        }
+    }
+    for (uint8_t pid = 0; pid < OBD2_CACHE_PIDS; pid++) {
+        pid_cache[pid].filled = false;
+        pid_ttl_ms[pid] = OBD2_DEFAULT_TTL_MS;
+    }
+    
     obd2_initialized = true;
+    return OBD2_ApplyProfile(Profile_GetDefault());
+}
+
+// A signal goes stale after three missed poll periods; a cached response
+// is as fresh as the scheduler would keep it
+static void OBD2_ApplyPIDPeriod(uint8_t pid, uint16_t period_ms) {
+    OBD2_SetPIDTTL(pid, period_ms);
+    VehicleSignal_t signal = OBD2_SignalForPID(pid);
+    if (signal != SIGNAL_COUNT) {
+        uint32_t stale_ms = 3UL * period_ms;
+        SignalStore_SetStaleLimit(signal, (stale_ms > SIGNAL_STALE_MIN_MS) ? stale_ms : SIGNAL_STALE_MIN_MS);
+    }
+}
+
+Status_t OBD2_ApplyProfile(const VehicleProfile_t* profile) {
+    if (profile == nullptr || profile->pid_count > PROFILE_MAX_PIDS) {
+        return STATUS_INVALID_PARAM;
+    }
+    
+    for (uint8_t i = 0; i < profile->pid_count; i++) {
+        pid_period_ms[i] = profile->pids[i].period_ms;
+        OBD2_ApplyPIDPeriod(profile->pids[i].pid, pid_period_ms[i]);
+    }
+    active_profile = profile;
+    
+    for (uint8_t i = 0; i < profile->pid_count; i++) {
+        pid_last_read[i] = millis() - pid_period_ms[i];     // Due on the first cycle
+        pid_from_broadcast[i] = false;
+        
+        for (uint8_t j = 0; j < profile->broadcast_count; j++) {
+            if (profile->broadcasts[j].pid == profile->pids[i].pid) {
+                pid_from_broadcast[i] = true;
+            }
+        }
+    }
+    
+    CAN_SetPassiveFrameCallback(profile->broadcast_count > 0 ? OBD2_HandleBroadcast : nullptr);
+    
+    // Broadcast signals need the acceptance filter open
+    if (profile->broadcast_count > 0) {
+        CAN_SetFilter(0, 0);
+    }
     return STATUS_OK;
 }
 
-Status_t OBD2_RegisterCallback(DataUpdateCallback_t callback) {
-    if (callback == nullptr) {
+const VehicleProfile_t* OBD2_GetActiveProfile(void) {
+    return active_profile;
+}
+
+/**
+ * @brief Change the poll period of a PID in the active profile (any task)
+ * @param pid Mode 01 PID
+ * @param period_ms New period; 0 restores the profile's period
+ * @return STATUS_OK, STATUS_INVALID_PARAM if the profile does not poll the PID
+ */
+Status_t OBD2_SetPIDPeriod(uint8_t pid, uint16_t period_ms) {
+    const VehicleProfile_t* profile = active_profile;
+    if (profile == nullptr) {
+        return STATUS_NOT_INITIALIZED;
+    }
+    
+    for (uint8_t i = 0; i < profile->pid_count; i++) {
+        if (profile->pids[i].pid == pid) {
+            pid_period_ms[i] = (period_ms != 0) ? period_ms : profile->pids[i].period_ms;
+            OBD2_ApplyPIDPeriod(pid, pid_period_ms[i]);
+            return STATUS_OK;
+        }
+    }
+    return STATUS_INVALID_PARAM;
+}
+
+/* Current poll period of a PID, 0 if the active profile does not poll it */
+uint16_t OBD2_GetPIDPeriod(uint8_t pid) {
+    const VehicleProfile_t* profile = active_profile;
+    if (profile == nullptr) {
+        return 0;
+    }
+    
+    for (uint8_t i = 0; i < profile->pid_count; i++) {
+        if (profile->pids[i].pid == pid) {
+            return pid_period_ms[i];
+        }
+    }
+    return 0;
+}
+
+Status_t OBD2_ReadVIN(char* vin, size_t size) {
+    if (!obd2_initialized || vin == nullptr || size < VIN_LENGTH + 1) {
         return STATUS_INVALID_PARAM;
     }
     
-    data_callback = callback;
+    uint8_t info_type = INFOTYPE_VIN;
+    uint8_t payload[24];
+    uint16_t length = 0;
+    
+    OBD2_LockBus();
+    Status_t status = CAN_SendOBD2ModeRequest(OBD2_MODE_VEHICLE_INFO, &info_type, 1);
+    if (status == STATUS_OK) {
+        // Payload: [number of data items, VIN (17 ASCII, some ECUs pad in front)]
+        status = CAN_ReceiveOBD2MultiFrame(OBD2_MODE_VEHICLE_INFO, INFOTYPE_VIN, payload, sizeof(payload),
+                                           &length, OBD2_REQUEST_TIMEOUT_MS * 2);
+    }
+    OBD2_UnlockBus();
+    if (status != STATUS_OK) {
+        return status;
+    }
+    if (length < VIN_LENGTH + 1) {
+        return STATUS_ERROR;
+    }
+    
+    memcpy(vin, &payload[length - VIN_LENGTH], VIN_LENGTH);
+    vin[VIN_LENGTH] = '\0';
     return STATUS_OK;
 }
 
-Status_t OBD2_ReadAllData(void) {
+Status_t OBD2_DiscoverSupportedPIDs(uint32_t supported_pids[3]) {
+    if (!obd2_initialized || supported_pids == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+    
+    static const uint8_t range_pids[3] = { PID_SUPPORTED_01_20, PID_SUPPORTED_21_40, PID_SUPPORTED_41_60 };
+    
+    for (uint8_t i = 0; i < 3; i++) {
+        supported_pids[i] = 0;
+    }
+    
+    for (uint8_t i = 0; i < 3; i++) {
+        uint8_t data[5];
+        uint8_t length;
+        
+        Status_t status = OBD2_Transact(range_pids[i], data, &length, nullptr, 0);
+        if (status != STATUS_OK || length < 4) {
+            return (i == 0) ? STATUS_TIMEOUT : STATUS_OK;
+        }
+        
+        supported_pids[i] = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                            ((uint32_t)data[2] << 8) | data[3];
+        
+        // Bit 0 tells whether the next range is supported
+        if ((supported_pids[i] & 0x01) == 0) {
+            break;
+        }
+        delay(10);
+    }
+    
+    return STATUS_OK;
+}
+
+/* Probe every service with one identifier width and address each to its lowest responder */
+static Status_t OBD2_DiscoverTargets(bool extended, uint8_t* common_ecu, bool* single_ecu) {
+    // One cheap request per service this reader uses; every ECU supporting it answers
+    static const struct {
+        uint8_t mode;
+        uint8_t params[2];
+        uint8_t param_count;
+    } probes[] = {
+        { OBD2_MODE_CURRENT_DATA, { PID_SUPPORTED_01_20, 0 }, 1 },
+        { OBD2_MODE_FREEZE_FRAME, { PID_SUPPORTED_01_20, 0 }, 2 },
+        { OBD2_MODE_VEHICLE_INFO, { 0x00, 0 }, 1 }
+    };
+    
+    *common_ecu = CAN_OBD2_FUNCTIONAL;
+    *single_ecu = true;
+    CAN_SetOBD2Addressing(extended);
+    
+    for (uint8_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+        uint8_t responders = 0;
+        
+        OBD2_LockBus();
+        Status_t status = CAN_DiscoverOBD2Responders(probes[i].mode, probes[i].params, probes[i].param_count,
+                                                     &responders, OBD2_DISCOVERY_WINDOW_MS);
+        OBD2_UnlockBus();
+        
+        if (status != STATUS_OK) {
+            if (probes[i].mode == OBD2_MODE_CURRENT_DATA) {
+                return STATUS_TIMEOUT;
+            }
+            *single_ecu = false;    // Stays functional; the filter must stay open
+            continue;
+        }
+        
+        // Lowest responder: ECU #1 (0x7E8) is the engine ECU by convention;
+        // with 29-bit IDs ECUs are numbered in order of first response
+        uint8_t target = 0;
+        while ((responders & (1 << target)) == 0) {
+            target++;
+        }
+        CAN_SetOBD2Target(probes[i].mode, target);
+        
+        if (*common_ecu == CAN_OBD2_FUNCTIONAL) {
+            *common_ecu = target;
+        } else if (*common_ecu != target) {
+            *single_ecu = false;
+        }
+    }
+    return STATUS_OK;
+}
+
+Status_t OBD2_SetupAddressing(uint8_t* ecu) {
     if (!obd2_initialized) {
         return STATUS_NOT_INITIALIZED;
     }
     
-    Status_t overall_status = STATUS_OK;
+    uint8_t common_ecu;
+    bool single_ecu;
     
-    if (OBD2_ReadRPM(&vehicle_data.rpm) != STATUS_OK) {
-        overall_status = STATUS_ERROR;
+    // 11-bit first; some KTM-group ECUs only answer 29-bit requests
+    Status_t status = OBD2_DiscoverTargets(false, &common_ecu, &single_ecu);
+    if (status == STATUS_TIMEOUT) {
+        status = OBD2_DiscoverTargets(true, &common_ecu, &single_ecu);
+    }
+    if (status != STATUS_OK) {
+        CAN_SetOBD2Addressing(false);
+        return status;
     }
     
-    delay(10);
+    // Only one response ID is left to receive: let the controller drop everything else
+    if (single_ecu && (active_profile == nullptr || active_profile->broadcast_count == 0)) {
+        CAN_SetFilter(CAN_GetOBD2ResponseId(common_ecu), CAN_IsOBD2Extended() ? 0x1FFFFFFF : 0x7FF);
+    }
     
-    if (OBD2_ReadSpeed(&vehicle_data.speed) != STATUS_OK) {
-        overall_status = STATUS_ERROR;
+    if (ecu != nullptr) {
+        *ecu = common_ecu;
+    }
+    return STATUS_OK;
+}
+
+Status_t OBD2_RegisterCallback(DataUpdateCallback_t callback) {
+    if (callback == nullptr) {
+        return STATUS_INVALID_PARAM;
     }
     
-    delay(10);
+    data_callback = callback;
+    return STATUS_OK;
+}
+
+Status_t OBD2_ReadAllData(void) {
+    const VehicleProfile_t* profile = active_profile;
+    if (!obd2_initialized || profile == nullptr) {
+        return STATUS_NOT_INITIALIZED;
+    }
     
-    if (OBD2_ReadCoolantTemp(&vehicle_data.coolantTemp) != STATUS_OK) {
-        overall_status = STATUS_ERROR;
+    TRACE_BEGIN(TRACE_EV_OBD_POLL, 0);
+    
+    // Decode broadcast traffic that arrived since the last cycle
+    uint32_t broadcast_before = broadcast_updates;
+    static CAN_Frame_t frames[OBD2_MAX_BROADCAST_DRAIN];
+    OBD2_LockBus();
+    uint16_t count = CAN_ReceiveFrames(frames, OBD2_MAX_BROADCAST_DRAIN, 0);
+    TRACE_BEGIN(TRACE_EV_OBD_BROADCAST, count);
+    for (uint16_t i = 0; i < count; i++) {
+        OBD2_HandleBroadcast(&frames[i]);
     }
+    TRACE_END(TRACE_EV_OBD_BROADCAST, count);
+    OBD2_UnlockBus();
     
-    delay(10);
+    Status_t overall_status = STATUS_OK;
+    uint8_t read_count = 0;
+    uint32_t now = millis();
+    
+    for (uint8_t i = 0; i < profile->pid_count; i++) {
+        const ProfilePid_t* entry = &profile->pids[i];
+        
+        if (pid_from_broadcast[i] || (now - pid_last_read[i]) < pid_period_ms[i]) {
+            continue;
+        }
+        
+        if (read_count > 0) {
+            delay(10);
+        }
+        
+        if (OBD2_ReadPID(entry->pid) != STATUS_OK) {
+            overall_status = STATUS_ERROR;
+        }
+        pid_last_read[i] = now;
+        read_count++;
+    }
     
-    if (OBD2_ReadThrottlePosition(&vehicle_data.throttlePosition) != STATUS_OK) {
-        overall_status = STATUS_ERROR;
+    // Nothing was due: report the outcome of the last real cycle
+    if (read_count == 0 && broadcast_updates == broadcast_before) {
+        TRACE_END(TRACE_EV_OBD_POLL, 0);
+        return last_cycle_status;
     }
     
-    vehicle_data.engineRunning = (vehicle_data.rpm > 0);
-    vehicle_data.lastUpdate = millis();
+    // Age out values that have not been refreshed and refresh the struct view
+    now = millis();
+    SignalStore_AgeOut(now);
+    SignalStore_FillVehicleData(&vehicle_data);
+    
+    vehicle_data.engineRunning = (vehicle_data.status[SIGNAL_RPM].quality == SIGNAL_QUALITY_VALID) &&
+                                 (vehicle_data.rpm > 0);
+    vehicle_data.lastUpdate = now;
     
     if (overall_status == STATUS_OK || vehicle_data.rpm > 0) {
         vehicle_data.dataValid = true;
         
         if (data_callback != nullptr) {
+            TRACE_BEGIN(TRACE_EV_DATA_CALLBACK, 0);
             data_callback(&vehicle_data);
+            TRACE_END(TRACE_EV_DATA_CALLBACK, 0);
         }
     }
     
+    last_cycle_status = overall_status;
+    TRACE_END(TRACE_EV_OBD_POLL, read_count);
     return overall_status;
 }
 
@@ -93,19 +593,10 @@ Status_t OBD2_ReadRPM(uint16_t* rpm) {
         return STATUS_INVALID_PARAM;
     }
     
-    Status_t status = CAN_SendOBD2Request(PID_ENGINE_RPM);
-    if (status != STATUS_OK) {
-        return status;
-    }
-    
-    uint8_t data[5];
-    uint8_t length;
-    status = CAN_ReceiveOBD2Response(PID_ENGINE_RPM, data, &length, OBD2_REQUEST_TIMEOUT_MS);
-    
-    if (status == STATUS_OK && length >= 2) {
-        *rpm = ((uint16_t)data[0] * 256 + data[1]) / 4;
-    } else {
-        *rpm = 0;
+    int32_t value;
+    Status_t status = OBD2_ReadValue(PID_ENGINE_RPM, &value, nullptr, pid_ttl_ms[PID_ENGINE_RPM]);
+    if (status == STATUS_OK) {
+        *rpm = value;
     }
     
     return status;
@@ -116,70 +607,169 @@ Status_t OBD2_ReadSpeed(uint8_t* speed) {
         return STATUS_INVALID_PARAM;
     }
     
-    Status_t status = CAN_SendOBD2Request(PID_VEHICLE_SPEED);
-    if (status != STATUS_OK) {
-        return status;
+    int32_t value;
+    Status_t status = OBD2_ReadValue(PID_VEHICLE_SPEED, &value, nullptr, pid_ttl_ms[PID_VEHICLE_SPEED]);
+    if (status == STATUS_OK) {
+        *speed = value;
     }
     
-    uint8_t data[5];
-    uint8_t length;
-    status = CAN_ReceiveOBD2Response(PID_VEHICLE_SPEED, data, &length, OBD2_REQUEST_TIMEOUT_MS);
+    return status;
+}
+
+Status_t OBD2_ReadCoolantTemp(int8_t* temp) {
+    if (!obd2_initialized || temp == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
     
-    if (status == STATUS_OK && length >= 1) {
-        *speed = data[0];
-    } else {
-        *speed = 0;
+    int32_t value;
+    Status_t status = OBD2_ReadValue(PID_ENGINE_COOLANT_TEMP, &value, nullptr, pid_ttl_ms[PID_ENGINE_COOLANT_TEMP]);
+    if (status == STATUS_OK) {
+        *temp = value;
     }
     
     return status;
 }
 
-Status_t OBD2_ReadCoolantTemp(int8_t* temp) {
-    if (!obd2_initialized || temp == nullptr) {
+Status_t OBD2_ReadThrottlePosition(uint8_t* throttle) {
+    if (!obd2_initialized || throttle == nullptr) {
         return STATUS_INVALID_PARAM;
     }
     
-    Status_t status = CAN_SendOBD2Request(PID_ENGINE_COOLANT_TEMP);
-    if (status != STATUS_OK) {
-        return status;
+    int32_t value;
+    Status_t status = OBD2_ReadValue(PID_THROTTLE_POSITION, &value, nullptr, pid_ttl_ms[PID_THROTTLE_POSITION]);
+    if (status == STATUS_OK) {
+        *throttle = value;
     }
     
-    uint8_t data[5];
-    uint8_t length;
-    status = CAN_ReceiveOBD2Response(PID_ENGINE_COOLANT_TEMP, data, &length, OBD2_REQUEST_TIMEOUT_MS);
+    return status;
+}
+
+Status_t OBD2_QueryPID(uint8_t pid, uint8_t* data, uint8_t* length) {
+    if (!obd2_initialized || data == nullptr || length == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
     
-    if (status == STATUS_OK && length >= 1) {
-        *temp = (int8_t)data[0] - 40;
-    } else {
-        *temp = -40;
+    return OBD2_Transact(pid, data, length, nullptr, (pid < OBD2_CACHE_PIDS) ? pid_ttl_ms[pid] : 0);
+}
+
+/* Uncached Mode 01 request for timing measurements: holds the bus and
+ * polls for the response without sleeping, so rx_time_us is exact */
+Status_t OBD2_MeasurePID(uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us, uint32_t timeout_ms) {
+    if (!obd2_initialized || data == nullptr || length == nullptr || rx_time_us == nullptr) {
+        return STATUS_INVALID_PARAM;
     }
     
+    OBD2_LockBus();
+    Status_t status = CAN_SendOBD2Request(pid);
+    if (status == STATUS_OK) {
+        status = CAN_ReceiveOBD2Timed(OBD2_MODE_CURRENT_DATA, pid, data, length, rx_time_us, timeout_ms);
+    }
+    cache_stats.bus_requests++;
+    OBD2_UnlockBus();
     return status;
 }
 
-Status_t OBD2_ReadThrottlePosition(uint8_t* throttle) {
-    if (!obd2_initialized || throttle == nullptr) {
+Status_t OBD2_SetPIDTTL(uint8_t pid, uint16_t ttl_ms) {
+    if (pid >= OBD2_CACHE_PIDS) {
         return STATUS_INVALID_PARAM;
     }
     
-    Status_t status = CAN_SendOBD2Request(PID_THROTTLE_POSITION);
-    if (status != STATUS_OK) {
-        return status;
+    pid_ttl_ms[pid] = ttl_ms;
+    return STATUS_OK;
+}
+
+void OBD2_GetCacheStats(OBD2_CacheStats_t* stats) {
+    if (stats != nullptr) {
+        *stats = cache_stats;
+    }
+}
+
+const VehicleData_t* OBD2_GetVehicleData(void) {
+    return &vehicle_data;
+}
+
+Status_t OBD2_ReadMonitorStatus(bool* mil_on, uint8_t* dtc_count) {
+    if (!obd2_initialized || mil_on == nullptr || dtc_count == nullptr) {
+        return STATUS_INVALID_PARAM;
     }
     
     uint8_t data[5];
     uint8_t length;
-    status = CAN_ReceiveOBD2Response(PID_THROTTLE_POSITION, data, &length, OBD2_REQUEST_TIMEOUT_MS);
+    Status_t status = OBD2_Transact(PID_MONITOR_STATUS, data, &length, nullptr, pid_ttl_ms[PID_MONITOR_STATUS]);
     
     if (status == STATUS_OK && length >= 1) {
-        *throttle = (data[0] * 100) / 255;
-    } else {
-        *throttle = 0;
+        // Byte A: bit 7 = MIL, bits 0-6 = number of confirmed DTCs
+        *mil_on = (data[0] & 0x80) != 0;
+        *dtc_count = data[0] & 0x7F;
     }
     
     return status;
 }
 
-const VehicleData_t* OBD2_GetVehicleData(void) {
-    return &vehicle_data;
+/* Request one Mode 02 PID; data[0] of the response is the frame number */
+static Status_t OBD2_ReadFreezeFramePID(uint8_t pid, uint8_t frame_number, uint8_t* data, uint8_t* length) {
+    uint8_t params[2] = { pid, frame_number };
+    
+    OBD2_LockBus();
+    Status_t status = CAN_SendOBD2ModeRequest(OBD2_MODE_FREEZE_FRAME, params, sizeof(params));
+    if (status == STATUS_OK) {
+        status = CAN_ReceiveOBD2ModeResponse(OBD2_MODE_FREEZE_FRAME, pid, data, length, OBD2_REQUEST_TIMEOUT_MS);
+    }
+    OBD2_UnlockBus();
+    if (status == STATUS_OK && (*length < 2 || data[0] != frame_number)) {
+        return STATUS_ERROR;
+    }
+    
+    return status;
+}
+
+Status_t OBD2_ReadFreezeFrame(uint8_t frame_number, FreezeFrame_t* frame) {
+    if (!obd2_initialized || frame == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+    
+    memset(frame, 0, sizeof(*frame));
+    frame->frameNumber = frame_number;
+    frame->timestamp = millis();
+    
+    uint8_t data[5];
+    uint8_t length;
+    
+    // The DTC that stored the frame; 0x0000 means no freeze frame is stored
+    Status_t status = OBD2_ReadFreezeFramePID(PID_FREEZE_DTC, frame_number, data, &length);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    if (length < 3) {
+        return STATUS_ERROR;
+    }
+    frame->dtc = ((uint16_t)data[1] << 8) | data[2];
+    frame->valid = true;
+    
+    if (frame->dtc == 0) {
+        return STATUS_OK;
+    }
+    
+    // Remaining PIDs are best effort, an ECU may store only a subset
+    delay(10);
+    if (OBD2_ReadFreezeFramePID(PID_ENGINE_RPM, frame_number, data, &length) == STATUS_OK && length >= 3) {
+        frame->rpm = ((uint16_t)data[1] * 256 + data[2]) / 4;
+    }
+    
+    delay(10);
+    if (OBD2_ReadFreezeFramePID(PID_VEHICLE_SPEED, frame_number, data, &length) == STATUS_OK && length >= 2) {
+        frame->speed = data[1];
+    }
+    
+    delay(10);
+    if (OBD2_ReadFreezeFramePID(PID_ENGINE_COOLANT_TEMP, frame_number, data, &length) == STATUS_OK && length >= 2) {
+        frame->coolantTemp = (int8_t)(data[1] - 40);
+    }
+    
+    delay(10);
+    if (OBD2_ReadFreezeFramePID(PID_THROTTLE_POSITION, frame_number, data, &length) == STATUS_OK && length >= 2) {
+        frame->throttlePosition = (data[1] * 100) / 255;
+    }
+    
+    return STATUS_OK;
 }
@@ -0,0 +1,367 @@
+/**
+ * @file perf_timer.cpp
+ * @brief Performance-run timer - Application layer
+ * @version 1.0
+ * @date 2025-11-09
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "perf_timer.h"
+#include "can_interface.h"
+#include "obd2_handler.h"
+#include "signal_store.h"
+#include "heap_audit.h"
+
+#define PERF_DIR                    "/perf"
+#define PERF_SLICE_MS               50      /* Bus time per Perf_Process call */
+#define PERF_RESPONSE_TIMEOUT_MS    50
+#define PERF_RX_BATCH               16      /* Broadcast frames taken per receive call */
+#define PERF_ARM_TIMEOUT_MS         300000  /* Give up waiting for the launch */
+#define PERF_MAX_RUN_MS             60000
+#define PERF_LAUNCH_X100            50      /* 0.5 km/h: half of the 1 km/h PID step */
+#define PERF_QUARTER_MILE_MM        402336
+#define PERF_WRITER_STACK           4096
+#define PERF_WRITER_PRIORITY        0       /* Below the Arduino loop task */
+
+static PerfState_t state = PERF_STATE_IDLE;
+static PerfRunType_t run_type = PERF_RUN_0_100;
+static PerfSource_t source = PERF_SOURCE_OBD2;
+static const ProfileBroadcast_t* speed_broadcast = nullptr;
+static uint32_t armed_at = 0;
+static uint32_t run_count = 0;
+
+/* Result file written by the writer task; the trace is kept until it is done */
+static volatile bool write_pending = false;
+static SemaphoreHandle_t write_ready = nullptr;
+
+/* Current run */
+static PerfSample_t trace[PERF_TRACE_SIZE];
+static uint16_t trace_count = 0;
+static PerfSample_t previous;
+static bool have_previous = false;
+static uint32_t start_us = 0;
+static uint64_t distance_mm_x1000 = 0;     /* um, so short segments do not truncate away */
+
+static PerfFileHeader_t file_header;
+static PerfResult_t last_result;
+static bool have_result = false;
+
+/* Time at which a linear segment reaches level */
+static uint32_t Perf_Interpolate(const PerfSample_t* a, const PerfSample_t* b, uint16_t level) {
+    if (b->speed_x100 == a->speed_x100) {
+        return b->time_us;
+    }
+    uint32_t dt = b->time_us - a->time_us;
+    return a->time_us + (uint32_t)((uint64_t)(level - a->speed_x100) * dt / (b->speed_x100 - a->speed_x100));
+}
+
+/* Distance over a segment, trapezoid: km/h x100 x us -> um */
+static uint64_t Perf_SegmentDistance(uint16_t v0_x100, uint16_t v1_x100, uint32_t dt_us) {
+    return (uint64_t)(v0_x100 + v1_x100) * dt_us / 720;
+}
+
+static void Perf_WriterTask(void* param) {
+    char path[32];
+    HEAP_AUDIT_WATCH();
+
+    for (;;) {
+        if (xSemaphoreTake(write_ready, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), PERF_DIR "/run_%02u.bin",
+                 (unsigned)(file_header.result.run_index % PERF_MAX_FILES));
+
+        {
+            HEAP_AUDIT_EXEMPT();    // File handles are allocated and freed by LittleFS within this block
+            File file = LittleFS.open(path, FILE_WRITE);
+            if (file) {
+                file.write((const uint8_t*)&file_header, sizeof(file_header));
+                file.write((const uint8_t*)trace, file_header.result.sample_count * sizeof(PerfSample_t));
+                file.close();
+            }
+        }
+
+        write_pending = false;
+    }
+}
+
+static uint16_t Perf_StartLevel(void) {
+    return (run_type == PERF_RUN_60_120) ? 6000 : PERF_LAUNCH_X100;
+}
+
+static void Perf_Finish(bool valid, uint32_t end_us, uint16_t finish_speed) {
+    PerfResult_t* r = &last_result;
+    memset(r, 0, sizeof(*r));
+    r->run_index = run_count++;
+    r->type = run_type;
+    r->source = source;
+    r->valid = valid;
+    r->elapsed_us = valid ? (end_us - start_us) : 0;
+    r->finish_speed_x100 = finish_speed;
+    r->distance_mm = (uint32_t)(distance_mm_x1000 / 1000);
+    r->sample_count = trace_count;
+    r->speed_step_x100 = 100;
+    if (source == PERF_SOURCE_BROADCAST && speed_broadcast->scale_den != 0) {
+        int32_t step = (int32_t)speed_broadcast->scale_num * 100 / speed_broadcast->scale_den;
+        r->speed_step_x100 = (step > 0) ? step : 1;
+    }
+
+    // Measured sample spacing is the resolution of the interpolated times
+    for (uint16_t i = 1; i < trace_count; i++) {
+        uint32_t gap = trace[i].time_us - trace[i - 1].time_us;
+        if (gap > r->max_interval_us) {
+            r->max_interval_us = gap;
+        }
+    }
+    if (trace_count > 1) {
+        r->mean_interval_us = (trace[trace_count - 1].time_us - trace[0].time_us) / (trace_count - 1);
+    }
+
+    // Flash writes stall for tens of ms; the loop goes back to polling instead
+    if (write_ready != nullptr) {
+        memcpy(file_header.magic, "PRF1", 4);
+        file_header.result = *r;
+        file_header.start_us = start_us;
+        write_pending = true;
+        xSemaphoreGive(write_ready);
+    }
+
+    have_result = true;
+    state = PERF_STATE_IDLE;
+}
+
+/* Back to waiting for the start threshold, keeping the latest sample */
+static void Perf_Rearm(const PerfSample_t* sample) {
+    state = PERF_STATE_ARMED;
+    trace_count = 0;
+    distance_mm_x1000 = 0;
+    previous = *sample;
+    have_previous = true;
+}
+
+/* Returns true if the run finished with this sample */
+static bool Perf_AddSample(const PerfSample_t* sample) {
+    uint16_t start_level = Perf_StartLevel();
+
+    if (!have_previous) {
+        previous = *sample;
+        have_previous = true;
+        return false;
+    }
+
+    if (state == PERF_STATE_ARMED) {
+        // Start when a segment crosses the start level from below
+        if (previous.speed_x100 < start_level && sample->speed_x100 >= start_level) {
+            start_us = Perf_Interpolate(&previous, sample, start_level);
+            trace[0] = previous;
+            trace[1] = *sample;
+            trace_count = 2;
+            distance_mm_x1000 = Perf_SegmentDistance(start_level, sample->speed_x100, sample->time_us - start_us);
+            state = PERF_STATE_RUNNING;
+        }
+        previous = *sample;
+        return false;
+    }
+
+    // Running: falling back below the start level is a false start
+    if (sample->speed_x100 < start_level) {
+        Perf_Rearm(sample);
+        return false;
+    }
+
+    if (trace_count >= PERF_TRACE_SIZE) {
+        Perf_Finish(false, 0, previous.speed_x100);
+        return true;
+    }
+    trace[trace_count++] = *sample;
+
+    uint32_t dt = sample->time_us - previous.time_us;
+    uint64_t segment = Perf_SegmentDistance(previous.speed_x100, sample->speed_x100, dt);
+
+    if (run_type == PERF_RUN_QUARTER_MILE) {
+        uint64_t target = (uint64_t)PERF_QUARTER_MILE_MM * 1000;
+        if (distance_mm_x1000 + segment >= target && segment > 0) {
+            uint64_t remaining = target - distance_mm_x1000;
+            uint32_t end_us = previous.time_us + (uint32_t)(remaining * dt / segment);
+            uint16_t trap = previous.speed_x100 +
+                            (int32_t)(sample->speed_x100 - previous.speed_x100) * (int64_t)remaining / (int64_t)segment;
+            distance_mm_x1000 = target;
+            Perf_Finish(true, end_us, trap);
+            return true;
+        }
+    } else {
+        uint16_t end_level = (run_type == PERF_RUN_60_120) ? 12000 : 10000;
+        if (previous.speed_x100 < end_level && sample->speed_x100 >= end_level) {
+            uint32_t end_us = Perf_Interpolate(&previous, sample, end_level);
+            distance_mm_x1000 += Perf_SegmentDistance(previous.speed_x100, end_level, end_us - previous.time_us);
+            Perf_Finish(true, end_us, end_level);
+            return true;
+        }
+    }
+
+    distance_mm_x1000 += segment;
+    previous = *sample;
+    return false;
+}
+
+/* Speed sample from a broadcast frame, false if the frame does not carry it */
+static bool Perf_DecodeBroadcast(const CAN_Frame_t* frame, PerfSample_t* sample) {
+    if (CAN_FrameKey(frame) != speed_broadcast->can_id ||
+        speed_broadcast->start_byte + speed_broadcast->length > frame->length) {
+        return false;
+    }
+
+    int32_t raw = frame->data[speed_broadcast->start_byte];
+    if (speed_broadcast->length == 2) {
+        raw = (raw << 8) | frame->data[speed_broadcast->start_byte + 1];
+    }
+    int32_t speed = (raw * speed_broadcast->scale_num * 100) / speed_broadcast->scale_den +
+                    speed_broadcast->offset * 100;
+    sample->time_us = frame->timestamp_us;
+    sample->speed_x100 = constrain(speed, 0, 65535);
+    sample->reserved = 0;
+    return true;
+}
+
+/* One speed sample requested over OBD2, under the OBD2 bus lock */
+static bool Perf_ReadSpeed(PerfSample_t* sample) {
+    uint8_t data[5];
+    uint8_t length = 0;
+    if (OBD2_MeasurePID(PID_VEHICLE_SPEED, data, &length, &sample->time_us, PERF_RESPONSE_TIMEOUT_MS) != STATUS_OK ||
+        length < 1) {
+        return false;
+    }
+    sample->speed_x100 = data[0] * 100;
+    sample->reserved = 0;
+    return true;
+}
+
+Status_t Perf_Init(void) {
+    state = PERF_STATE_IDLE;
+    have_result = false;
+
+    // LittleFS is shared with event capture; begin() is safe to repeat
+    if (!LittleFS.begin(true)) {
+        return STATUS_ERROR;
+    }
+    if (!LittleFS.exists(PERF_DIR)) {
+        LittleFS.mkdir(PERF_DIR);
+    }
+
+    if (write_ready == nullptr) {
+        write_ready = xSemaphoreCreateBinary();
+        if (write_ready == nullptr) {
+            return STATUS_ERROR;
+        }
+        if (xTaskCreatePinnedToCore(Perf_WriterTask, "perf_wr", PERF_WRITER_STACK,
+                                    nullptr, PERF_WRITER_PRIORITY, nullptr, tskNO_AFFINITY) != pdPASS) {
+            vSemaphoreDelete(write_ready);
+            write_ready = nullptr;
+            return STATUS_ERROR;
+        }
+    }
+    return STATUS_OK;
+}
+
+Status_t Perf_Start(PerfRunType_t type) {
+    if (type > PERF_RUN_QUARTER_MILE) {
+        return STATUS_INVALID_PARAM;
+    }
+    // The previous run's trace is still being written
+    if (state != PERF_STATE_IDLE || write_pending) {
+        return STATUS_BUSY;
+    }
+
+    // Prefer a broadcast speed signal: no request round trip per sample
+    source = PERF_SOURCE_OBD2;
+    speed_broadcast = nullptr;
+    const VehicleProfile_t* profile = OBD2_GetActiveProfile();
+    if (profile != nullptr) {
+        for (uint8_t i = 0; i < profile->broadcast_count; i++) {
+            if (profile->broadcasts[i].pid == PID_VEHICLE_SPEED && profile->broadcasts[i].scale_den != 0) {
+                speed_broadcast = &profile->broadcasts[i];
+                source = PERF_SOURCE_BROADCAST;
+                break;
+            }
+        }
+    }
+
+    run_type = type;
+    trace_count = 0;
+    distance_mm_x1000 = 0;
+    have_previous = false;
+    armed_at = millis();
+    state = PERF_STATE_ARMED;
+    return STATUS_OK;
+}
+
+void Perf_Cancel(void) {
+    state = PERF_STATE_IDLE;
+}
+
+bool Perf_Process(void) {
+    if (state == PERF_STATE_IDLE) {
+        return false;
+    }
+    if (state == PERF_STATE_ARMED && (millis() - armed_at) > PERF_ARM_TIMEOUT_MS) {
+        state = PERF_STATE_IDLE;
+        return false;
+    }
+
+    uint32_t slice_start = millis();
+    PerfSample_t sample;
+    bool got_sample = false;
+    bool finished = false;
+
+    while (!finished && (millis() - slice_start) < PERF_SLICE_MS) {
+        // Checked every pass: the run must end even if speed samples stop
+        if (state == PERF_STATE_RUNNING && (micros() - start_us) / 1000 > PERF_MAX_RUN_MS) {
+            Perf_Finish(false, 0, previous.speed_x100);
+            finished = true;
+            break;
+        }
+
+        if (source == PERF_SOURCE_BROADCAST) {
+            static CAN_Frame_t frames[PERF_RX_BATCH];
+            uint16_t count = CAN_ReceiveFrames(frames, PERF_RX_BATCH, 1);
+            for (uint16_t i = 0; i < count && !finished; i++) {
+                if (Perf_DecodeBroadcast(&frames[i], &sample)) {
+                    got_sample = true;
+                    finished = Perf_AddSample(&sample);
+                }
+            }
+            continue;
+        }
+        if (!Perf_ReadSpeed(&sample)) {
+            continue;
+        }
+        got_sample = true;
+        finished = Perf_AddSample(&sample);
+    }
+
+    // Keep displays alive while the regular scheduler is paused
+    if (got_sample) {
+        SignalStore_SetSample(SIGNAL_SPEED, sample.speed_x100 / 100, millis(), sample.time_us);
+    }
+
+    return finished;
+}
+
+PerfState_t Perf_GetState(void) {
+    return state;
+}
+
+const PerfResult_t* Perf_GetLastResult(void) {
+    return have_result ? &last_result : nullptr;
+}
+
+const char* Perf_RunName(uint8_t type) {
+    switch (type) {
+        case PERF_RUN_0_100:        return "0-100";
+        case PERF_RUN_60_120:       return "60-120";
+        case PERF_RUN_QUARTER_MILE: return "quarter_mile";
+        default:                    return "unknown";
+    }
+}
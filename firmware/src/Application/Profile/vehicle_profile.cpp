@@ -0,0 +1,124 @@
+/**
+ * @file vehicle_profile.cpp
+ * @brief Compiled-in vehicle profile store - Application layer
+ * @version 1.0
+ * @date 2025-11-04
+ */
+
+#include <Arduino.h>
+#include "vehicle_profile.h"
+
+/* Bitmap helper: bit 31 of word 0 is PID 0x01 (SAE J1979 layout) */
+#define PID_BIT(pid)                (1UL << (31 - (((pid) - 1) & 0x1F)))
+
+/* ---------------------------------------------------------------------------
+ * Husqvarna Svartpilen 401 (KTM LC4c 373 cc)
+ * "VBK" alone is the whole KTM group WMI (every KTM, Husqvarna and GasGas
+ * model), so the pattern also pins VIN positions 7-8, the engine family
+ * code ("40": 373 cc LC4c). Positions 4-6 (model line, body) are left open
+ * until they are confirmed on further bikes.
+ * No broadcast signals are decoded yet. Gear ratios are nominal rpm per km/h
+ * from the stock gearing and only seed the on-device gear clustering.
+ * ------------------------------------------------------------------------- */
+static const ProfilePid_t svartpilen401_pids[] = {
+    { PID_ENGINE_RPM,           200 },
+    { PID_THROTTLE_POSITION,    200 },
+    { PID_VEHICLE_SPEED,        200 },
+    { PID_ENGINE_COOLANT_TEMP,  1000 },
+};
+
+static const VehicleProfile_t profile_store[] = {
+    {
+        "Husqvarna Svartpilen 401",
+        "VBK???40",
+        {
+            PID_BIT(PID_MONITOR_STATUS) | PID_BIT(PID_ENGINE_COOLANT_TEMP) |
+            PID_BIT(PID_ENGINE_RPM) | PID_BIT(PID_VEHICLE_SPEED) | PID_BIT(PID_THROTTLE_POSITION),
+            0,
+            0
+        },
+        svartpilen401_pids,
+        sizeof(svartpilen401_pids) / sizeof(svartpilen401_pids[0]),
+        nullptr,
+        0,
+        373,
+        6,
+        { 1670, 1180, 950, 800, 710, 620 }
+    },
+};
+
+#define PROFILE_COUNT               (sizeof(profile_store) / sizeof(profile_store[0]))
+
+/* PIDs the OBD2 handler can decode, with the period used by the generic profile */
+static const ProfilePid_t generic_candidates[] = {
+    { PID_ENGINE_RPM,           200 },
+    { PID_THROTTLE_POSITION,    200 },
+    { PID_VEHICLE_SPEED,        200 },
+    { PID_ENGINE_COOLANT_TEMP,  1000 },
+    { PID_FUEL_LEVEL,           5000 },
+    { PID_ENGINE_RUNTIME,       1000 },
+};
+
+/* Generic profile assembled from discovery results (RAM) */
+static ProfilePid_t generic_pids[PROFILE_MAX_PIDS];
+static VehicleProfile_t generic_profile;
+
+bool Profile_IsPIDSupported(const uint32_t supported_pids[3], uint8_t pid) {
+    if (supported_pids == nullptr || pid == 0 || pid > 0x60) {
+        return false;
+    }
+    return (supported_pids[(pid - 1) / 32] & PID_BIT(pid)) != 0;
+}
+
+const VehicleProfile_t* Profile_FindByVIN(const char* vin) {
+    if (vin == nullptr) {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < PROFILE_COUNT; i++) {
+        const char* pattern = profile_store[i].vin_pattern;
+        size_t j = 0;
+
+        while (pattern[j] != '\0' && vin[j] != '\0' &&
+               (pattern[j] == '?' || pattern[j] == vin[j])) {
+            j++;
+        }
+        if (pattern[j] == '\0') {
+            return &profile_store[i];
+        }
+    }
+
+    return nullptr;
+}
+
+const VehicleProfile_t* Profile_GetDefault(void) {
+    return &profile_store[0];
+}
+
+/* Generic profile from the ECU's bitmaps; nullptr if it supports none of the
+ * decodable PIDs (a profile with nothing to poll would never complete a cycle) */
+const VehicleProfile_t* Profile_BuildGeneric(const uint32_t supported_pids[3]) {
+    uint8_t count = 0;
+
+    for (size_t i = 0; i < sizeof(generic_candidates) / sizeof(generic_candidates[0]); i++) {
+        if (Profile_IsPIDSupported(supported_pids, generic_candidates[i].pid) && count < PROFILE_MAX_PIDS) {
+            generic_pids[count++] = generic_candidates[i];
+        }
+    }
+    if (count == 0) {
+        return nullptr;
+    }
+
+    generic_profile.name = "Generic OBD2";
+    generic_profile.vin_pattern = "";
+    memcpy(generic_profile.supported_pids, supported_pids, sizeof(generic_profile.supported_pids));
+    generic_profile.pids = generic_pids;
+    generic_profile.pid_count = count;
+    generic_profile.broadcasts = nullptr;
+    generic_profile.broadcast_count = 0;
+    generic_profile.displacement_cc = 0;
+    generic_profile.gear_count = 0;
+    memset(generic_profile.gear_ratio_x10, 0, sizeof(generic_profile.gear_ratio_x10));
+
+    return &generic_profile;
+}
@@ -0,0 +1,249 @@
+/**
+ * @file settings.cpp
+ * @brief Run-time settings and NVS persistence - Application layer
+ * @version 1.0
+ * @date 2025-11-16
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "settings.h"
+#include "sink_config.h"
+#include "obd2_handler.h"
+#include "logger.h"
+#include "heap_audit.h"
+
+#define SETTINGS_NVS_KEY            "all"
+
+static const uint32_t default_intervals[SETTINGS_RATE_COUNT] = {
+    SINK_BLE_INTERVAL_MS,
+    SINK_SERIAL_JSON_INTERVAL_MS,
+    SINK_SERIAL_BINARY_INTERVAL_MS,
+    SINK_LOGGER_INTERVAL_MS,
+    SINK_DISPLAY_INTERVAL_MS
+};
+
+static const bool rate_available[SETTINGS_RATE_COUNT] = {
+    SINK_BLE != 0,
+    SINK_SERIAL_JSON != 0,
+    SINK_SERIAL_BINARY != 0,
+    SINK_LOGGER != 0,
+    SINK_DISPLAY != 0
+};
+
+static const char* const rate_names[SETTINGS_RATE_COUNT] = {
+    "ble", "json", "binary", "log", "display"
+};
+
+// Sink intervals are valid before Settings_Init(), so sinks can run without it
+static Settings_t settings = {
+    SETTINGS_VERSION, LOG_LEVEL, 0,
+    { SINK_BLE_INTERVAL_MS, SINK_SERIAL_JSON_INTERVAL_MS, SINK_SERIAL_BINARY_INTERVAL_MS,
+      SINK_LOGGER_INTERVAL_MS, SINK_DISPLAY_INTERVAL_MS },
+    {}, 0, {}
+};
+
+static void Settings_ToFilterConfig(uint8_t slot, const SettingsFilter_t* filter, FilterConfig_t* config) {
+    const FilterConfig_t* current = Filter_GetConfig(slot);
+    config->key = (current != nullptr) ? current->key : nullptr;
+    config->median_window = filter->median_window;
+    config->smoother = filter->smoother;
+    config->ema_alpha_q8 = filter->ema_alpha_q8;
+    config->kalman_q = filter->kalman_q;
+    config->kalman_r = filter->kalman_r;
+    config->extrapolate = filter->extrapolate;
+}
+
+/* Push stored overrides to their owners; entries that no longer apply are dropped */
+static void Settings_Apply(void) {
+    Log_SetLevel(settings.log_level);
+
+    Settings_ApplyPIDPeriods();
+
+    for (uint8_t slot = 0; slot < FILTER_MAX_SIGNALS; slot++) {
+        if (settings.filter_mask & (1UL << slot)) {
+            FilterConfig_t config;
+            Settings_ToFilterConfig(slot, &settings.filters[slot], &config);
+            if (Filter_SetConfig(slot, &config) != STATUS_OK) {
+                settings.filter_mask &= ~(1UL << slot);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Apply the stored poll period overrides to the active profile
+ * @details Overrides for PIDs the profile does not poll are dropped. Before
+ *          OBD2 has a profile nothing can be applied and all are kept, so
+ *          the next Settings_Save() does not erase them; call again once a
+ *          profile is applied.
+ */
+void Settings_ApplyPIDPeriods(void) {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < settings.pid_count; i++) {
+        Status_t status = OBD2_SetPIDPeriod(settings.pid_periods[i].pid, settings.pid_periods[i].period_ms);
+        if (status == STATUS_OK || status == STATUS_NOT_INITIALIZED) {
+            settings.pid_periods[kept++] = settings.pid_periods[i];
+        }
+    }
+    settings.pid_count = kept;
+}
+
+/**
+ * @brief Load saved settings and apply them
+ * @details Call after the vehicle profile and display filters are set up.
+ * @return STATUS_OK, STATUS_ERROR if nothing valid was saved (defaults stay)
+ */
+Status_t Settings_Init(void) {
+    Settings_t saved;
+    bool loaded = false;
+    Preferences prefs;
+
+    if (prefs.begin(SETTINGS_NVS_NAMESPACE, true)) {
+        loaded = prefs.getBytesLength(SETTINGS_NVS_KEY) == sizeof(saved) &&
+                 prefs.getBytes(SETTINGS_NVS_KEY, &saved, sizeof(saved)) == sizeof(saved);
+        prefs.end();
+    }
+    if (!loaded || saved.version != SETTINGS_VERSION || saved.log_level > LOG_LEVEL_DEBUG ||
+        saved.pid_count > PROFILE_MAX_PIDS) {
+        return STATUS_ERROR;
+    }
+
+    settings = saved;
+    Settings_Apply();
+    return STATUS_OK;
+}
+
+/**
+ * @brief Store the current settings for the next boot
+ * @details Known pause: the flash write suspends the cache on both cores
+ *          for up to tens of milliseconds. Tasks running from flash stall,
+ *          the CAN RX task included, and frames that arrive meanwhile can
+ *          overrun the MCP2515's two receive buffers (hw_overflows in the
+ *          CAN statistics). Save while stationary if no frame may be lost.
+ * @return STATUS_OK, STATUS_ERROR if NVS could not be written
+ */
+Status_t Settings_Save(void) {
+    HEAP_AUDIT_EXEMPT();    // NVS allocates while writing
+    Preferences prefs;
+    if (!prefs.begin(SETTINGS_NVS_NAMESPACE, false)) {
+        return STATUS_ERROR;
+    }
+    size_t written = prefs.putBytes(SETTINGS_NVS_KEY, &settings, sizeof(settings));
+    prefs.end();
+    return (written == sizeof(settings)) ? STATUS_OK : STATUS_ERROR;
+}
+
+/* Back to the compiled defaults; saved settings are kept until the next Settings_Save() */
+void Settings_Reset(void) {
+    for (uint8_t i = 0; i < settings.pid_count; i++) {
+        OBD2_SetPIDPeriod(settings.pid_periods[i].pid, 0);
+    }
+    for (uint8_t slot = 0; slot < FILTER_MAX_SIGNALS; slot++) {
+        if (settings.filter_mask & (1UL << slot)) {
+            Filter_SetConfig(slot, nullptr);
+        }
+    }
+    for (uint8_t rate = 0; rate < SETTINGS_RATE_COUNT; rate++) {
+        settings.sink_interval_ms[rate] = default_intervals[rate];
+    }
+    settings.pid_count = 0;
+    settings.filter_mask = 0;
+    settings.log_level = LOG_LEVEL;
+    Log_SetLevel(LOG_LEVEL);
+}
+
+const Settings_t* Settings_Get(void) {
+    return &settings;
+}
+
+uint32_t Settings_GetSinkInterval(uint8_t rate) {
+    return (rate < SETTINGS_RATE_COUNT) ? settings.sink_interval_ms[rate] : 0;
+}
+
+/**
+ * @brief Change a sink's output interval
+ * @param rate SettingsRate_t
+ * @param interval_ms New interval, 0 pauses the sink
+ * @return STATUS_OK, STATUS_INVALID_PARAM if the sink is not in this build
+ */
+Status_t Settings_SetSinkInterval(uint8_t rate, uint32_t interval_ms) {
+    if (!Settings_RateAvailable(rate)) {
+        return STATUS_INVALID_PARAM;
+    }
+    settings.sink_interval_ms[rate] = interval_ms;
+    return STATUS_OK;
+}
+
+/**
+ * @brief Override the poll period of a profile PID
+ * @param pid Mode 01 PID
+ * @param period_ms New period, 0 restores the profile's
+ * @return STATUS_OK, STATUS_INVALID_PARAM if the profile does not poll the PID
+ */
+Status_t Settings_SetPIDPeriod(uint8_t pid, uint16_t period_ms) {
+    Status_t status = OBD2_SetPIDPeriod(pid, period_ms);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    uint8_t i = 0;
+    while (i < settings.pid_count && settings.pid_periods[i].pid != pid) {
+        i++;
+    }
+    if (period_ms == 0) {
+        if (i < settings.pid_count) {
+            settings.pid_periods[i] = settings.pid_periods[--settings.pid_count];
+        }
+    } else if (i < PROFILE_MAX_PIDS) {
+        settings.pid_periods[i].pid = pid;
+        settings.pid_periods[i].period_ms = period_ms;
+        if (i == settings.pid_count) {
+            settings.pid_count++;
+        }
+    }
+    return STATUS_OK;
+}
+
+/**
+ * @brief Override the parameters of a display filter slot
+ * @param slot Filter slot
+ * @param filter New parameters, nullptr restores the compiled ones
+ * @return STATUS_OK, STATUS_INVALID_PARAM for a bad slot or parameter, or
+ *         without the display sink (nothing would apply the change)
+ */
+Status_t Settings_SetFilter(uint8_t slot, const SettingsFilter_t* filter) {
+    if (slot >= FILTER_MAX_SIGNALS || !Settings_RateAvailable(SETTINGS_RATE_DISPLAY)) {
+        return STATUS_INVALID_PARAM;
+    }
+    if (filter == nullptr) {
+        Status_t status = Filter_SetConfig(slot, nullptr);
+        if (status == STATUS_OK) {
+            settings.filter_mask &= ~(1UL << slot);
+        }
+        return status;
+    }
+
+    FilterConfig_t config;
+    Settings_ToFilterConfig(slot, filter, &config);
+    Status_t status = Filter_SetConfig(slot, &config);
+    if (status == STATUS_OK) {
+        settings.filters[slot] = *filter;
+        settings.filter_mask |= 1UL << slot;
+    }
+    return status;
+}
+
+void Settings_SetLogLevel(uint8_t level) {
+    Log_SetLevel(level);
+    settings.log_level = Log_GetLevel();
+}
+
+const char* Settings_RateName(uint8_t rate) {
+    return (rate < SETTINGS_RATE_COUNT) ? rate_names[rate] : "?";
+}
+
+/* Whether the rate's sink is compiled into this build */
+bool Settings_RateAvailable(uint8_t rate) {
+    return rate < SETTINGS_RATE_COUNT && rate_available[rate];
+}
@@ -0,0 +1,270 @@
+/**
+ * @file signal_filter.cpp
+ * @brief Display-rate smoothing and interpolation - Application layer
+ * @version 1.0
+ * @date 2025-11-10
+ */
+
+#include <Arduino.h>
+#include "signal_filter.h"
+
+#define FILTER_DEFAULT_PERIOD_MS    200
+#define FILTER_MAX_PERIOD_MS        2000    /* Longer gaps do not update the period estimate */
+
+typedef struct {
+    SignalId_t signal;
+    uint32_t last_time;             /* Capture time of the last sample taken */
+    bool have_sample;
+    bool valid;
+
+    /* Median history */
+    int32_t history[FILTER_MAX_MEDIAN];
+    uint8_t history_head;
+    uint8_t history_count;
+
+    /* Smoother, Q8 */
+    int32_t filtered_q8;
+    uint32_t kalman_p;
+
+    /* Display ramp, Q8 */
+    uint32_t period_ms;
+    uint32_t ramp_start;
+    int32_t from_q8;
+    int32_t to_q8;
+    int32_t display_q8;
+} FilterState_t;
+
+static const FilterConfig_t* filter_defaults = nullptr;
+static FilterConfig_t filter_configs[FILTER_MAX_SIGNALS];
+static FilterState_t filters[FILTER_MAX_SIGNALS];
+
+/* Changes from other tasks wait here until the next Filter_Update() */
+static FilterConfig_t pending_configs[FILTER_MAX_SIGNALS];
+static uint32_t pending_mask = 0;
+static portMUX_TYPE pending_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t filter_count = 0;
+static uint32_t max_tick_us = 0;
+
+static int32_t Filter_Median(FilterState_t* f, uint8_t window, int32_t value) {
+    f->history[f->history_head] = value;
+    f->history_head = (f->history_head + 1) % window;
+    if (f->history_count < window) {
+        f->history_count++;
+        return value;
+    }
+
+    // Insertion sort of at most 5 values
+    int32_t sorted[FILTER_MAX_MEDIAN];
+    for (uint8_t i = 0; i < window; i++) {
+        int32_t v = f->history[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[window / 2];
+}
+
+static void Filter_Ingest(FilterState_t* f, const FilterConfig_t* config, int32_t value, uint32_t timestamp) {
+    if (config->median_window >= 3) {
+        value = Filter_Median(f, config->median_window, value);
+    }
+
+    int32_t measured_q8 = value * 256;
+    int32_t previous_q8 = f->filtered_q8;
+
+    if (!f->have_sample) {
+        f->filtered_q8 = measured_q8;
+        f->kalman_p = config->kalman_r;
+        previous_q8 = measured_q8;
+        f->display_q8 = measured_q8;
+    } else if (config->smoother == FILTER_SMOOTH_EMA) {
+        f->filtered_q8 += (int32_t)(((int64_t)(measured_q8 - f->filtered_q8) * config->ema_alpha_q8) >> 8);
+    } else if (config->smoother == FILTER_SMOOTH_KALMAN) {
+        // Scalar random-walk model: predict, then blend with gain K (Q16)
+        uint64_t p = (uint64_t)f->kalman_p + config->kalman_q;
+        uint32_t gain_q16 = (p + config->kalman_r > 0) ? (uint32_t)((p << 16) / (p + config->kalman_r)) : 65536;
+        f->filtered_q8 += (int32_t)(((int64_t)(measured_q8 - f->filtered_q8) * gain_q16) >> 16);
+        f->kalman_p = (uint32_t)((p * (65536 - gain_q16)) >> 16);
+    } else {
+        f->filtered_q8 = measured_q8;
+    }
+
+    if (f->have_sample) {
+        uint32_t dt = timestamp - f->last_time;
+        if (dt > 0 && dt <= FILTER_MAX_PERIOD_MS) {
+            f->period_ms = (f->period_ms * 3 + dt) / 4;
+        }
+    }
+
+    // Ramp from what is on screen now to the new target over one period
+    f->from_q8 = f->display_q8;
+    f->to_q8 = f->filtered_q8;
+    if (config->extrapolate) {
+        f->to_q8 += f->filtered_q8 - previous_q8;
+    }
+    f->ramp_start = millis();
+    f->last_time = timestamp;
+    f->have_sample = true;
+}
+
+Status_t Filter_Init(const FilterConfig_t* configs, uint8_t count) {
+    if ((configs == nullptr && count > 0) || count > FILTER_MAX_SIGNALS) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    filter_defaults = configs;
+    filter_count = 0;
+    pending_mask = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        SignalId_t signal = SignalStore_Find(configs[i].key);
+        if (signal == SIGNAL_ID_INVALID || configs[i].median_window > FILTER_MAX_MEDIAN) {
+            return STATUS_INVALID_PARAM;
+        }
+
+        filter_configs[i] = configs[i];
+        FilterState_t* f = &filters[i];
+        memset(f, 0, sizeof(*f));
+        f->signal = signal;
+        f->period_ms = FILTER_DEFAULT_PERIOD_MS;
+        filter_count++;
+    }
+
+    return STATUS_OK;
+}
+
+/**
+ * @brief Replace a slot's filter parameters (any task)
+ * @details Takes effect at the next Filter_Update(); the median restarts
+ *          with the new window. The key is kept.
+ * @param slot Filter slot
+ * @param config New parameters, nullptr restores the Filter_Init() ones
+ * @return STATUS_OK, STATUS_INVALID_PARAM for a bad slot or parameter
+ */
+Status_t Filter_SetConfig(uint8_t slot, const FilterConfig_t* config) {
+    if (slot >= filter_count) {
+        return STATUS_INVALID_PARAM;
+    }
+    if (config == nullptr) {
+        config = &filter_defaults[slot];
+    }
+    if (config->median_window > FILTER_MAX_MEDIAN || config->smoother > FILTER_SMOOTH_KALMAN) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    portENTER_CRITICAL(&pending_mux);
+    pending_configs[slot] = *config;
+    pending_configs[slot].key = filter_defaults[slot].key;
+    pending_mask |= 1UL << slot;
+    portEXIT_CRITICAL(&pending_mux);
+    return STATUS_OK;
+}
+
+const FilterConfig_t* Filter_GetConfig(uint8_t slot) {
+    return (slot < filter_count) ? &filter_configs[slot] : nullptr;
+}
+
+/**
+ * @brief Copy a slot's parameters as last set, applied or still pending (any task)
+ * @param slot Filter slot
+ * @param config Receives the parameters
+ * @return STATUS_OK, STATUS_INVALID_PARAM for a bad slot
+ */
+Status_t Filter_GetLatestConfig(uint8_t slot, FilterConfig_t* config) {
+    if (slot >= filter_count || config == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    portENTER_CRITICAL(&pending_mux);
+    *config = (pending_mask & (1UL << slot)) ? pending_configs[slot] : filter_configs[slot];
+    portEXIT_CRITICAL(&pending_mux);
+    return STATUS_OK;
+}
+
+static void Filter_ApplyPending(void) {
+    if (pending_mask == 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&pending_mux);
+    for (uint8_t i = 0; i < filter_count; i++) {
+        if (pending_mask & (1UL << i)) {
+            filter_configs[i] = pending_configs[i];
+            filters[i].history_head = 0;
+            filters[i].history_count = 0;
+        }
+    }
+    pending_mask = 0;
+    portEXIT_CRITICAL(&pending_mux);
+}
+
+void Filter_Update(void) {
+    Filter_ApplyPending();
+
+    for (uint8_t i = 0; i < filter_count; i++) {
+        FilterState_t* f = &filters[i];
+
+        // Runs in the display task while the loop writes the store
+        SignalSample_t sample;
+        if (!SignalStore_GetSample(f->signal, &sample) || sample.quality != SIGNAL_QUALITY_VALID) {
+            f->valid = false;
+            continue;
+        }
+
+        if (!f->have_sample || sample.timestamp != f->last_time) {
+            Filter_Ingest(f, &filter_configs[i], sample.raw, sample.timestamp);
+        }
+        f->valid = true;
+    }
+}
+
+void Filter_Tick(uint32_t now) {
+    uint32_t start = micros();
+
+    for (uint8_t i = 0; i < filter_count; i++) {
+        FilterState_t* f = &filters[i];
+        if (!f->have_sample) {
+            continue;
+        }
+
+        uint32_t elapsed = now - f->ramp_start;
+        if (elapsed >= f->period_ms) {
+            f->display_q8 = f->to_q8;
+        } else {
+            f->display_q8 = f->from_q8 + (int32_t)((int64_t)(f->to_q8 - f->from_q8) * elapsed / f->period_ms);
+        }
+    }
+
+    uint32_t cost = micros() - start;
+    if (cost > max_tick_us) {
+        max_tick_us = cost;
+    }
+}
+
+uint8_t Filter_Count(void) {
+    return filter_count;
+}
+
+SignalId_t Filter_GetSignal(uint8_t slot) {
+    return (slot < filter_count) ? filters[slot].signal : SIGNAL_ID_INVALID;
+}
+
+int32_t Filter_GetDisplayQ8(uint8_t slot) {
+    return (slot < filter_count) ? filters[slot].display_q8 : 0;
+}
+
+int32_t Filter_GetDisplay(uint8_t slot) {
+    // Round to nearest store unit
+    return (slot < filter_count) ? (filters[slot].display_q8 + 128) >> 8 : 0;
+}
+
+bool Filter_IsValid(uint8_t slot) {
+    return slot < filter_count && filters[slot].valid;
+}
+
+uint32_t Filter_GetMaxTickUs(void) {
+    return max_tick_us;
+}
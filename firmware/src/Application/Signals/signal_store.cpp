@@ -0,0 +1,234 @@
+/**
+ * @file signal_store.cpp
+ * @brief Structure-of-arrays signal registry - Application layer
+ * @version 1.0
+ * @date 2025-11-06
+ */
+
+#include <Arduino.h>
+#include "signal_store.h"
+
+/* Hot data: touched on every update and every encoder pass */
+static int32_t signal_values[SIGNAL_STORE_CAPACITY];
+static uint32_t signal_timestamps[SIGNAL_STORE_CAPACITY];
+static uint32_t signal_rx_us[SIGNAL_STORE_CAPACITY];     /* micros() of the CAN frame, 0 if computed */
+static uint8_t signal_quality[SIGNAL_STORE_CAPACITY];
+static uint32_t signal_stale_ms[SIGNAL_STORE_CAPACITY];
+
+/* Cold data: descriptors, only read by encoders */
+static const char* signal_keys[SIGNAL_STORE_CAPACITY];
+static const char* signal_labels[SIGNAL_STORE_CAPACITY];
+static const char* signal_units[SIGNAL_STORE_CAPACITY];
+static uint16_t signal_scales[SIGNAL_STORE_CAPACITY];
+
+static uint8_t signal_count = 0;
+
+/* Keeps a sample's fields together for readers in other tasks */
+static portMUX_TYPE sample_mux = portMUX_INITIALIZER_UNLOCKED;
+
+Status_t SignalStore_Init(void) {
+    signal_count = 0;
+
+    // Registration order must match VehicleSignal_t
+    SignalStore_Register("rpm", "Engine RPM", "rpm", 1, SIGNAL_STALE_MIN_MS);
+    SignalStore_Register("speed", "Speed", "km/h", 1, SIGNAL_STALE_MIN_MS);
+    SignalStore_Register("coolant_temp", "Coolant", "C", 1, SIGNAL_STALE_MIN_MS);
+    SignalStore_Register("throttle_position", "Throttle", "%", 1, SIGNAL_STALE_MIN_MS);
+    SignalStore_Register("fuel_level", "Fuel", "%", 1, SIGNAL_STALE_MIN_MS);
+    SignalStore_Register("engine_runtime", "Engine runtime", "s", 1, SIGNAL_STALE_MIN_MS);
+
+    return (signal_count == SIGNAL_COUNT) ? STATUS_OK : STATUS_ERROR;
+}
+
+/* Scales are decimal so values format exactly (SignalStore_FormatRaw) */
+static bool SignalStore_IsDecimalScale(uint16_t scale) {
+    while (scale >= 10 && scale % 10 == 0) {
+        scale /= 10;
+    }
+    return scale == 1;
+}
+
+SignalId_t SignalStore_Register(const char* key, const char* label, const char* unit, uint16_t scale, uint32_t stale_ms) {
+    if (key == nullptr || !SignalStore_IsDecimalScale(scale) || signal_count >= SIGNAL_STORE_CAPACITY) {
+        return SIGNAL_ID_INVALID;
+    }
+
+    SignalId_t id = signal_count++;
+    signal_values[id] = 0;
+    signal_timestamps[id] = 0;
+    signal_rx_us[id] = 0;
+    signal_quality[id] = SIGNAL_QUALITY_NONE;
+    signal_stale_ms[id] = stale_ms;
+    signal_keys[id] = key;
+    signal_labels[id] = (label != nullptr) ? label : key;
+    signal_units[id] = (unit != nullptr) ? unit : "";
+    signal_scales[id] = scale;
+
+    return id;
+}
+
+SignalId_t SignalStore_Find(const char* key) {
+    if (key == nullptr) {
+        return SIGNAL_ID_INVALID;
+    }
+
+    for (uint8_t i = 0; i < signal_count; i++) {
+        if (strcmp(signal_keys[i], key) == 0) {
+            return i;
+        }
+    }
+    return SIGNAL_ID_INVALID;
+}
+
+uint8_t SignalStore_Count(void) {
+    return signal_count;
+}
+
+/* Value computed on the ESP32 (derived, statistics); no bus receive time */
+void SignalStore_Set(SignalId_t id, int32_t raw, uint32_t timestamp) {
+    SignalStore_SetSample(id, raw, timestamp, 0);
+}
+
+/* Value acquired from a CAN frame read at rx_time_us (micros) */
+void SignalStore_SetSample(SignalId_t id, int32_t raw, uint32_t timestamp, uint32_t rx_time_us) {
+    if (id >= signal_count) {
+        return;
+    }
+
+    portENTER_CRITICAL(&sample_mux);
+    signal_values[id] = raw;
+    signal_timestamps[id] = timestamp;
+    signal_rx_us[id] = rx_time_us;
+    signal_quality[id] = SIGNAL_QUALITY_VALID;
+    portEXIT_CRITICAL(&sample_mux);
+}
+
+void SignalStore_MarkFailed(SignalId_t id) {
+    // A signal that never had a value stays "none"
+    if (id < signal_count && signal_quality[id] != SIGNAL_QUALITY_NONE) {
+        portENTER_CRITICAL(&sample_mux);
+        signal_quality[id] = SIGNAL_QUALITY_FAILED;
+        portEXIT_CRITICAL(&sample_mux);
+    }
+}
+
+void SignalStore_SetStaleLimit(SignalId_t id, uint32_t stale_ms) {
+    if (id < signal_count) {
+        signal_stale_ms[id] = stale_ms;
+    }
+}
+
+void SignalStore_AgeOut(uint32_t now) {
+    for (uint8_t i = 0; i < signal_count; i++) {
+        if (signal_quality[i] == SIGNAL_QUALITY_VALID && (now - signal_timestamps[i]) > signal_stale_ms[i]) {
+            portENTER_CRITICAL(&sample_mux);
+            signal_quality[i] = SIGNAL_QUALITY_STALE;
+            portEXIT_CRITICAL(&sample_mux);
+        }
+    }
+}
+
+int32_t SignalStore_GetRaw(SignalId_t id) {
+    return (id < signal_count) ? signal_values[id] : 0;
+}
+
+uint32_t SignalStore_GetTimestamp(SignalId_t id) {
+    return (id < signal_count) ? signal_timestamps[id] : 0;
+}
+
+uint32_t SignalStore_GetRxTime(SignalId_t id) {
+    return (id < signal_count) ? signal_rx_us[id] : 0;
+}
+
+uint8_t SignalStore_GetQuality(SignalId_t id) {
+    return (id < signal_count) ? signal_quality[id] : (uint8_t)SIGNAL_QUALITY_NONE;
+}
+
+/* Value, times and quality from the same update; safe from any task */
+bool SignalStore_GetSample(SignalId_t id, SignalSample_t* sample) {
+    if (id >= signal_count || sample == nullptr) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&sample_mux);
+    sample->raw = signal_values[id];
+    sample->timestamp = signal_timestamps[id];
+    sample->rx_time_us = signal_rx_us[id];
+    sample->quality = signal_quality[id];
+    portEXIT_CRITICAL(&sample_mux);
+    return true;
+}
+
+const char* SignalStore_GetKey(SignalId_t id) {
+    return (id < signal_count) ? signal_keys[id] : "";
+}
+
+const char* SignalStore_GetLabel(SignalId_t id) {
+    return (id < signal_count) ? signal_labels[id] : "";
+}
+
+const char* SignalStore_GetUnit(SignalId_t id) {
+    return (id < signal_count) ? signal_units[id] : "";
+}
+
+uint16_t SignalStore_GetScale(SignalId_t id) {
+    return (id < signal_count) ? signal_scales[id] : 1;
+}
+
+/**
+ * @brief Format the physical value of a signal (raw / scale) as decimal text
+ * @return Number of characters written (snprintf semantics)
+ */
+int SignalStore_FormatValue(SignalId_t id, char* buffer, size_t size) {
+    if (id >= signal_count) {
+        return 0;
+    }
+    return SignalStore_FormatRaw(id, signal_values[id], buffer, size);
+}
+
+int SignalStore_FormatRaw(SignalId_t id, int32_t raw, char* buffer, size_t size) {
+    if (id >= signal_count || buffer == nullptr || size == 0) {
+        return 0;
+    }
+
+    uint16_t scale = signal_scales[id];
+    if (scale == 1) {
+        return snprintf(buffer, size, "%ld", (long)raw);
+    }
+
+    // Decimal places follow the scale (10 -> 1, 100 -> 2, ...)
+    uint8_t decimals = 0;
+    for (uint16_t s = scale; s >= 10; s /= 10) {
+        decimals++;
+    }
+    uint32_t magnitude = (raw < 0) ? (uint32_t)(-(int64_t)raw) : (uint32_t)raw;
+    return snprintf(buffer, size, "%s%lu.%0*lu", (raw < 0) ? "-" : "",
+                    (unsigned long)(magnitude / scale), decimals, (unsigned long)(magnitude % scale));
+}
+
+const char* SignalStore_QualityName(uint8_t quality) {
+    switch (quality) {
+        case SIGNAL_QUALITY_VALID:  return "valid";
+        case SIGNAL_QUALITY_STALE:  return "stale";
+        case SIGNAL_QUALITY_FAILED: return "failed";
+        default:                    return "none";
+    }
+}
+
+void SignalStore_FillVehicleData(VehicleData_t* view) {
+    if (view == nullptr) {
+        return;
+    }
+
+    view->rpm = (uint16_t)signal_values[SIGNAL_RPM];
+    view->speed = (uint8_t)signal_values[SIGNAL_SPEED];
+    view->coolantTemp = (int8_t)signal_values[SIGNAL_COOLANT_TEMP];
+    view->throttlePosition = (uint8_t)signal_values[SIGNAL_THROTTLE_POSITION];
+    view->fuelLevel = (uint8_t)signal_values[SIGNAL_FUEL_LEVEL];
+    view->engineRuntime = (uint32_t)signal_values[SIGNAL_ENGINE_RUNTIME];
+
+    for (uint8_t i = 0; i < SIGNAL_COUNT; i++) {
+        view->status[i].timestamp = signal_timestamps[i];
+        view->status[i].quality = signal_quality[i];
+    }
+}
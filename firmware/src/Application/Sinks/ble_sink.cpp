@@ -0,0 +1,78 @@
+/**
+ * @file ble_sink.cpp
+ * @brief BLE output sink - Application layer
+ * @version 1.0
+ * @date 2025-11-15
+ */
+
+#include "output_sinks.h"
+
+#if SINK_BLE
+
+#include <Arduino.h>
+#include "ble_service.h"
+#include "anomaly_detector.h"
+#include "settings.h"
+#include "logger.h"
+#if SINK_HTTP
+#include <WiFi.h>
+#endif
+
+void BleSink::begin(void) {
+    Serial.println("Initializing BLE service...");
+    BLEConfig_t ble_config = {
+        .device_name = BLE_DEVICE_NAME,
+        .auto_advertise = true,
+        .mtu_size = 517  // Maximum MTU for better throughput
+    };
+    
+    Status_t ble_status = BLE_Init(&ble_config);
+    if (ble_status == STATUS_OK) {
+        Serial.println("✓ BLE service initialized successfully");
+        Serial.println("  Device is now discoverable as: " BLE_DEVICE_NAME);
+        Serial.println("  Desktop app can connect via Bluetooth");
+    } else {
+        Serial.println("✗ BLE initialization failed");
+    }
+}
+
+void BleSink::service(uint32_t now) {
+    static uint32_t last_send = 0;
+    static uint32_t last_check = 0;
+    static uint32_t last_status_send = 0;
+    static uint32_t last_alert_change = 0;
+    
+    // Update BLE connection status
+    BLE_UpdateStatus();
+    
+    // Send data via BLE if connected; interval 0 pauses data, status still flows
+    uint32_t interval = Settings_GetSinkInterval(SETTINGS_RATE_BLE);
+    if (interval != 0 && BLE_IsConnected() && now - last_send >= interval) {
+        BLE_SendVehicleData(&last_vehicle_data);
+        last_send = now;
+    }
+    
+    // Check BLE connection timeout every 2 seconds
+    if (now - last_check >= 2000) {
+        if (g_bleService) {
+            g_bleService->checkConnectionTimeout();
+        }
+        last_check = now;
+    }
+    
+    // Push alerts on change, otherwise refresh the status every 5 seconds
+    uint32_t alert_change = Anomaly_GetChangeCount();
+    if (alert_change != last_alert_change || now - last_status_send >= 5000) {
+        const char* alerts[ALERT_MAX_ACTIVE];
+        uint8_t alert_count = Anomaly_GetActiveNames(alerts, ALERT_MAX_ACTIVE);
+#if SINK_HTTP
+        BLE_SendSystemStatus(current_state, WiFi.status() == WL_CONNECTED, WiFi.RSSI(), alerts, alert_count);
+#else
+        BLE_SendSystemStatus(current_state, false, 0, alerts, alert_count);
+#endif
+        last_alert_change = alert_change;
+        last_status_send = now;
+    }
+}
+
+#endif /* SINK_BLE */
@@ -0,0 +1,61 @@
+/**
+ * @file display_sink.cpp
+ * @brief Display-rate output sink - Application layer
+ * @version 1.0
+ * @date 2025-11-15
+ */
+
+#include "output_sinks.h"
+
+#if SINK_DISPLAY
+
+#include <Arduino.h>
+#include "signal_filter.h"
+#include "latency_monitor.h"
+#include "settings.h"
+#include "health_monitor.h"
+#include "heap_audit.h"
+
+#define DISPLAY_TASK_STACK          2048
+#define DISPLAY_TASK_PRIORITY       2       /* Above the loop task, which blocks in OBD2 reads */
+#define DISPLAY_TICK_BUDGET_US      2000
+#define DISPLAY_PAUSED_POLL_MS      100     /* Interval check while the sink is paused */
+
+static TaskHandle_t display_task = nullptr;
+
+// Render smoothed display values independently of the bus rate
+static void Display_Task(void* param) {
+    int8_t health = Health_Register("display", DISPLAY_TICK_BUDGET_US, HEALTH_FLAG_TASK);
+    HEAP_AUDIT_WATCH();
+    TickType_t wake = xTaskGetTickCount();
+    
+    for (;;) {
+        uint32_t interval = Settings_GetSinkInterval(SETTINGS_RATE_DISPLAY);
+        TickType_t period = pdMS_TO_TICKS(interval != 0 ? interval : DISPLAY_PAUSED_POLL_MS);
+        vTaskDelayUntil(&wake, period > 0 ? period : 1);
+        if (interval == 0) {
+            continue;
+        }
+        
+        Health_Begin(health);
+        Filter_Update();
+        Filter_Tick(millis());
+        
+        uint32_t rendered_us = micros();
+        for (uint8_t slot = 0; slot < Filter_Count(); slot++) {
+            Latency_RecordSignal(LATENCY_SINK_DISPLAY, Filter_GetSignal(slot), rendered_us);
+        }
+        Health_End(health);
+    }
+}
+
+/* Ticks run in their own task: from the loop, OBD2 reads held them to a few Hz */
+void DisplaySink::begin(void) {
+    if (display_task == nullptr &&
+        xTaskCreatePinnedToCore(Display_Task, "display", DISPLAY_TASK_STACK, nullptr,
+                                DISPLAY_TASK_PRIORITY, &display_task, tskNO_AFFINITY) != pdPASS) {
+        display_task = nullptr;
+    }
+}
+
+#endif /* SINK_DISPLAY */
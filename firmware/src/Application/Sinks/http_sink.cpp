@@ -0,0 +1,582 @@
+/**
+ * @file http_sink.cpp
+ * @brief WiFi and web server output sink - Application layer
+ * @version 1.0
+ * @date 2025-11-15
+ */
+
+#include "output_sinks.h"
+
+#if SINK_HTTP
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <WiFi.h>
+#include <WebServer.h>
+#include "can_interface.h"
+#include "obd2_handler.h"
+#include "signal_stats.h"
+#include "anomaly_detector.h"
+#include "perf_timer.h"
+#include "signal_filter.h"
+#include "trace.h"
+#include "latency_monitor.h"
+#include "health_monitor.h"
+#include "heap_audit.h"
+#include "logger.h"
+
+// WiFi credentials
+static const char* ssid = "YOUR_WIFI_SSID";
+static const char* password = "YOUR_WIFI_PASSWORD";
+
+static WebServer server(80);
+
+// HTTP response body shared by the handlers (WebServer serves one request
+// at a time). Chunked pages are flushed whenever the buffer fills.
+static char http_response[HTTP_RESPONSE_SIZE];
+static size_t http_response_length = 0;
+static bool http_response_chunked = false;
+static bool http_response_truncated = false;
+
+static void response_begin(void) {
+    http_response_length = 0;
+    http_response[0] = '\0';
+    http_response_chunked = false;
+    http_response_truncated = false;
+}
+
+static void response_flush(void) {
+    if (http_response_length > 0) {
+        HEAP_AUDIT_EXEMPT();    // lwIP may allocate send buffers
+        server.sendContent(http_response, http_response_length);
+    }
+    http_response_length = 0;
+    http_response[0] = '\0';
+}
+
+// Send a PROGMEM string as its own chunk, straight from flash (chunked responses only)
+static void response_write_P(const char* text) {
+    response_flush();
+    HEAP_AUDIT_EXEMPT();
+    server.sendContent_P(text);
+}
+
+// Append formatted text; sets the truncated flag when it does not fit
+static void response_printf(const char* format, ...) {
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        size_t space = sizeof(http_response) - http_response_length;
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(&http_response[http_response_length], space, format, args);
+        va_end(args);
+        
+        if (length >= 0 && (size_t)length < space) {
+            http_response_length += length;
+            return;
+        }
+        http_response[http_response_length] = '\0';    // Drop the partial write
+        if (!http_response_chunked || http_response_length == 0) {
+            break;
+        }
+        response_flush();
+    }
+    http_response_truncated = true;
+}
+
+static void response_send(int code, const char* content_type) {
+    HEAP_AUDIT_EXEMPT();    // WebServer builds the header block in a String
+    server.sendHeader("Access-Control-Allow-Origin", "*");
+    if (http_response_truncated) {
+        server.send(500, "application/json", "{\"error\":\"response too large\"}");
+        return;
+    }
+    server.send_P(code, content_type, http_response, http_response_length);
+}
+
+static void response_begin_chunked(const char* content_type) {
+    response_begin();
+    http_response_chunked = true;
+    
+    HEAP_AUDIT_EXEMPT();
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, content_type, "");
+}
+
+static void response_end_chunked(void) {
+    // The status line is already out: mark the gap in the body instead
+    if (http_response_truncated) {
+        LOG_WARN("HTTP: output larger than %u bytes dropped from a chunked response", (unsigned)HTTP_RESPONSE_SIZE);
+        response_printf("\n[response truncated]\n");
+    }
+    response_flush();
+    HEAP_AUDIT_EXEMPT();
+    server.sendContent("");    // Ends the chunked response
+}
+
+// Query argument copied into a fixed buffer; false if absent
+static bool request_arg(const char* name, char* value, size_t size) {
+    HEAP_AUDIT_EXEMPT();    // WebServer compares and returns arguments as String
+    if (!server.hasArg(name)) {
+        return false;
+    }
+    if (value != nullptr && size > 0) {
+        snprintf(value, size, "%s", server.arg(name).c_str());
+    }
+    return true;
+}
+
+static void append_can_rx_json(void) {
+    CAN_RxStats_t rx;
+    CAN_GetRxStats(&rx);
+    CAN_ErrorStats_t err;
+    CAN_GetErrorStats(&err);
+    
+    response_printf("{\"frames\":%lu,\"hw_overflows\":%lu,\"queue_overflows\":%lu,\"max_burst\":%u,"
+                    "\"queue_high_water\":%u,\"eflg\":%u,\"tec\":%u,\"rec\":%u,\"max_tec\":%u,\"max_rec\":%u,"
+                    "\"error_warnings\":%lu,\"error_passive\":%lu,\"bus_off\":%lu,"
+                    "\"seq_frames\":%lu,\"seq_lost\":%lu,"
+                    "\"error_state\":{\"state\":\"%s\",\"active_ms\":%lu,\"passive_ms\":%lu,\"bus_off_ms\":%lu,"
+                    "\"recovery_attempts\":%lu,\"recoveries\":%lu,\"last_recovery_ms\":%lu,\"max_recovery_ms\":%lu,"
+                    "\"backoff_ms\":%lu}}",
+                    (unsigned long)rx.frames, (unsigned long)rx.hw_overflows, (unsigned long)rx.queue_overflows,
+                    rx.max_burst, rx.queue_high_water, rx.eflg, rx.tec, rx.rec, rx.max_tec, rx.max_rec,
+                    (unsigned long)rx.error_warnings, (unsigned long)rx.error_passive, (unsigned long)rx.bus_off,
+                    (unsigned long)rx.seq_frames, (unsigned long)rx.seq_lost,
+                    CAN_ErrorStateName(err.state), (unsigned long)err.residency_ms[CAN_ERROR_ACTIVE],
+                    (unsigned long)err.residency_ms[CAN_ERROR_PASSIVE], (unsigned long)err.residency_ms[CAN_ERROR_BUS_OFF],
+                    (unsigned long)err.recovery_attempts, (unsigned long)err.recoveries,
+                    (unsigned long)err.last_recovery_ms, (unsigned long)err.max_recovery_ms, (unsigned long)err.backoff_ms);
+}
+
+// CAN receive to sink latency per output: samples counted, p50/p99/max in microseconds
+static void append_latency_json(void) {
+    response_printf("{");
+    for (uint8_t sink = 0; sink < LATENCY_SINK_COUNT; sink++) {
+        const LatencyHistogram_t* h = Latency_Get(sink);
+        response_printf("%s\"%s\":{\"count\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu}",
+                        (sink > 0) ? "," : "", Latency_SinkName(sink), (unsigned long)h->count,
+                        (unsigned long)Latency_Percentile(h, 0.5f), (unsigned long)Latency_Percentile(h, 0.99f),
+                        (unsigned long)h->max_us);
+    }
+    response_printf("}");
+}
+
+// Age (or quality) caption shown under each gauge
+static void gauge_age(SignalId_t id, char* caption, size_t size) {
+    uint8_t quality = SignalStore_GetQuality(id);
+    if (quality == SIGNAL_QUALITY_NONE) {
+        snprintf(caption, size, "no data");
+        return;
+    }
+    int length = snprintf(caption, size, "%lu ms ago", (unsigned long)(millis() - SignalStore_GetTimestamp(id)));
+    if (quality != SIGNAL_QUALITY_VALID && length > 0 && (size_t)length < size) {
+        snprintf(caption + length, size - length, " (%s)", SignalStore_QualityName(quality));
+    }
+}
+
+// One gauge per signal that has produced data (core gauges are always shown)
+static void gauge_html(void) {
+    char value[24];
+    char caption[48];
+    
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        if (id > SIGNAL_THROTTLE_POSITION && SignalStore_GetQuality(id) == SIGNAL_QUALITY_NONE) {
+            continue;
+        }
+        SignalStore_FormatValue(id, value, sizeof(value));
+        gauge_age(id, caption, sizeof(caption));
+        const char* unit = SignalStore_GetUnit(id);
+        
+        response_printf(R"(
+            <div class='gauge'>
+                <div class='gauge-value'>%s</div>
+                <div class='gauge-label'>%s%s%s%s</div>
+                <div class='gauge-age'>%s</div>
+            </div>)",
+                        value, SignalStore_GetLabel(id), (unit[0] != '\0') ? " (" : "", unit,
+                        (unit[0] != '\0') ? ")" : "", caption);
+    }
+}
+
+// Static part of the dashboard, sent from flash
+static const char root_page_head[] PROGMEM = R"(
+<!DOCTYPE html>
+<html>
+<head>
+    <title>Svartpilen 401 OBD2 Monitor</title>
+    <meta http-equiv='refresh' content='2'>
+    <meta name='viewport' content='width=device-width, initial-scale=1'>
+    <style>
+        body { 
+            font-family: Arial, sans-serif; 
+            margin: 0; 
+            padding: 20px; 
+            background: linear-gradient(135deg, #1a1a1a, #2d2d2d); 
+            color: #fff; 
+        }
+        .container { 
+            max-width: 800px; 
+            margin: 0 auto; 
+        }
+        .header {
+            text-align: center;
+            margin-bottom: 30px;
+            padding: 20px;
+            background: rgba(255, 107, 53, 0.1);
+            border-radius: 10px;
+            border: 2px solid #ff6b35;
+        }
+        .gauge { 
+            display: inline-block; 
+            margin: 15px; 
+            text-align: center; 
+            background: rgba(255, 255, 255, 0.1);
+            padding: 20px;
+            border-radius: 10px;
+            min-width: 150px;
+        }
+        .gauge-value { 
+            font-size: 2.5em; 
+            font-weight: bold; 
+            color: #ff6b35; 
+            margin-bottom: 10px;
+        }
+        .gauge-label { 
+            font-size: 1.2em; 
+            color: #ccc;
+        }
+        .gauge-age {
+            font-size: 0.8em;
+            color: #888;
+        }
+        .status { 
+            padding: 15px; 
+            border-radius: 10px; 
+            margin: 20px 0; 
+            text-align: center;
+            font-size: 1.3em;
+            font-weight: bold;
+        }
+        .running { 
+            background: linear-gradient(135deg, #4CAF50, #45a049); 
+        }
+        .stopped { 
+            background: linear-gradient(135deg, #f44336, #d32f2f); 
+        }
+    </style>
+</head>
+<body>
+    <div class='container'>
+        <div class='header'>
+            <h1> Husqvarna Svartpilen 401</h1>
+            <h2>Professional OBD2 Diagnostics</h2>
+            <p>Layered Architecture System</p>
+        </div>
+        
+        <div class='status )";
+
+static void handleRoot(void) {
+    TRACE_SCOPE(TRACE_EV_HTTP_REQUEST, TRACE_HTTP_ROOT);
+    HEAP_AUDIT_STRICT();
+    
+    response_begin_chunked("text/html");
+    response_write_P(root_page_head);
+    response_printf("%s", last_vehicle_data.engineRunning ? "running'> Engine: RUNNING" : "stopped'> Engine: STOPPED");
+    response_printf(R"('></div>
+        
+        <div style='text-align: center;'>)");
+    gauge_html();
+    response_printf(R"(
+        </div>
+        
+        <div style='text-align: center; margin-top: 30px; color: #888;'>
+            <p>System State: %d</p>
+            <p>Last update: %lu ms ago</p>
+            <p>Uptime: %lu seconds</p>
+        </div>
+    </div>
+</body>
+</html>)",
+                    current_state, (unsigned long)(millis() - last_vehicle_data.lastUpdate),
+                    (unsigned long)(millis() / 1000));
+    response_end_chunked();
+}
+
+static void handleData(void) {
+    TRACE_SCOPE(TRACE_EV_HTTP_REQUEST, TRACE_HTTP_DATA);
+    HEAP_AUDIT_STRICT();
+    
+    // Optional ?since=<uptime ms>: only signals captured after that time
+    uint32_t since = 0;
+    char since_arg[16];
+    if (request_arg("since", since_arg, sizeof(since_arg))) {
+        since = strtoul(since_arg, nullptr, 10);
+    }
+    uint32_t now = millis();
+    
+    char value[24];
+    uint64_t sent_mask = 0;     // Signals in this response, also for latency accounting
+    
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        uint8_t signal_quality = SignalStore_GetQuality(id);
+        uint32_t timestamp = SignalStore_GetTimestamp(id);
+        if (signal_quality == SIGNAL_QUALITY_NONE || (since != 0 && (int32_t)(timestamp - since) <= 0)) {
+            continue;
+        }
+        sent_mask |= 1ULL << id;
+    }
+    
+    response_begin();
+    response_printf("{");
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        if (sent_mask & (1ULL << id)) {
+            SignalStore_FormatValue(id, value, sizeof(value));
+            response_printf("\"%s\":%s,", SignalStore_GetKey(id), value);
+        }
+    }
+    
+    bool first = true;
+    response_printf("\"age\":{");
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        if (sent_mask & (1ULL << id)) {
+            response_printf("%s\"%s\":%lu", first ? "" : ",", SignalStore_GetKey(id),
+                            (unsigned long)(now - SignalStore_GetTimestamp(id)));
+            first = false;
+        }
+    }
+    
+    first = true;
+    response_printf("},\"quality\":{");
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        if (sent_mask & (1ULL << id)) {
+            response_printf("%s\"%s\":\"%s\"", first ? "" : ",", SignalStore_GetKey(id),
+                            SignalStore_QualityName(SignalStore_GetQuality(id)));
+            first = false;
+        }
+    }
+    response_printf("},");
+    
+    // Smoothed, interpolated values for gauges
+    response_printf("\"display\":{");
+    first = true;
+    for (uint8_t slot = 0; slot < Filter_Count(); slot++) {
+        if (!Filter_IsValid(slot)) {
+            continue;
+        }
+        SignalId_t id = Filter_GetSignal(slot);
+        SignalStore_FormatRaw(id, Filter_GetDisplay(slot), value, sizeof(value));
+        response_printf("%s\"%s\":%s", first ? "" : ",", SignalStore_GetKey(id), value);
+        first = false;
+    }
+    response_printf("},\"displayTickUs\":%lu,\"engineRunning\":%s,\"dataValid\":%s,\"systemState\":%d,"
+                    "\"lastUpdate\":%lu,\"uptime\":%lu}",
+                    (unsigned long)Filter_GetMaxTickUs(), last_vehicle_data.engineRunning ? "true" : "false",
+                    last_vehicle_data.dataValid ? "true" : "false", current_state,
+                    (unsigned long)last_vehicle_data.lastUpdate, (unsigned long)now);
+    
+    response_send(200, "application/json");
+    
+    uint32_t sent_us = micros();
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        if (sent_mask & (1ULL << id)) {
+            Latency_RecordSignal(LATENCY_SINK_HTTP, id, sent_us);
+        }
+    }
+}
+
+static void handleStats(void) {
+    TRACE_SCOPE(TRACE_EV_HTTP_REQUEST, TRACE_HTTP_STATS);
+    HEAP_AUDIT_STRICT();
+    
+    response_begin();
+    response_printf("{\"stats\":[");
+    for (uint8_t i = 0; i < Stats_Count(); i++) {
+        const SignalStats_t* s = Stats_Get(i);
+        TDigest_t digest = s->digest;   // Quantile merges in place; leave the live digest alone
+        
+        response_printf("%s{\"key\":\"%s\",\"count\":%lu,\"mean\":%.2f,\"stddev\":%.2f,\"ewma\":%.2f,"
+                        "\"trend_per_min\":%.2f,\"p50\":%.2f,\"p95\":%.2f,\"min\":%.2f,\"max\":%.2f}",
+                        (i > 0) ? "," : "", SignalStore_GetKey(s->signal), (unsigned long)s->count,
+                        s->mean, sqrtf(Stats_Variance(s)), s->ewma, s->trend_per_min,
+                        TDigest_Quantile(&digest, 0.5f), TDigest_Quantile(&digest, 0.95f), digest.min, digest.max);
+    }
+    
+    response_printf("],\"alerts\":[");
+    const char* alerts[ALERT_MAX_ACTIVE];
+    uint8_t alert_count = Anomaly_GetActiveNames(alerts, ALERT_MAX_ACTIVE);
+    for (uint8_t i = 0; i < alert_count; i++) {
+        response_printf("%s\"%s\"", (i > 0) ? "," : "", alerts[i]);
+    }
+    response_printf("],");
+    
+    OBD2_CacheStats_t cache;
+    OBD2_GetCacheStats(&cache);
+    response_printf("\"obd2_cache\":{\"hits\":%lu,\"bus_requests\":%lu},",
+                    (unsigned long)cache.hits, (unsigned long)cache.bus_requests);
+    
+    CAN_TxStats_t tx;
+    CAN_GetTxStats(&tx);
+    response_printf("\"can_tx\":{\"queued\":%lu,\"sent\":%lu,\"failed\":%lu,\"queue_full\":%lu,"
+                    "\"max_queue_depth\":%u,\"max_latency_us\":%lu},",
+                    (unsigned long)tx.queued, (unsigned long)tx.sent, (unsigned long)tx.failed,
+                    (unsigned long)tx.queue_full, tx.max_queue_depth, (unsigned long)tx.max_latency_us);
+    response_printf("\"can_rx\":");
+    append_can_rx_json();
+    response_printf(",\"latency\":");
+    append_latency_json();
+    response_printf("}");
+    
+    response_send(200, "application/json");
+}
+
+// Performance runs: /perf?run=0-100|60-120|quarter_mile, /perf?cancel, /perf for status
+static void handlePerf(void) {
+    TRACE_SCOPE(TRACE_EV_HTTP_REQUEST, TRACE_HTTP_PERF);
+    HEAP_AUDIT_STRICT();
+    char run[24];
+    
+    if (request_arg("cancel", nullptr, 0)) {
+        Perf_Cancel();
+    } else if (request_arg("run", run, sizeof(run))) {
+        Status_t status = STATUS_INVALID_PARAM;
+        
+        for (uint8_t type = PERF_RUN_0_100; type <= PERF_RUN_QUARTER_MILE; type++) {
+            if (strcmp(run, Perf_RunName(type)) == 0) {
+                status = Perf_Start((PerfRunType_t)type);
+            }
+        }
+        if (status != STATUS_OK) {
+            response_begin();
+            response_printf("{\"error\":\"cannot start run\"}");
+            response_send(status == STATUS_BUSY ? 409 : 400, "application/json");
+            return;
+        }
+    }
+    
+    PerfState_t state = Perf_GetState();
+    response_begin();
+    response_printf("{\"state\":\"%s\"",
+                    (state == PERF_STATE_ARMED) ? "armed" : (state == PERF_STATE_RUNNING) ? "running" : "idle");
+    
+    const PerfResult_t* r = Perf_GetLastResult();
+    if (r != nullptr) {
+        response_printf(",\"last\":{\"run\":%lu,\"type\":\"%s\",\"valid\":%s,\"elapsed_s\":%.3f,"
+                        "\"finish_kmh\":%.2f,\"distance_m\":%.1f,\"samples\":%u,\"source\":\"%s\","
+                        "\"resolution_ms\":%.1f,\"max_gap_ms\":%.1f,\"speed_step_kmh\":%.2f}",
+                        (unsigned long)r->run_index, Perf_RunName(r->type), r->valid ? "true" : "false",
+                        r->elapsed_us / 1000000.0f, r->finish_speed_x100 / 100.0f, r->distance_mm / 1000.0f,
+                        r->sample_count, (r->source == PERF_SOURCE_BROADCAST) ? "broadcast" : "obd2",
+                        r->mean_interval_us / 1000.0f, r->max_interval_us / 1000.0f, r->speed_step_x100 / 100.0f);
+    }
+    response_printf("}");
+    
+    response_send(200, "application/json");
+}
+
+// Receive path telemetry; /can?seq=0x5F0 opens the filter and starts a loss check, /can?seq=off stops it
+static void handleCan(void) {
+    TRACE_SCOPE(TRACE_EV_HTTP_REQUEST, TRACE_HTTP_CAN);
+    HEAP_AUDIT_STRICT();
+    char seq[16];
+    
+    if (request_arg("seq", seq, sizeof(seq))) {
+        if (strcmp(seq, "off") == 0) {
+            CAN_SetSequenceCheck(CAN_SEQUENCE_CHECK_OFF);
+        } else {
+            CAN_SetFilter(0, 0);    // Replayed traffic must not be filtered; a reboot restores addressing
+            CAN_SetSequenceCheck(strtoul(seq, nullptr, 0));
+        }
+    }
+    
+    response_begin();
+    append_can_rx_json();
+    response_send(200, "application/json");
+}
+
+// Task/loop timing, overruns, stalls, stack and heap watermarks
+static void handleHealth(void) {
+    HEAP_AUDIT_STRICT();
+    
+    // Formatted in place: with every monitor registered it outgrows a stack buffer
+    response_begin();
+    int length = Health_FormatJSON(http_response, sizeof(http_response));
+    if (length < 0 || (size_t)length >= sizeof(http_response)) {
+        http_response_truncated = true;
+    } else {
+        http_response_length = length;
+    }
+    response_send(200, "application/json");
+}
+
+// Trace rings as text for tools/trace_to_chrome.py; /trace?clear empties them
+static void trace_http_writer(const char* text, size_t length, void* context) {
+    HEAP_AUDIT_EXEMPT();    // lwIP may allocate send buffers
+    server.sendContent(text, length);
+}
+
+static void handleTrace(void) {
+    TRACE_SCOPE(TRACE_EV_HTTP_REQUEST, TRACE_HTTP_TRACE);
+    HEAP_AUDIT_STRICT();
+    
+    if (request_arg("clear", nullptr, 0)) {
+        Trace_Clear();
+        response_begin();
+        response_printf("cleared\n");
+        response_send(200, "text/plain");
+        return;
+    }
+    
+    {
+        HEAP_AUDIT_EXEMPT();
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+    }
+    response_begin_chunked("text/plain");
+    Trace_Dump(trace_http_writer, nullptr);
+    response_end_chunked();
+}
+
+// Join the WiFi network (up to 10 s) and start the web server
+void HttpSink::begin(void) {
+    WiFi.begin(ssid, password);
+    if (current_state != SYSTEM_STATE_ERROR) {
+        current_state = SYSTEM_STATE_CONNECTING;
+    }
+    
+    int attempts = 0;
+    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
+        delay(500);
+        Serial.print(".");
+        attempts++;
+    }
+    
+    if (WiFi.status() == WL_CONNECTED) {
+        Serial.println("\nWiFi connected!");
+        Serial.print("IP address: ");
+        Serial.println(WiFi.localIP());
+        if (current_state != SYSTEM_STATE_ERROR) {
+            current_state = SYSTEM_STATE_CONNECTED;
+        }
+    } else {
+        Serial.println("\nWiFi connection failed, continuing without WiFi");
+        if (current_state != SYSTEM_STATE_ERROR) {
+            current_state = SYSTEM_STATE_IDLE;
+        }
+    }
+    
+    server.on("/", handleRoot);
+    server.on("/data", handleData);
+    server.on("/stats", handleStats);
+    server.on("/perf", handlePerf);
+    server.on("/can", handleCan);
+    server.on("/trace", handleTrace);
+    server.on("/health", handleHealth);
+    server.begin();
+}
+
+// Request parsing allocates inside WebServer, the handlers run strict
+void HttpSink::service(uint32_t now) {
+    HEAP_AUDIT_EXEMPT();
+    server.handleClient();
+}
+
+#endif /* SINK_HTTP */
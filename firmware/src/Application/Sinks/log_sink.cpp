@@ -0,0 +1,30 @@
+/**
+ * @file log_sink.cpp
+ * @brief Logger output sink - Application layer
+ * @version 1.0
+ * @date 2025-11-15
+ */
+
+#include "output_sinks.h"
+
+#if SINK_LOGGER
+
+#include "logger.h"
+#include "settings.h"
+
+// Core values as one log line; nothing is printed until data has arrived
+void LogSink::service(uint32_t now) {
+    static uint32_t last_output = 0;
+    uint32_t interval = Settings_GetSinkInterval(SETTINGS_RATE_LOGGER);
+    
+    if (interval == 0 || now - last_output < interval || !last_vehicle_data.dataValid) {
+        return;
+    }
+    last_output = now;
+    
+    LOG_INFO("RPM: %d, Speed: %d km/h, Temp: %dC, Throttle: %d%%",
+             last_vehicle_data.rpm, last_vehicle_data.speed, last_vehicle_data.coolantTemp,
+             last_vehicle_data.throttlePosition);
+}
+
+#endif /* SINK_LOGGER */
@@ -0,0 +1,208 @@
+/**
+ * @file serial_sink.cpp
+ * @brief Serial port output sinks (JSON and binary) - Application layer
+ * @version 1.0
+ * @date 2025-11-15
+ */
+
+#include "output_sinks.h"
+
+#if SINK_SERIAL_JSON || SINK_SERIAL_BINARY
+
+#include <Arduino.h>
+#include "latency_monitor.h"
+#include "logger.h"
+#include "settings.h"
+#if SINK_HTTP
+#include <WiFi.h>
+#endif
+
+#if SINK_SERIAL_JSON
+// JSON output for desktop application
+// Only values refreshed since the previous output are written; stale or
+// failed signals are listed by name instead of repeating an old value.
+static void output_vehicle_data_json(uint32_t now) {
+    static uint32_t last_output_timestamp[SIGNAL_STORE_CAPACITY] = {0};
+    char value[24];
+    
+    // Create JSON object; the caller holds the port, so log lines wait until the block is complete
+    Serial.println("{");
+    Serial.printf("  \"timestamp\": %lu,\n", now);
+    
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        uint32_t timestamp = SignalStore_GetTimestamp(id);
+        if (SignalStore_GetQuality(id) != SIGNAL_QUALITY_VALID || timestamp == last_output_timestamp[id]) {
+            continue;
+        }
+        SignalStore_FormatValue(id, value, sizeof(value));
+        Serial.printf("  \"%s\": %s,\n", SignalStore_GetKey(id), value);
+        Serial.printf("  \"%s_age_ms\": %lu,\n", SignalStore_GetKey(id), now - timestamp);
+        last_output_timestamp[id] = timestamp;
+    }
+    
+    Serial.print("  \"stale\": [");
+    bool first = true;
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        uint8_t quality = SignalStore_GetQuality(id);
+        if (quality == SIGNAL_QUALITY_STALE || quality == SIGNAL_QUALITY_FAILED) {
+            Serial.printf("%s\"%s\"", first ? "" : ", ", SignalStore_GetKey(id));
+            first = false;
+        }
+    }
+    Serial.println("],");
+    
+    Serial.printf("  \"system_state\": \"%s\",\n", 
+        (current_state == SYSTEM_STATE_CONNECTED) ? "CONNECTED" :
+        (current_state == SYSTEM_STATE_IDLE) ? "IDLE" :
+        (current_state == SYSTEM_STATE_ERROR) ? "ERROR" : 
+        (current_state == SYSTEM_STATE_CONNECTING) ? "CONNECTING" : "UNKNOWN");
+#if SINK_HTTP
+    Serial.printf("  \"wifi_connected\": %s,\n", WiFi.isConnected() ? "true" : "false");
+    Serial.printf("  \"wifi_rssi\": %d\n", WiFi.RSSI());
+#else
+    Serial.println("  \"wifi_connected\": false");
+#endif
+    Serial.println("}");
+    
+    Latency_RecordSink(LATENCY_SINK_SERIAL, micros());
+}
+
+// Skipped while the console holds the port; retried on the next pass
+void SerialJsonSink::service(uint32_t now) {
+    static uint32_t last_output = 0;
+    uint32_t interval = Settings_GetSinkInterval(SETTINGS_RATE_SERIAL_JSON);
+    
+    if (interval != 0 && now - last_output >= interval && Log_TryLockOutput()) {
+        output_vehicle_data_json(now);
+        Log_UnlockOutput();
+        last_output = now;
+    }
+}
+#endif /* SINK_SERIAL_JSON */
+
+#if SINK_SERIAL_BINARY
+/*
+ * Binary frames, little endian. Log lines may appear between frames;
+ * a reader resynchronizes on the sync bytes and the checksum.
+ *
+ *   0xA5 0x5A type ... checksum
+ *
+ * type 0x01, samples: count, uptime ms (u32), then count records of
+ *   id (u8), quality (u8), raw value (i32), age ms (u16, saturated)
+ * type 0x02, signal descriptor: id, scale (u16), key length, key
+ *
+ * Physical value = raw / scale. A sample frame carries the signals
+ * refreshed or changed quality since the previous frame; one descriptor
+ * follows each sample frame, cycling through the store, so a reader that
+ * attaches late learns every key within one cycle.
+ * The checksum is the XOR of all bytes after the sync bytes.
+ */
+#define SERIAL_BINARY_SYNC_0        0xA5
+#define SERIAL_BINARY_SYNC_1        0x5A
+#define SERIAL_BINARY_TYPE_SAMPLES  0x01
+#define SERIAL_BINARY_TYPE_SIGNAL   0x02
+#define SERIAL_BINARY_RECORD_SIZE   8
+
+static uint8_t frame[SERIAL_BINARY_FRAME_SIZE];
+static uint32_t sent_timestamp[SIGNAL_STORE_CAPACITY];
+static uint8_t sent_quality[SIGNAL_STORE_CAPACITY];
+
+static_assert(4 + 4 + SIGNAL_STORE_CAPACITY * SERIAL_BINARY_RECORD_SIZE + 1 <= SERIAL_BINARY_FRAME_SIZE,
+              "SERIAL_BINARY_FRAME_SIZE cannot hold a full sample frame");
+
+static size_t put_u16(size_t at, uint16_t value) {
+    frame[at] = (uint8_t)value;
+    frame[at + 1] = (uint8_t)(value >> 8);
+    return at + 2;
+}
+
+static size_t put_u32(size_t at, uint32_t value) {
+    at = put_u16(at, (uint16_t)value);
+    return put_u16(at, (uint16_t)(value >> 16));
+}
+
+// Add the checksum and write the frame; the caller holds the port
+static void send_frame(size_t length) {
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < length; i++) {
+        checksum ^= frame[i];
+    }
+    frame[length++] = checksum;
+    Serial.write(frame, length);
+}
+
+static size_t begin_frame(uint8_t type) {
+    frame[0] = SERIAL_BINARY_SYNC_0;
+    frame[1] = SERIAL_BINARY_SYNC_1;
+    frame[2] = type;
+    return 3;
+}
+
+static void send_samples(uint32_t now) {
+    size_t length = begin_frame(SERIAL_BINARY_TYPE_SAMPLES);
+    size_t count_at = length++;
+    length = put_u32(length, now);
+    
+    uint8_t count = 0;
+    for (SignalId_t id = 0; id < SignalStore_Count(); id++) {
+        uint8_t quality = SignalStore_GetQuality(id);
+        uint32_t timestamp = SignalStore_GetTimestamp(id);
+        if (quality == SIGNAL_QUALITY_NONE || (timestamp == sent_timestamp[id] && quality == sent_quality[id])) {
+            continue;
+        }
+        uint32_t age = now - timestamp;
+        
+        frame[length++] = id;
+        frame[length++] = quality;
+        length = put_u32(length, (uint32_t)SignalStore_GetRaw(id));
+        length = put_u16(length, (age > 0xFFFF) ? 0xFFFF : (uint16_t)age);
+        sent_timestamp[id] = timestamp;
+        sent_quality[id] = quality;
+        count++;
+    }
+    frame[count_at] = count;
+    
+    if (count > 0) {
+        send_frame(length);
+        Latency_RecordSink(LATENCY_SINK_SERIAL, micros());
+    }
+}
+
+static void send_descriptor(SignalId_t id) {
+    const char* key = SignalStore_GetKey(id);
+    size_t key_length = strlen(key);
+    if (key_length > 255) {
+        key_length = 255;   // Length is one byte; the frame always has room for this much
+    }
+    
+    size_t length = begin_frame(SERIAL_BINARY_TYPE_SIGNAL);
+    frame[length++] = id;
+    length = put_u16(length, SignalStore_GetScale(id));
+    frame[length++] = (uint8_t)key_length;
+    memcpy(&frame[length], key, key_length);
+    send_frame(length + key_length);
+}
+
+void SerialBinarySink::service(uint32_t now) {
+    static uint32_t last_output = 0;
+    static SignalId_t next_descriptor = 0;
+    uint32_t interval = Settings_GetSinkInterval(SETTINGS_RATE_SERIAL_BINARY);
+    
+    // Skipped while the console holds the port; retried on the next pass
+    if (interval == 0 || now - last_output < interval || !Log_TryLockOutput()) {
+        return;
+    }
+    last_output = now;
+    
+    send_samples(now);
+    if (SignalStore_Count() > 0) {
+        if (next_descriptor >= SignalStore_Count()) {
+            next_descriptor = 0;
+        }
+        send_descriptor(next_descriptor++);
+    }
+    Log_UnlockOutput();
+}
+#endif /* SINK_SERIAL_BINARY */
+
+#endif /* SINK_SERIAL_JSON || SINK_SERIAL_BINARY */
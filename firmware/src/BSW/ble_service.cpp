@@ -5,9 +5,22 @@
  * @date 2025-10-31
  */
 
+#include "sink_config.h"
+
+#if SINK_BLE
+
 #include "ble_service.h"
+#include "signal_store.h"
+#include "latency_monitor.h"
+#include "health_monitor.h"
+#include "logger.h"
+#include "trace.h"
+#include "heap_audit.h"
 #include <ArduinoJson.h>
 
+static_assert(sizeof(OBD2BLEService) <= BLE_SERVICE_RAM_SIZE, "BLE_SERVICE_RAM_SIZE is smaller than OBD2BLEService");
+static_assert(SIGNAL_STORE_CAPACITY <= 64, "lastSentMask holds one bit per signal");
+
 // Global instance
 OBD2BLEService* g_bleService = nullptr;
 
@@ -16,31 +29,33 @@ OBD2BLEService* g_bleService = nullptr;
 // ============================================================================
 
 void BLEConnectionCallbacks::onConnect(BLEServer* pServer) {
-    Serial.println("BLE: Client connected");
-    // Re-set callbacks after each connection to ensure reliability
-    pServer->setCallbacks(new BLEConnectionCallbacks());
+    LOG_INFO("BLE: Client connected");
+    // Re-set callbacks after each connection to ensure reliability (same object, nothing allocated)
+    pServer->setCallbacks(this);
     if (g_bleService) {
         // Directly update connection status instead of relying on getConnectedCount()
         g_bleService->deviceConnected = true;
         g_bleService->oldDeviceConnected = true;
         // Reset activity time on new connection
         g_bleService->lastActivityTime = millis();
-        Serial.println("BLE: Device connected event");
+        // New client starts from a full snapshot
+        g_bleService->resetDeltaState();
+        LOG_INFO("BLE: Device connected event");
     }
 }
 
 void BLEConnectionCallbacks::onDisconnect(BLEServer* pServer) {
-    Serial.println("BLE: Client disconnected");
+    LOG_INFO("BLE: Client disconnected");
     if (g_bleService) {
         // Directly update connection status
         g_bleService->deviceConnected = false;
         g_bleService->oldDeviceConnected = false;
-        Serial.println("BLE: Device disconnected event");
+        LOG_INFO("BLE: Device disconnected event");
     }
     // Auto restart advertising with longer delay for stability
     delay(1000); // Increased from 500ms to 1000ms
     pServer->getAdvertising()->start();
-    Serial.println("BLE: Advertising restarted");
+    LOG_INFO("BLE: Advertising restarted");
 }
 
 // ============================================================================
@@ -56,7 +71,17 @@ OBD2BLEService::OBD2BLEService()
       deviceConnected(false),
       oldDeviceConnected(false),
       lastDataSend(0),
+      lastFullSend(0),
       lastActivityTime(0) {
+    resetDeltaState();
+}
+
+void OBD2BLEService::resetDeltaState() {
+    for (uint8_t i = 0; i < SIGNAL_STORE_CAPACITY; i++) {
+        lastSentRaw[i] = 0;
+    }
+    lastSentMask = 0;
+    lastFullSend = 0;
 }
 
 OBD2BLEService::~OBD2BLEService() {
@@ -67,11 +92,11 @@ OBD2BLEService::~OBD2BLEService() {
 
 Status_t OBD2BLEService::init(const BLEConfig_t* config) {
     if (!config) {
-        Serial.println("BLE: Invalid configuration");
+        LOG_ERROR("BLE: Invalid configuration");
         return STATUS_ERROR;
     }
     
-    Serial.println("BLE: Initializing BLE service...");
+    LOG_INFO("BLE: Initializing BLE service...");
     
     // Initialize BLE Device
     BLEDevice::init(config->device_name);
@@ -82,7 +107,7 @@ Status_t OBD2BLEService::init(const BLEConfig_t* config) {
     // Create BLE Server
     pServer = BLEDevice::createServer();
     if (!pServer) {
-        Serial.println("BLE: Failed to create server");
+        LOG_ERROR("BLE: Failed to create server");
         return STATUS_ERROR;
     }
     
@@ -93,7 +118,7 @@ Status_t OBD2BLEService::init(const BLEConfig_t* config) {
     // Create BLE Service
     pService = pServer->createService(BLE_SERVICE_UUID);
     if (!pService) {
-        Serial.println("BLE: Failed to create service");
+        LOG_ERROR("BLE: Failed to create service");
         return STATUS_ERROR;
     }
     
@@ -108,9 +133,9 @@ Status_t OBD2BLEService::init(const BLEConfig_t* config) {
         startAdvertising();
     }
     
-    Serial.println("BLE: Service initialized successfully");
-    Serial.printf("BLE: Device name: %s\n", config->device_name);
-    Serial.printf("BLE: MTU size: %d\n", config->mtu_size);
+    LOG_INFO("BLE: Service initialized successfully");
+    LOG_INFO("BLE: Device name: %s", config->device_name);
+    LOG_INFO("BLE: MTU size: %d", config->mtu_size);
     
     return STATUS_OK;
 }
@@ -132,7 +157,7 @@ void OBD2BLEService::setupCharacteristics() {
     );
     pStatusCharacteristic->addDescriptor(new BLE2902());
     
-    Serial.println("BLE: Characteristics configured");
+    LOG_INFO("BLE: Characteristics configured");
 }
 
 void OBD2BLEService::startAdvertising() {
@@ -144,32 +169,119 @@ void OBD2BLEService::startAdvertising() {
     pAdvertising->setMinPreferred(0x12);
     
     BLEDevice::startAdvertising();
-    Serial.println("BLE: Advertising started");
+    LOG_INFO("BLE: Advertising started");
 }
 
 void OBD2BLEService::stopAdvertising() {
     BLEDevice::stopAdvertising();
-    Serial.println("BLE: Advertising stopped");
+    LOG_INFO("BLE: Advertising stopped");
 }
 
-String OBD2BLEService::createDataJSON(const VehicleData_t* data) {
-    StaticJsonDocument<256> doc;
+// Append a comma-separated JSON fragment; false if it does not fit
+static bool appendFragment(char* buffer, size_t* length, size_t capacity, const char* fragment, int fragment_length) {
+    size_t needed = fragment_length + ((*length > 0) ? 1 : 0);
+    if (fragment_length < 0 || *length + needed >= capacity) {
+        return false;
+    }
+    if (*length > 0) {
+        buffer[(*length)++] = ',';
+    }
+    memcpy(&buffer[*length], fragment, fragment_length);
+    *length += fragment_length;
+    buffer[*length] = '\0';
+    return true;
+}
+
+void OBD2BLEService::resetChunk() {
+    chunkValuesLength = 0;
+    chunkAgesLength = 0;
+    chunkStaleLength = 0;
+    chunkValues[0] = '\0';
+    chunkAges[0] = '\0';
+    chunkStale[0] = '\0';
+}
+
+void OBD2BLEService::flushChunk(const VehicleData_t* data, uint32_t now) {
+    char payload[BLE_MAX_PAYLOAD + 1];
+    int length = snprintf(payload, sizeof(payload),
+                          "{\"timestamp\":%lu%s%s,\"age\":{%s},\"stale\":[%s],"
+                          "\"engine_running\":%s,\"data_valid\":%s}",
+                          (unsigned long)now, (chunkValuesLength > 0) ? "," : "", chunkValues,
+                          chunkAges, chunkStale,
+                          data->engineRunning ? "true" : "false", data->dataValid ? "true" : "false");
+    
+    if (length > 0 && length <= BLE_MAX_PAYLOAD) {
+        TRACE_BEGIN(TRACE_EV_BLE_SEND, length);
+        HEAP_AUDIT_EXEMPT();    // Bluedroid copies the value and queues the notification on the heap
+        pDataCharacteristic->setValue((uint8_t*)payload, length);
+        pDataCharacteristic->notify();
+        TRACE_END(TRACE_EV_BLE_SEND, length);
+    }
+    resetChunk();
+}
+
+// Send every signal of the store whose value changed since the last
+// notification (all on full updates), split into notifications that fit the
+// MTU. A new sample of an unchanged value is not resent. Stale or failed
+// signals are listed by key so the client can grey them out; their value is
+// sent again once they recover.
+void OBD2BLEService::sendSignalDeltas(const VehicleData_t* data, bool full, uint32_t now) {
+    char value[24];
+    char fragment[64];
+    bool notified = false;
+    
+    resetChunk();
+    
+    for (SignalId_t id = 0; id < SignalStore_Count() && id < SIGNAL_STORE_CAPACITY; id++) {
+        SignalSample_t sample;
+        SignalStore_GetSample(id, &sample);
+        const char* key = SignalStore_GetKey(id);
+        uint64_t bit = 1ULL << id;
+        
+        if (sample.quality == SIGNAL_QUALITY_NONE) {
+            continue;
+        }
+        if (sample.quality != SIGNAL_QUALITY_VALID) {
+            lastSentMask &= ~bit;
+            int stale_length = snprintf(fragment, sizeof(fragment), "\"%s\"", key);
+            if (chunkValuesLength + chunkAgesLength + chunkStaleLength + stale_length + BLE_CHUNK_OVERHEAD > BLE_MAX_PAYLOAD) {
+                flushChunk(data, now);
+                notified = true;
+            }
+            appendFragment(chunkStale, &chunkStaleLength, sizeof(chunkStale), fragment, stale_length);
+            continue;
+        }
+        if (!full && (lastSentMask & bit) && sample.raw == lastSentRaw[id]) {
+            continue;
+        }
+        
+        SignalStore_FormatRaw(id, sample.raw, value, sizeof(value));
+        int value_length = snprintf(fragment, sizeof(fragment), "\"%s\":%s", key, value);
+        char age_fragment[48];
+        int age_length = snprintf(age_fragment, sizeof(age_fragment), "\"%s\":%lu", key,
+                                  (unsigned long)(now - sample.timestamp));
+        
+        // Start a new notification when this signal would overflow the MTU
+        if (chunkValuesLength + chunkAgesLength + chunkStaleLength + value_length + age_length + BLE_CHUNK_OVERHEAD > BLE_MAX_PAYLOAD) {
+            flushChunk(data, now);
+            notified = true;
+        }
+        appendFragment(chunkValues, &chunkValuesLength, sizeof(chunkValues), fragment, value_length);
+        appendFragment(chunkAges, &chunkAgesLength, sizeof(chunkAges), age_fragment, age_length);
+        lastSentRaw[id] = sample.raw;
+        lastSentMask |= bit;
+    }
     
-    doc["timestamp"] = millis();
-    doc["rpm"] = data->rpm;
-    doc["speed"] = data->speed;
-    doc["coolant_temp"] = data->coolantTemp;
-    doc["throttle_position"] = data->throttlePosition;
-    doc["engine_running"] = data->engineRunning;
-    doc["data_valid"] = data->dataValid;
-    
-    String output;
-    serializeJson(doc, output);
-    return output;
+    // Always notify at least once so engine_running/data_valid keep flowing
+    if (!notified || chunkValuesLength > 0 || chunkStaleLength > 0) {
+        flushChunk(data, now);
+    }
+    Latency_RecordSink(LATENCY_SINK_BLE, micros());
 }
 
-String OBD2BLEService::createStatusJSON(SystemState_t state, bool wifiConnected, int8_t rssi) {
-    StaticJsonDocument<128> doc;
+size_t OBD2BLEService::createStatusJSON(char* buffer, size_t size, SystemState_t state, bool wifiConnected,
+                                        int8_t rssi, const char* const* alerts, uint8_t alertCount) {
+    StaticJsonDocument<512> doc;
     
     doc["timestamp"] = millis();
     doc["system_state"] = state;
@@ -177,9 +289,29 @@ String OBD2BLEService::createStatusJSON(SystemState_t state, bool wifiConnected,
     doc["wifi_rssi"] = rssi;
     doc["ble_connected"] = deviceConnected;
     
-    String output;
-    serializeJson(doc, output);
-    return output;
+    JsonArray alertArray = doc.createNestedArray("alerts");
+    for (uint8_t i = 0; i < alertCount; i++) {
+        alertArray.add(alerts[i]);
+    }
+    
+    // Condensed health; /health has the per-monitor detail
+    HealthSystem_t health;
+    Health_GetSystem(&health);
+    uint32_t loop_max_us = 0;
+    for (uint8_t i = 0; i < Health_Count(); i++) {
+        const HealthMonitor_t* m = Health_Get(i);
+        if (strcmp(m->name, "loop") == 0) {
+            loop_max_us = m->max_us;
+        }
+    }
+    JsonObject healthObject = doc.createNestedObject("health");
+    healthObject["heap_min_free"] = health.heap_min_free;
+    healthObject["overruns"] = health.overruns;
+    healthObject["stalls"] = health.stalls;
+    healthObject["loop_max_ms"] = loop_max_us / 1000;
+    healthObject["watchdog_reset"] = health.watchdog_reset;
+    
+    return serializeJson(doc, buffer, size);
 }
 
 Status_t OBD2BLEService::sendVehicleData(const VehicleData_t* data) {
@@ -199,26 +331,31 @@ Status_t OBD2BLEService::sendVehicleData(const VehicleData_t* data) {
     lastDataSend = now;
     lastActivityTime = now;  // Update activity timestamp
     
-    // Create JSON string
-    String jsonData = createDataJSON(data);
+    // Periodic full update so a missed delta never leaves the client behind
+    bool full = (lastFullSend == 0) || (now - lastFullSend >= BLE_FULL_UPDATE_INTERVAL);
+    if (full) {
+        lastFullSend = now;
+    }
     
-    // Send via BLE notification
-    pDataCharacteristic->setValue(jsonData.c_str());
-    pDataCharacteristic->notify();
+    // Send via BLE notification(s)
+    sendSignalDeltas(data, full, now);
     
     return STATUS_OK;
 }
 
-Status_t OBD2BLEService::sendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi) {
+Status_t OBD2BLEService::sendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi,
+                                          const char* const* alerts, uint8_t alertCount) {
     if (!deviceConnected) {
         return STATUS_ERROR;
     }
     
     // Create JSON string
-    String jsonStatus = createStatusJSON(state, wifiConnected, rssi);
+    char jsonStatus[BLE_STATUS_JSON_SIZE];
+    size_t length = createStatusJSON(jsonStatus, sizeof(jsonStatus), state, wifiConnected, rssi, alerts, alertCount);
     
     // Send via BLE notification
-    pStatusCharacteristic->setValue(jsonStatus.c_str());
+    HEAP_AUDIT_EXEMPT();    // Bluedroid copies the value and queues the notification on the heap
+    pStatusCharacteristic->setValue((uint8_t*)jsonStatus, length);
     pStatusCharacteristic->notify();
     
     return STATUS_OK;
@@ -229,11 +366,11 @@ void OBD2BLEService::updateConnectionStatus() {
     
     // Handle connection state changes
     if (newDeviceConnected && !oldDeviceConnected) {
-        Serial.println("BLE: Device connected event");
+        LOG_INFO("BLE: Device connected event");
     }
     
     if (!newDeviceConnected && oldDeviceConnected) {
-        Serial.println("BLE: Device disconnected event");
+        LOG_INFO("BLE: Device disconnected event");
     }
     
     oldDeviceConnected = newDeviceConnected;
@@ -241,11 +378,11 @@ void OBD2BLEService::updateConnectionStatus() {
 }
 
 void OBD2BLEService::checkConnectionTimeout() {
-    Serial.println("BLE: checkConnectionTimeout() CALLED"); // DEBUG
+    LOG_DEBUG("BLE: checkConnectionTimeout() CALLED");
     
     // Only check if we think we're connected
     if (!deviceConnected) {
-        Serial.println("BLE: Skipping check - not connected");
+        LOG_DEBUG("BLE: Skipping check - not connected");
         return;
     }
     
@@ -256,37 +393,38 @@ void OBD2BLEService::checkConnectionTimeout() {
     uint32_t timeSinceActivity = (lastActivityTime == 0) ? 0 : (now - lastActivityTime);
     uint32_t timeUntilTimeout = (timeSinceActivity > 10000) ? 0 : (10000 - timeSinceActivity);
     
-    Serial.printf("BLE: Check - count=%d, idle=%lums, timeout_in=%lums\n", 
+    LOG_DEBUG("BLE: Check - count=%d, idle=%lums, timeout_in=%lums", 
                   connectedCount, timeSinceActivity, timeUntilTimeout);
     
     // Initialize activity time on first check after connection
     if (lastActivityTime == 0) {
         lastActivityTime = now;
-        Serial.println("BLE: Activity time initialized");
+        LOG_INFO("BLE: Activity time initialized");
     }
     
     // Check for timeout
     if (now - lastActivityTime > 10000) {
         // No activity for 10+ seconds
-        Serial.println("BLE: No activity for 10s, checking connection state...");
+        LOG_INFO("BLE: No activity for 10s, checking connection state...");
         
         if (connectedCount == 0) {
             // getConnectedCount says 0, definitely disconnected
-            Serial.println("BLE: Connection timeout detected (count=0)");
+            LOG_WARN("BLE: Connection timeout detected (count=0)");
         } else {
             // Count > 0 but no data - still assume disconnected (Windows bug)
-            Serial.println("BLE: Connection timeout detected (no data but count>0, Windows BLE bug)");
+            LOG_WARN("BLE: Connection timeout detected (no data but count>0, Windows BLE bug)");
         }
         
-        Serial.println("BLE: Forcing disconnect and restart advertising");
+        LOG_WARN("BLE: Forcing disconnect and restart advertising");
         deviceConnected = false;
         oldDeviceConnected = false;
         lastActivityTime = 0;
         
         // Restart advertising
         delay(500);
+        HEAP_AUDIT_EXEMPT();
         pServer->getAdvertising()->start();
-        Serial.println("BLE: Advertising restarted after timeout");
+        LOG_INFO("BLE: Advertising restarted after timeout");
     }
 }
 
@@ -317,12 +455,13 @@ Status_t BLE_SendVehicleData(const VehicleData_t* data) {
     return g_bleService->sendVehicleData(data);
 }
 
-Status_t BLE_SendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi) {
+Status_t BLE_SendSystemStatus(SystemState_t state, bool wifiConnected, int8_t rssi,
+                              const char* const* alerts, uint8_t alertCount) {
     if (!g_bleService) {
         return STATUS_ERROR;
     }
     
-    return g_bleService->sendSystemStatus(state, wifiConnected, rssi);
+    return g_bleService->sendSystemStatus(state, wifiConnected, rssi, alerts, alertCount);
 }
 
 bool BLE_IsConnected() {
@@ -346,7 +485,9 @@ void BLE_EnsureAdvertising() {
     g_bleService->updateConnectionStatus();
     
     if (!g_bleService->isConnected()) {
-        Serial.println("BLE: Forcing advertising restart (not connected)");
+        LOG_WARN("BLE: Forcing advertising restart (not connected)");
         g_bleService->startAdvertising();
     }
 }
+
+#endif /* SINK_BLE */
@@ -0,0 +1,247 @@
+/**
+ * @file health_monitor.cpp
+ * @brief Task and loop health monitor - BSW layer
+ * @version 1.0
+ * @date 2025-11-13
+ */
+
+#include <Arduino.h>
+#include <esp_task_wdt.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include "health_monitor.h"
+#include "logger.h"
+#include "heap_audit.h"
+
+#define HEALTH_TASK_STACK           3072
+#define HEALTH_TASK_PRIORITY        1       /* Same as the loop task: time-sliced, still runs while it spins */
+#define HEALTH_TASK_BUDGET_US       10000
+
+static HealthMonitor_t monitors[HEALTH_MAX_MONITORS];
+static uint8_t monitor_count = 0;
+static uint32_t reported_overruns[HEALTH_MAX_MONITORS];
+static portMUX_TYPE register_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t health_task = nullptr;
+static bool watchdog_ready = false;
+
+/* Sample stack watermarks, report new overruns and runs that never ended */
+static void Health_Check(void) {
+    uint32_t now = micros();
+
+    for (uint8_t i = 0; i < monitor_count; i++) {
+        HealthMonitor_t* m = &monitors[i];
+
+        if (m->task != nullptr) {
+            m->stack_free_min = uxTaskGetStackHighWaterMark((TaskHandle_t)m->task);
+        }
+
+        if (m->running && !m->stall_reported && (now - m->started_us) > HEALTH_STALL_MS * 1000UL) {
+            m->stalls++;
+            m->stall_reported = true;
+            LOG_ERROR("HEALTH: %s stalled, running for %lu ms", m->name,
+                      (unsigned long)((now - m->started_us) / 1000));
+        }
+
+        uint32_t overruns = m->overruns;
+        if (overruns != reported_overruns[i]) {
+            LOG_WARN("HEALTH: %s overran its %lu us budget %lu time(s), last run %lu us, max %lu us",
+                     m->name, (unsigned long)m->budget_us, (unsigned long)(overruns - reported_overruns[i]),
+                     (unsigned long)m->last_us, (unsigned long)m->max_us);
+            reported_overruns[i] = overruns;
+        }
+    }
+}
+
+static void Health_Task(void* param) {
+    int8_t self = Health_Register("health", HEALTH_TASK_BUDGET_US, HEALTH_FLAG_TASK);
+    HEAP_AUDIT_WATCH();
+    TickType_t wake = xTaskGetTickCount();
+    uint32_t last_summary = millis();
+
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(HEALTH_PERIOD_MS));
+        Health_Begin(self);
+        Health_Check();
+        Health_End(self);
+
+        // Printed here, not by the loop task, which must not wait for the serial port
+        if (millis() - last_summary >= HEALTH_SUMMARY_MS) {
+            Health_PrintSummary();
+            last_summary = millis();
+        }
+    }
+}
+
+/**
+ * @brief Configure the task watchdog and start the health task
+ * @return STATUS_OK, STATUS_ERROR if the task could not be created
+ */
+Status_t Health_Init(void) {
+    // Reconfigures the watchdog the Arduino core already started for the idle tasks
+    watchdog_ready = (esp_task_wdt_init(HEALTH_WATCHDOG_TIMEOUT_S, true) == ESP_OK);
+
+    if (health_task == nullptr &&
+        xTaskCreatePinnedToCore(Health_Task, "health", HEALTH_TASK_STACK, nullptr,
+                                HEALTH_TASK_PRIORITY, &health_task, tskNO_AFFINITY) != pdPASS) {
+        health_task = nullptr;
+        return STATUS_ERROR;
+    }
+    return STATUS_OK;
+}
+
+/**
+ * @brief Add a monitor; with HEALTH_FLAG_TASK or HEALTH_FLAG_WATCHDOG it
+ *        belongs to the calling task
+ * @param name Shown in reports, must stay valid
+ * @param budget_us Longest acceptable run
+ * @param flags HEALTH_FLAG_*
+ * @return Monitor index, -1 if the table is full
+ */
+int8_t Health_Register(const char* name, uint32_t budget_us, uint8_t flags) {
+    bool own_task = (flags & (HEALTH_FLAG_TASK | HEALTH_FLAG_WATCHDOG)) != 0;
+    TaskHandle_t task = own_task ? xTaskGetCurrentTaskHandle() : nullptr;
+    uint32_t stack_free = own_task ? uxTaskGetStackHighWaterMark(nullptr) : 0;
+
+    portENTER_CRITICAL(&register_mux);
+    if (monitor_count >= HEALTH_MAX_MONITORS) {
+        portEXIT_CRITICAL(&register_mux);
+        return -1;
+    }
+    int8_t index = monitor_count;
+    HealthMonitor_t* m = &monitors[index];
+    memset(m, 0, sizeof(*m));
+    m->name = name;
+    m->budget_us = budget_us;
+    m->task = task;
+    m->stack_free_min = stack_free;
+    reported_overruns[index] = 0;
+    monitor_count++;
+    portEXIT_CRITICAL(&register_mux);
+
+    if ((flags & HEALTH_FLAG_WATCHDOG) && watchdog_ready) {
+        m->watchdog = (esp_task_wdt_add(nullptr) == ESP_OK);
+    }
+    return index;
+}
+
+void Health_Begin(int8_t monitor) {
+    if (monitor < 0 || monitor >= monitor_count) {
+        return;
+    }
+    HealthMonitor_t* m = &monitors[monitor];
+    m->started_us = micros();
+    m->stall_reported = false;
+    m->running = true;
+}
+
+void Health_End(int8_t monitor) {
+    if (monitor < 0 || monitor >= monitor_count) {
+        return;
+    }
+    HealthMonitor_t* m = &monitors[monitor];
+    if (!m->running) {
+        return;
+    }
+
+    uint32_t elapsed = micros() - m->started_us;
+    m->running = false;
+    m->runs++;
+    m->last_us = elapsed;
+    m->total_us += elapsed;
+    if (elapsed > m->max_us) {
+        m->max_us = elapsed;
+    }
+    if (elapsed > m->budget_us) {
+        m->overruns++;
+    }
+    if (m->watchdog) {
+        esp_task_wdt_reset();
+    }
+}
+
+uint8_t Health_Count(void) {
+    return monitor_count;
+}
+
+const HealthMonitor_t* Health_Get(int8_t monitor) {
+    return (monitor >= 0 && monitor < monitor_count) ? &monitors[monitor] : nullptr;
+}
+
+void Health_GetSystem(HealthSystem_t* system) {
+    if (system == nullptr) {
+        return;
+    }
+
+    system->uptime_s = millis() / 1000;
+    system->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    system->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    system->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    system->stalls = 0;
+    system->overruns = 0;
+    for (uint8_t i = 0; i < monitor_count; i++) {
+        system->stalls += monitors[i].stalls;
+        system->overruns += monitors[i].overruns;
+    }
+
+    esp_reset_reason_t reason = esp_reset_reason();
+    system->reset_reason = reason;
+    system->watchdog_reset = (reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT);
+}
+
+/**
+ * @brief System and per-monitor health as one JSON object
+ * @return Characters written (snprintf semantics, truncated at size)
+ */
+int Health_FormatJSON(char* buffer, size_t size) {
+    HealthSystem_t system;
+    Health_GetSystem(&system);
+
+    int length = snprintf(buffer, size,
+                          "{\"uptime_s\":%lu,\"heap_free\":%lu,\"heap_min_free\":%lu,\"heap_largest_block\":%lu,"
+                          "\"stalls\":%lu,\"overruns\":%lu,\"reset_reason\":%u,\"watchdog_reset\":%s,\"monitors\":[",
+                          (unsigned long)system.uptime_s, (unsigned long)system.heap_free,
+                          (unsigned long)system.heap_min_free, (unsigned long)system.heap_largest_block,
+                          (unsigned long)system.stalls, (unsigned long)system.overruns, system.reset_reason,
+                          system.watchdog_reset ? "true" : "false");
+
+    for (uint8_t i = 0; i < monitor_count && length > 0 && (size_t)length < size; i++) {
+        const HealthMonitor_t* m = &monitors[i];
+        uint32_t mean_us = (m->runs > 0) ? (uint32_t)(m->total_us / m->runs) : 0;
+        length += snprintf(buffer + length, size - length,
+                           "%s{\"name\":\"%s\",\"runs\":%lu,\"last_us\":%lu,\"mean_us\":%lu,\"max_us\":%lu,"
+                           "\"budget_us\":%lu,\"overruns\":%lu,\"stalls\":%lu,\"stack_free\":%ld,\"watchdog\":%s}",
+                           (i > 0) ? "," : "", m->name, (unsigned long)m->runs, (unsigned long)m->last_us,
+                           (unsigned long)mean_us, (unsigned long)m->max_us, (unsigned long)m->budget_us,
+                           (unsigned long)m->overruns, (unsigned long)m->stalls,
+                           (m->task != nullptr) ? (long)m->stack_free_min : -1L, m->watchdog ? "true" : "false");
+    }
+    if (length > 0 && (size_t)length < size) {
+        length += snprintf(buffer + length, size - length, "]}");
+    }
+    return length;
+}
+
+/* One line per monitor on the serial port */
+void Health_PrintSummary(void) {
+    HealthSystem_t system;
+    Health_GetSystem(&system);
+    char line[160];     // Print::printf would allocate for lines this long
+
+    Log_LockOutput();
+    snprintf(line, sizeof(line), "HEALTH: up %lu s, heap %lu free (min %lu, largest block %lu), %lu overruns, %lu stalls%s",
+             (unsigned long)system.uptime_s, (unsigned long)system.heap_free, (unsigned long)system.heap_min_free,
+             (unsigned long)system.heap_largest_block, (unsigned long)system.overruns,
+             (unsigned long)system.stalls, system.watchdog_reset ? ", last reset by watchdog" : "");
+    Serial.println(line);
+    for (uint8_t i = 0; i < monitor_count; i++) {
+        const HealthMonitor_t* m = &monitors[i];
+        int length = snprintf(line, sizeof(line), "  %-10s runs %lu, last %lu us, max %lu us, budget %lu us, overruns %lu",
+                              m->name, (unsigned long)m->runs, (unsigned long)m->last_us, (unsigned long)m->max_us,
+                              (unsigned long)m->budget_us, (unsigned long)m->overruns);
+        if (m->task != nullptr && length > 0 && (size_t)length < sizeof(line)) {
+            snprintf(line + length, sizeof(line) - length, ", stack free %lu B", (unsigned long)m->stack_free_min);
+        }
+        Serial.println(line);
+    }
+    Log_UnlockOutput();
+}
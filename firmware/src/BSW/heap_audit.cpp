@@ -0,0 +1,122 @@
+/**
+ * @file heap_audit.cpp
+ * @brief Allocation audit wrappers - BSW layer
+ * @version 1.0
+ * @date 2025-11-14
+ *
+ * Linked with -Wl,--wrap for malloc, calloc, realloc and their
+ * heap_caps_ counterparts in the audit build only; empty otherwise.
+ */
+
+#include <Arduino.h>
+#include "heap_audit.h"
+
+#if HEAP_AUDIT
+
+typedef struct {
+    TaskHandle_t task;
+    volatile uint8_t exempt_depth;
+} HeapAuditTask_t;
+
+static HeapAuditTask_t tasks[HEAP_AUDIT_MAX_TASKS];
+static volatile uint8_t task_count = 0;
+static volatile bool armed = false;
+static portMUX_TYPE watch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t count, size_t size);
+extern "C" void* __real_realloc(void* pointer, size_t size);
+extern "C" void* __real_heap_caps_malloc(size_t size, uint32_t caps);
+extern "C" void* __real_heap_caps_calloc(size_t count, size_t size, uint32_t caps);
+extern "C" void* __real_heap_caps_realloc(void* pointer, size_t size, uint32_t caps);
+
+static int8_t HeapAudit_FindTask(TaskHandle_t task) {
+    for (uint8_t i = 0; i < task_count; i++) {
+        if (tasks[i].task == task) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Abort on an allocation from a watched task outside an exempt section */
+static void HeapAudit_Check(size_t size, void* caller) {
+    if (!armed || xPortInIsrContext()) {
+        return;
+    }
+    int8_t slot = HeapAudit_FindTask(xTaskGetCurrentTaskHandle());
+    if (slot < 0 || tasks[slot].exempt_depth > 0) {
+        return;
+    }
+
+    // ets_printf writes straight to the UART without allocating
+    ets_printf("HEAP AUDIT: %u bytes allocated after init by task %s, caller %p\n",
+               (unsigned)size, pcTaskGetTaskName(nullptr), caller);
+    abort();
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+    HeapAudit_Check(size, __builtin_return_address(0));
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+    HeapAudit_Check(count * size, __builtin_return_address(0));
+    return __real_calloc(count, size);
+}
+
+extern "C" void* __wrap_realloc(void* pointer, size_t size) {
+    HeapAudit_Check(size, __builtin_return_address(0));
+    return __real_realloc(pointer, size);
+}
+
+// Direct IDF allocations; pvPortMalloc() (queues, semaphores, task stacks) lands here
+extern "C" void* __wrap_heap_caps_malloc(size_t size, uint32_t caps) {
+    HeapAudit_Check(size, __builtin_return_address(0));
+    return __real_heap_caps_malloc(size, caps);
+}
+
+extern "C" void* __wrap_heap_caps_calloc(size_t count, size_t size, uint32_t caps) {
+    HeapAudit_Check(count * size, __builtin_return_address(0));
+    return __real_heap_caps_calloc(count, size, caps);
+}
+
+extern "C" void* __wrap_heap_caps_realloc(void* pointer, size_t size, uint32_t caps) {
+    HeapAudit_Check(size, __builtin_return_address(0));
+    return __real_heap_caps_realloc(pointer, size, caps);
+}
+
+/* Audit the calling task from HeapAudit_Arm() on */
+void HeapAudit_WatchTask(void) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    portENTER_CRITICAL(&watch_mux);
+    if (task_count < HEAP_AUDIT_MAX_TASKS && HeapAudit_FindTask(task) < 0) {
+        tasks[task_count].task = task;
+        tasks[task_count].exempt_depth = 0;
+        task_count++;
+    }
+    portEXIT_CRITICAL(&watch_mux);
+}
+
+/* End of initialization: every allocation from a watched task fails from here on */
+void HeapAudit_Arm(void) {
+    armed = true;
+    ets_printf("HEAP AUDIT: armed, %u task(s) watched\n", (unsigned)task_count);
+}
+
+HeapAuditScope::HeapAuditScope(bool exempt) : slot_(HeapAudit_FindTask(xTaskGetCurrentTaskHandle())), saved_depth_(0) {
+    if (slot_ < 0) {
+        return;
+    }
+    saved_depth_ = tasks[slot_].exempt_depth;
+    tasks[slot_].exempt_depth = exempt ? saved_depth_ + 1 : 0;
+}
+
+HeapAuditScope::~HeapAuditScope() {
+    if (slot_ >= 0) {
+        tasks[slot_].exempt_depth = saved_depth_;
+    }
+}
+
+#endif /* HEAP_AUDIT */
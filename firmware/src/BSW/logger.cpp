@@ -0,0 +1,178 @@
+/**
+ * @file logger.cpp
+ * @brief Deferred logging - BSW layer
+ * @version 1.0
+ * @date 2025-11-13
+ */
+
+#include <Arduino.h>
+#include "logger.h"
+#include "heap_audit.h"
+
+#define LOG_RING_MASK               ((uint32_t)LOG_RING_SIZE - 1)
+#define LOG_TASK_STACK              3072
+#define LOG_TASK_PRIORITY           1       /* Shares time with the loop task, below acquisition */
+#define LOG_IDLE_MS                 10      /* Ring poll period when empty */
+
+/* Bounded MPSC ring: a slot's sequence says whose turn it is. With
+ * lap = position rounded down to the ring size (so a zeroed ring is valid
+ * before Log_Init), sequence == lap: free for the producer claiming that
+ * position; sequence == lap + 1: filled, ready for the consumer. */
+typedef struct {
+    volatile uint32_t sequence;
+    uint32_t timestamp_us;
+    const char* format;
+    uint8_t level;
+    uint8_t arg_count;
+    uint32_t args[LOG_MAX_ARGS];
+} LogRecord_t;
+
+static LogRecord_t ring[LOG_RING_SIZE];
+static uint32_t write_position = 0;
+static uint32_t read_position = 0;
+static volatile uint32_t dropped = 0;
+static TaskHandle_t log_task = nullptr;
+static SemaphoreHandle_t output_mutex = nullptr;
+
+volatile uint8_t log_runtime_level = LOG_LEVEL;
+
+static const char level_tags[] = { ' ', 'E', 'W', 'I', 'D' };
+
+/**
+ * @brief Queue one record (any task or ISR, never blocks)
+ * @param level LOG_LEVEL_*
+ * @param format printf format; must stay valid (string literal)
+ * @param args Arguments as 32-bit words
+ * @param arg_count Number of arguments, at most LOG_MAX_ARGS
+ */
+void IRAM_ATTR Log_Write(uint8_t level, const char* format, const uint32_t* args, uint8_t arg_count) {
+    uint32_t position = __atomic_load_n(&write_position, __ATOMIC_RELAXED);
+    LogRecord_t* record;
+
+    for (;;) {
+        record = &ring[position & LOG_RING_MASK];
+        int32_t lag = (int32_t)(__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) - (position & ~LOG_RING_MASK));
+        if (lag == 0) {
+            if (__atomic_compare_exchange_n(&write_position, &position, position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (lag < 0) {
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);   // Full: the consumer is a lap behind
+            return;
+        } else {
+            position = __atomic_load_n(&write_position, __ATOMIC_RELAXED);
+        }
+    }
+
+    record->timestamp_us = micros();
+    record->format = format;
+    record->level = level;
+    record->arg_count = arg_count;
+    for (uint8_t i = 0; i < arg_count && i < LOG_MAX_ARGS; i++) {
+        record->args[i] = args[i];
+    }
+    __atomic_store_n(&record->sequence, (position & ~LOG_RING_MASK) + 1, __ATOMIC_RELEASE);
+}
+
+/* Format and print one record; false when the ring is empty */
+static bool Log_PrintNext(void) {
+    LogRecord_t* record = &ring[read_position & LOG_RING_MASK];
+    uint32_t lap = read_position & ~LOG_RING_MASK;
+    if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) != lap + 1) {
+        return false;
+    }
+
+    char line[LOG_LINE_LENGTH];
+    uint32_t ms = record->timestamp_us / 1000;
+    int length = snprintf(line, sizeof(line), "[%6lu.%03lu] %c ", (unsigned long)(ms / 1000),
+                          (unsigned long)(ms % 1000), level_tags[record->level <= LOG_LEVEL_DEBUG ? record->level : 0]);
+
+    // Every argument is one 32-bit word, so passing all slots matches any accepted format
+    const uint32_t* a = record->args;
+    length += snprintf(line + length, sizeof(line) - length - 1, record->format, a[0], a[1], a[2], a[3], a[4], a[5]);
+    if (length > (int)sizeof(line) - 2) {
+        length = sizeof(line) - 2;
+    }
+    line[length++] = '\n';
+
+    __atomic_store_n(&record->sequence, lap + LOG_RING_SIZE, __ATOMIC_RELEASE);
+    read_position++;
+
+    Log_LockOutput();
+    Serial.write((const uint8_t*)line, length);
+    Log_UnlockOutput();
+    return true;
+}
+
+static void Log_Task(void* param) {
+    uint32_t reported_dropped = 0;
+    HEAP_AUDIT_WATCH();
+
+    for (;;) {
+        while (Log_PrintNext()) {
+        }
+
+        uint32_t lost = dropped;
+        if (lost != reported_dropped) {
+            Log_LockOutput();
+            Serial.printf("[log] %lu record(s) dropped, ring full\n", (unsigned long)(lost - reported_dropped));
+            Log_UnlockOutput();
+            reported_dropped = lost;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOG_IDLE_MS));
+    }
+}
+
+/**
+ * @brief Prepare the ring and start the log task
+ * @details Records written before this call are kept and printed once the
+ *          task runs.
+ * @return STATUS_OK, STATUS_ERROR if the task or mutex could not be created
+ */
+Status_t Log_Init(void) {
+    if (log_task != nullptr) {
+        return STATUS_OK;
+    }
+
+    output_mutex = xSemaphoreCreateMutex();
+    if (output_mutex == nullptr) {
+        return STATUS_ERROR;
+    }
+    if (xTaskCreatePinnedToCore(Log_Task, "log", LOG_TASK_STACK, nullptr,
+                                LOG_TASK_PRIORITY, &log_task, tskNO_AFFINITY) != pdPASS) {
+        log_task = nullptr;
+        return STATUS_ERROR;
+    }
+    return STATUS_OK;
+}
+
+void Log_SetLevel(uint8_t level) {
+    log_runtime_level = (level <= LOG_LEVEL_DEBUG) ? level : LOG_LEVEL_DEBUG;
+}
+
+uint8_t Log_GetLevel(void) {
+    return log_runtime_level;
+}
+
+uint32_t Log_GetDropped(void) {
+    return dropped;
+}
+
+/* Multi-line serial output (JSON blocks, summaries) holds this so log lines do not split it */
+void Log_LockOutput(void) {
+    if (output_mutex != nullptr) {
+        xSemaphoreTake(output_mutex, portMAX_DELAY);
+    }
+}
+
+/* Non-blocking variant for the loop task: false while another task holds the port */
+bool Log_TryLockOutput(void) {
+    return output_mutex == nullptr || xSemaphoreTake(output_mutex, 0) == pdTRUE;
+}
+
+void Log_UnlockOutput(void) {
+    if (output_mutex != nullptr) {
+        xSemaphoreGive(output_mutex);
+    }
+}
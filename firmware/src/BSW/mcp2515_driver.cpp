@@ -9,12 +9,757 @@
 #include "hal_interface.h"
 #include "can_interface.h"
 #include "common_types.h"
-#include <CAN.h>
+#include "mcp2515_registers.h"
+#include "trace.h"
+#include "health_monitor.h"
+#include "heap_audit.h"
 #include <SPI.h>
+#include <Preferences.h>
+
+#define MCP2515_SPI_MAX_HZ          10000000    /* Datasheet limit */
+#define MCP2515_MODE_TIMEOUT_MS     10
+#define MCP2515_TX_TIMEOUT_MS       10          /* Shortest wait for the bus before a frame fails */
+#define MCP2515_TX_WAIT_FRAMES      64          /* Frame times a buffer may lose arbitration for */
+#define MCP2515_TX_FRAME_BITS       160         /* 29-bit, 8-byte frame with worst-case stuffing */
+#define MCP2515_TX_CHECK_US         1000        /* TXBnCTRL poll interval for an unfinished buffer */
+#define MCP2515_BUFFER_HEADER       5           /* SIDH, SIDL, EID8, EID0, DLC */
+#define MCP2515_TX_BUFFERS          3
+#define CAN_TX_REPORT_SIZE          (3 * MCP2515_TX_BUFFERS)    /* Completions between two reports */
+#define CAN_SEND_TIMEOUT_MS         100         /* CAN_SendFrame() wait, including queueing */
+#define CAN_SEND_WAITERS            4           /* Tasks blocked in CAN_SendFrame() at once */
+#define CAN_RX_TASK_STACK           3072
+#define CAN_RX_TASK_PRIORITY        5           /* Above the Arduino loop task */
+#define CAN_RX_HEALTH_BUDGET_US     2000        /* One wake-up: drain up to CAN_RX_MAX_PASSES */
+#define CAN_RX_POLL_MS              1           /* Fallback when INT stays asserted */
+#define CAN_RX_MAX_PASSES           8           /* Bound on one drain under flood */
+#define CAN_RECOVERY_BACKOFF_MIN_MS 20          /* First bus-off recovery attempt */
+#define CAN_RECOVERY_BACKOFF_MAX_MS 5000
+#define CAN_DETECT_WINDOW_MS        250         /* Listen time per bit timing candidate */
+#define CAN_DETECT_MIN_FRAMES       3           /* Valid frames needed to lock on */
+#define CAN_DETECT_MAX_ERRORS       3           /* Receive errors that reject a candidate */
+#define CAN_NVS_NAMESPACE           "can"
 
 // Static variables for hardware pins
 static HardwarePins_t g_pins;
 
+// Controller configuration and SPI settings derived from it
+static MCP2515_Config_t g_controller = { MCP2515_SPI_MAX_HZ, 16000000, 500000 };
+static SPISettings g_spi_settings;
+
+/* Bit timing registers per oscillator and bit rate */
+typedef struct {
+    uint32_t crystal_hz;
+    uint32_t bitrate;
+    uint8_t cnf1;
+    uint8_t cnf2;
+    uint8_t cnf3;
+} MCP2515_Timing_t;
+
+/* In auto-detection probe order per oscillator: OBD2's 500 kbps first */
+static const MCP2515_Timing_t g_timings[] = {
+    { 16000000,  500000, 0x00, 0xF0, 0x86 },
+    { 8000000,   500000, 0x00, 0x90, 0x02 },
+    { 16000000,  250000, 0x41, 0xF1, 0x85 },
+    { 8000000,   250000, 0x00, 0xB1, 0x05 },
+    { 16000000, 1000000, 0x00, 0xD0, 0x82 },
+    { 8000000,  1000000, 0x00, 0x80, 0x00 },
+    { 16000000,  125000, 0x03, 0xF0, 0x86 },
+    { 8000000,   125000, 0x01, 0xB1, 0x05 }
+};
+#define MCP2515_TIMING_COUNT    (sizeof(g_timings) / sizeof(g_timings[0]))
+
+// Outcome of listening with one candidate bit timing
+typedef enum {
+    CAN_PROBE_SILENT = 0,           /* Neither frames nor errors: nothing to learn */
+    CAN_PROBE_LOCKED = 1,           /* Error-free frames received */
+    CAN_PROBE_ERRORS = 2            /* Receive errors: wrong bit rate */
+} CAN_ProbeResult_t;
+
+// Receiver for frames that arrive while waiting for an OBD2 response
+static CAN_FrameCallback_t g_passive_callback = nullptr;
+
+// Physical target per OBD2 service: 0 = functional, n + 1 = ECU n
+#define CAN_OBD2_MODE_SLOTS     16
+static uint8_t g_obd2_target[CAN_OBD2_MODE_SLOTS];
+
+// OBD2 identifier width; with 29-bit IDs ECU n is the n-th source address seen
+static bool g_obd2_extended = false;
+static uint8_t g_ecu_address[CAN_OBD2_MAX_ECUS];
+static uint8_t g_ecu_count = 0;
+
+// Acceptance filter, re-applied after a controller reset (mask 0 = accept all)
+static uint32_t g_filter_id = 0;
+static uint32_t g_filter_mask = 0;
+
+// Transmit queue; entries are served by priority, then in sequence order.
+// Queue, buffer slots and stats are only touched with g_ctrl_mutex held.
+typedef struct {
+    CAN_Frame_t frame;
+    uint16_t sequence;
+    uint8_t priority;
+    uint32_t queued_us;
+} CAN_TxEntry_t;
+
+// Frame currently loaded in a TX buffer
+typedef struct {
+    bool busy;
+    uint8_t priority;
+    uint16_t sequence;
+    uint32_t can_id;
+    uint32_t queued_us;
+    uint32_t loaded_us;
+    uint32_t checked_us;    /* Last TXBnCTRL read */
+} CAN_TxBuffer_t;
+
+static CAN_TxEntry_t g_tx_queue[CAN_TX_QUEUE_SIZE];
+static uint8_t g_tx_queued = 0;
+static CAN_TxBuffer_t g_tx_buffers[MCP2515_TX_BUFFERS];
+static uint16_t g_tx_next_sequence = 0;
+static CAN_TxCallback_t g_tx_callback = nullptr;
+static CAN_TxStats_t g_tx_stats;
+
+// Longest a loaded frame may wait for the bus; scales with the bit rate
+static uint32_t g_tx_limit_us = MCP2515_TX_TIMEOUT_MS * 1000UL;
+
+// Completions waiting for the TX callback
+typedef struct {
+    uint16_t sequence;
+    bool sent;
+    uint32_t can_id;
+    uint32_t tx_time_us;
+} CAN_TxReport_t;
+
+static CAN_TxReport_t g_tx_reports[CAN_TX_REPORT_SIZE];
+static volatile uint8_t g_tx_report_count = 0;
+
+// A CAN_SendFrame() call blocked on its frame; lives on the caller's stack
+typedef enum {
+    CAN_SEND_PENDING = 0,
+    CAN_SEND_SENT,
+    CAN_SEND_FAILED
+} CAN_SendState_t;
+
+typedef struct {
+    uint16_t sequence;
+    volatile uint8_t state;     /* CAN_SendState_t, set by CAN_CompleteTx() */
+} CAN_SendWaiter_t;
+
+static CAN_SendWaiter_t* g_send_waiters[CAN_SEND_WAITERS];
+
+// TX buffers completed by the RX task, retired by CAN_ProcessTx()
+static volatile uint8_t g_tx_done_mask = 0;
+static volatile uint32_t g_tx_done_us[MCP2515_TX_BUFFERS];
+
+// Falling edge of the INT line; the edge time stamps the completed transmission
+static volatile uint32_t g_irq_time_us = 0;
+
+// Receive queue: single producer (RX task), single consumer (CAN_ReceiveFrame/CAN_ReceiveFrames)
+static CAN_Frame_t g_rx_queue[CAN_RX_QUEUE_SIZE];
+static volatile uint16_t g_rx_head = 0;
+static volatile uint16_t g_rx_tail = 0;
+static CAN_RxStats_t g_rx_stats;
+static uint32_t g_seq_id = CAN_SEQUENCE_CHECK_OFF;
+static uint32_t g_seq_expected = 0;
+static bool g_seq_synced = false;
+
+// Per-ID table: open addressing, written by the RX task only; a clear is requested, not done
+static CAN_IdStats_t g_id_stats[CAN_ID_STATS_SIZE];
+static uint32_t g_id_stats_untracked = 0;
+static volatile bool g_id_stats_clear = false;
+
+// Fault confinement state; residency holds completed periods only
+static CAN_ErrorStats_t g_err_stats;
+static uint32_t g_err_state_since = 0;
+static uint32_t g_bus_off_at = 0;
+static uint32_t g_recover_at = 0;
+
+// RX task, and the lock that keeps it out of multi-step controller sequences
+static TaskHandle_t g_rx_task = nullptr;
+static SemaphoreHandle_t g_ctrl_mutex = nullptr;
+
+/**
+ * @brief ECU index of an OBD2 response, or -1 if the frame is not one
+ * @details 11-bit: 0x7E8-0x7EF. 29-bit: 0x18DAF1xx, where xx is looked up
+ *          in (or added to) the ECU address table.
+ */
+static int8_t CAN_OBD2Slot(const CAN_Frame_t* frame) {
+    if (frame->extended != g_obd2_extended) {
+        return -1;
+    }
+    if (!frame->extended) {
+        uint32_t n = frame->id - CAN_OBD2_RESPONSE_BASE;
+        return (n < CAN_OBD2_MAX_ECUS) ? (int8_t)n : -1;
+    }
+    
+    if ((frame->id & 0x1FFFFF00) != CAN_OBD2_EXT_RESPONSE_BASE) {
+        return -1;
+    }
+    uint8_t address = frame->id & 0xFF;
+    for (uint8_t i = 0; i < g_ecu_count; i++) {
+        if (g_ecu_address[i] == address) {
+            return i;
+        }
+    }
+    if (g_ecu_count < CAN_OBD2_MAX_ECUS) {
+        g_ecu_address[g_ecu_count] = address;
+        return g_ecu_count++;
+    }
+    return -1;
+}
+
+/**
+ * @brief Check whether an OBD2 response comes from the ECU addressed for a service
+ */
+static inline bool CAN_IsFromTarget(int8_t slot, uint8_t mode) {
+    uint8_t target = (mode < CAN_OBD2_MODE_SLOTS) ? g_obd2_target[mode] : 0;
+    return target == 0 || slot == target - 1;
+}
+
+/**
+ * @brief Send a single-frame OBD2 request to a given request ID
+ */
+static Status_t CAN_SendOBD2To(uint32_t request_id, uint8_t mode, const uint8_t* params, uint8_t param_count) {
+    if (param_count > 6 || (param_count > 0 && params == nullptr)) {
+        return STATUS_INVALID_PARAM;
+    }
+    
+    CAN_Frame_t frame;
+    frame.id = request_id;
+    frame.length = 8;
+    frame.extended = g_obd2_extended;
+    frame.remote = false;
+    
+    // OBD2 request format: [Length, Mode, params..., padding]
+    frame.data[0] = 1 + param_count;
+    frame.data[1] = mode;
+    for (uint8_t i = 0; i < 6; i++) {
+        frame.data[2 + i] = (i < param_count) ? params[i] : 0x00;
+    }
+    
+    if (CAN_SendFrame(&frame)) {
+        return STATUS_OK;
+    }
+    return STATUS_ERROR;
+}
+
+/* ---------------------------------------------------------------------------
+ * SPI primitives; every access is a single chip-select burst
+ * ------------------------------------------------------------------------- */
+
+static inline void MCP2515_Select(void) {
+    SPI.beginTransaction(g_spi_settings);
+    digitalWrite(g_pins.mcp2515_cs, LOW);
+}
+
+static inline void MCP2515_Deselect(void) {
+    digitalWrite(g_pins.mcp2515_cs, HIGH);
+    SPI.endTransaction();
+}
+
+static void MCP2515_Instruction(uint8_t instruction) {
+    MCP2515_Select();
+    SPI.transfer(instruction);
+    MCP2515_Deselect();
+}
+
+static uint8_t MCP2515_ReadRegister(uint8_t address) {
+    MCP2515_Select();
+    SPI.transfer(MCP_INSTR_READ);
+    SPI.transfer(address);
+    uint8_t value = SPI.transfer(0x00);
+    MCP2515_Deselect();
+    return value;
+}
+
+static void MCP2515_ReadRegisters(uint8_t address, uint8_t* values, uint8_t count) {
+    MCP2515_Select();
+    SPI.transfer(MCP_INSTR_READ);
+    SPI.transfer(address);
+    memset(values, 0, count);
+    SPI.transferBytes(values, values, count);
+    MCP2515_Deselect();
+}
+
+static void MCP2515_WriteRegisters(uint8_t address, const uint8_t* values, uint8_t count) {
+    MCP2515_Select();
+    SPI.transfer(MCP_INSTR_WRITE);
+    SPI.transfer(address);
+    SPI.writeBytes(values, count);
+    MCP2515_Deselect();
+}
+
+static void MCP2515_WriteRegister(uint8_t address, uint8_t value) {
+    MCP2515_WriteRegisters(address, &value, 1);
+}
+
+static void MCP2515_BitModify(uint8_t address, uint8_t mask, uint8_t value) {
+    MCP2515_Select();
+    SPI.transfer(MCP_INSTR_BIT_MODIFY);
+    SPI.transfer(address);
+    SPI.transfer(mask);
+    SPI.transfer(value);
+    MCP2515_Deselect();
+}
+
+/* Request an operating mode and wait until CANSTAT confirms it */
+static bool MCP2515_SetMode(uint8_t mode) {
+    MCP2515_BitModify(MCP_REG_CANCTRL, MCP_MODE_MASK, mode);
+    
+    uint32_t start_time = millis();
+    while ((MCP2515_ReadRegister(MCP_REG_CANSTAT) & MCP_MODE_MASK) != mode) {
+        if ((millis() - start_time) > MCP2515_MODE_TIMEOUT_MS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Pack an identifier into SIDH, SIDL, EID8, EID0 */
+static void MCP2515_EncodeId(uint32_t id, bool extended, uint8_t* out) {
+    if (extended) {
+        out[0] = (uint8_t)(id >> 21);
+        out[1] = (uint8_t)(((id >> 13) & 0xE0) | MCP_SIDL_IDE | ((id >> 16) & 0x03));
+        out[2] = (uint8_t)(id >> 8);
+        out[3] = (uint8_t)id;
+    } else {
+        out[0] = (uint8_t)(id >> 3);
+        out[1] = (uint8_t)((id & 0x07) << 5);
+        out[2] = 0;
+        out[3] = 0;
+    }
+}
+
+/* Write masks and all six filters; controller must be in configuration mode */
+static void MCP2515_WriteFilters(uint32_t filter_id, uint32_t mask_id) {
+    static const uint8_t filter_regs[6] = {
+        MCP_REG_RXF0SIDH, MCP_REG_RXF1SIDH, MCP_REG_RXF2SIDH,
+        MCP_REG_RXF3SIDH, MCP_REG_RXF4SIDH, MCP_REG_RXF5SIDH
+    };
+    bool extended = (filter_id > 0x7FF || mask_id > 0x7FF);
+    uint8_t mask[4];
+    uint8_t filter[4];
+    
+    MCP2515_EncodeId(mask_id, extended, mask);
+    mask[1] &= ~MCP_SIDL_IDE;           // Mask registers have no IDE bit
+    MCP2515_EncodeId(filter_id, extended, filter);
+    
+    MCP2515_WriteRegisters(MCP_REG_RXM0SIDH, mask, 4);
+    MCP2515_WriteRegisters(MCP_REG_RXM1SIDH, mask, 4);
+    for (uint8_t i = 0; i < 6; i++) {
+        MCP2515_WriteRegisters(filter_regs[i], filter, 4);
+    }
+    
+    // RXB0 rolls over into RXB1 so two back-to-back frames fit
+    uint8_t rxm = (mask_id == 0) ? MCP_RXB_RXM_ANY : MCP_RXB_RXM_FILTER;
+    MCP2515_WriteRegister(MCP_REG_RXB0CTRL, rxm | MCP_RXB0_BUKT);
+    MCP2515_WriteRegister(MCP_REG_RXB1CTRL, rxm);
+}
+
+static void CAN_CompleteTx(uint8_t buffer, bool sent, uint32_t tx_time_us);
+static void CAN_SetErrorState(uint8_t state);
+
+static const MCP2515_Timing_t* MCP2515_FindTiming(uint32_t crystal_hz, uint32_t bitrate) {
+    for (uint8_t i = 0; i < MCP2515_TIMING_COUNT; i++) {
+        if (g_timings[i].crystal_hz == crystal_hz && g_timings[i].bitrate == bitrate) {
+            return &g_timings[i];
+        }
+    }
+    return nullptr;
+}
+
+/* Soft reset and full register setup; leaves the controller in normal mode */
+static bool MCP2515_Configure(void) {
+    const MCP2515_Timing_t* timing = MCP2515_FindTiming(g_controller.crystal_hz, g_controller.bitrate);
+    if (timing == nullptr) {
+        return false;
+    }
+    
+    // A reset clears the TX buffers; queued frames are kept
+    for (uint8_t i = 0; i < MCP2515_TX_BUFFERS; i++) {
+        if (g_tx_buffers[i].busy) {
+            CAN_CompleteTx(i, false, micros());
+        }
+    }
+    
+    MCP2515_Instruction(MCP_INSTR_RESET);
+    delay(1);   // Oscillator start-up
+    if ((MCP2515_ReadRegister(MCP_REG_CANSTAT) & MCP_MODE_MASK) != MCP_MODE_CONFIG) {
+        return false;
+    }
+    
+    // CNF3, CNF2, CNF1 are consecutive registers
+    uint8_t cnf[3] = { timing->cnf3, timing->cnf2, timing->cnf1 };
+    MCP2515_WriteRegisters(MCP_REG_CNF3, cnf, 3);
+    
+    MCP2515_WriteFilters(g_filter_id, g_filter_mask);
+    MCP2515_WriteRegister(MCP_REG_CANINTE, MCP_INT_RX0 | MCP_INT_RX1 | MCP_INT_TX0 | MCP_INT_TX1 |
+                                           MCP_INT_TX2 | MCP_INT_ERR);
+    MCP2515_WriteRegister(MCP_REG_CANINTF, 0x00);
+    __atomic_store_n(&g_tx_done_mask, 0, __ATOMIC_SEQ_CST);
+    
+    uint32_t limit_us = (uint32_t)((uint64_t)MCP2515_TX_WAIT_FRAMES * MCP2515_TX_FRAME_BITS *
+                                   1000000ULL / g_controller.bitrate);
+    g_tx_limit_us = (limit_us > MCP2515_TX_TIMEOUT_MS * 1000UL) ? limit_us : MCP2515_TX_TIMEOUT_MS * 1000UL;
+    
+    // Error counters restart from zero
+    g_rx_stats.eflg = 0;
+    CAN_SetErrorState(CAN_ERROR_ACTIVE);
+    
+    return MCP2515_SetMode(MCP_MODE_NORMAL);
+}
+
+/**
+ * @brief INT line handler; records the edge and wakes the RX task
+ */
+static void IRAM_ATTR CAN_InterruptHandler(void) {
+    g_irq_time_us = micros();
+    TRACE_INSTANT(TRACE_EV_CAN_IRQ, 0);
+    if (g_rx_task != nullptr) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(g_rx_task, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+/**
+ * @brief Read one RX buffer (header and payload) in a single READ RX BUFFER burst
+ * @details Raising chip select clears the buffer's RXnIF.
+ */
+static void MCP2515_ReadRxBuffer(uint8_t instruction, CAN_Frame_t* frame) {
+    uint8_t header[MCP2515_BUFFER_HEADER] = {0};
+    MCP2515_Select();
+    SPI.transfer(instruction);
+    SPI.transferBytes(header, header, MCP2515_BUFFER_HEADER);
+    
+    frame->length = header[4] & MCP_DLC_MASK;
+    if (frame->length > 8) {
+        frame->length = 8;
+    }
+    memset(frame->data, 0, sizeof(frame->data));
+    SPI.transferBytes(frame->data, frame->data, frame->length);
+    MCP2515_Deselect();
+    
+    // Decode identifier
+    frame->extended = (header[1] & MCP_SIDL_IDE) != 0;
+    uint32_t sid = ((uint32_t)header[0] << 3) | (header[1] >> 5);
+    if (frame->extended) {
+        frame->id = (sid << 18) | ((uint32_t)(header[1] & 0x03) << 16) | ((uint32_t)header[2] << 8) | header[3];
+        frame->remote = (header[4] & MCP_DLC_RTR) != 0;
+    } else {
+        frame->id = sid;
+        frame->remote = (header[1] & MCP_SIDL_SRR) != 0;
+    }
+}
+
+/**
+ * @brief Count a frame in the per-ID table
+ * @details An empty entry has frames == 0. Entries are never removed, so a
+ *          reader copying the table sees each ID in one place.
+ */
+static void CAN_CountId(const CAN_Frame_t* frame) {
+    if (g_id_stats_clear) {
+        memset(g_id_stats, 0, sizeof(g_id_stats));
+        g_id_stats_untracked = 0;
+        g_id_stats_clear = false;
+    }
+    
+    uint32_t key = CAN_FrameKey(frame);
+    uint32_t slot = (key * 2654435761UL) >> 16;     // Fibonacci hash; IDs are often sequential
+    for (uint8_t probe = 0; probe < CAN_ID_STATS_SIZE; probe++) {
+        CAN_IdStats_t* s = &g_id_stats[(slot + probe) & (CAN_ID_STATS_SIZE - 1)];
+        
+        if (s->frames == 0) {
+            s->key = key;
+            s->min_period_us = UINT32_MAX;
+            s->max_period_us = 0;
+        } else if (s->key != key) {
+            continue;
+        } else {
+            uint32_t period = frame->timestamp_us - s->last_us;
+            if (period < s->min_period_us) {
+                s->min_period_us = period;
+            }
+            if (period > s->max_period_us) {
+                s->max_period_us = period;
+            }
+        }
+        s->last_us = frame->timestamp_us;
+        s->length = frame->length;
+        s->frames++;
+        return;
+    }
+    g_id_stats_untracked++;
+}
+
+/**
+ * @brief Hand a received frame to the consumer side
+ */
+static void CAN_PushRxFrame(const CAN_Frame_t* frame) {
+    g_rx_stats.frames++;
+    CAN_CountId(frame);
+    
+    // Loss check on a counter stream (big-endian uint32 in bytes 0-3)
+    if (CAN_FrameKey(frame) == g_seq_id && frame->length >= 4) {
+        uint32_t seq = ((uint32_t)frame->data[0] << 24) | ((uint32_t)frame->data[1] << 16) |
+                       ((uint32_t)frame->data[2] << 8) | frame->data[3];
+        // A counter that jumps backwards (sender restarted) resynchronises
+        if (g_seq_synced && (int32_t)(seq - g_seq_expected) > 0) {
+            g_rx_stats.seq_lost += seq - g_seq_expected;
+        }
+        g_seq_expected = seq + 1;
+        g_seq_synced = true;
+        g_rx_stats.seq_frames++;
+    }
+    
+    uint16_t head = g_rx_head;
+    uint16_t next = (head + 1) % CAN_RX_QUEUE_SIZE;
+    if (next == g_rx_tail) {
+        g_rx_stats.queue_overflows++;
+        return;
+    }
+    g_rx_queue[head] = *frame;
+    __sync_synchronize();   // Frame is visible before the index moves
+    g_rx_head = next;
+    
+    uint16_t depth = (next + CAN_RX_QUEUE_SIZE - g_rx_tail) % CAN_RX_QUEUE_SIZE;
+    if (depth > g_rx_stats.queue_high_water) {
+        g_rx_stats.queue_high_water = depth;
+    }
+}
+
+/**
+ * @brief Move the fault confinement state machine, accounting residency and recovery time
+ */
+static void CAN_SetErrorState(uint8_t state) {
+    if (state == g_err_stats.state) {
+        return;
+    }
+    
+    uint32_t now = millis();
+    g_err_stats.residency_ms[g_err_stats.state] += now - g_err_state_since;
+    g_err_state_since = now;
+    
+    if (state == CAN_ERROR_BUS_OFF) {
+        g_bus_off_at = now;
+        g_err_stats.backoff_ms = CAN_RECOVERY_BACKOFF_MIN_MS;
+        g_recover_at = now + g_err_stats.backoff_ms;
+    } else if (g_err_stats.state == CAN_ERROR_BUS_OFF) {
+        uint32_t took = now - g_bus_off_at;
+        g_err_stats.recoveries++;
+        g_err_stats.last_recovery_ms = took;
+        if (took > g_err_stats.max_recovery_ms) {
+            g_err_stats.max_recovery_ms = took;
+        }
+        g_err_stats.backoff_ms = 0;
+    }
+    g_err_stats.state = state;
+}
+
+/**
+ * @brief Count overflows and error-state transitions from EFLG, refresh TEC/REC
+ */
+static void CAN_UpdateErrorState(uint8_t canintf, uint8_t eflg) {
+    uint8_t previous = g_rx_stats.eflg;
+    
+    if (eflg & MCP_EFLG_RX0OVR) {
+        g_rx_stats.hw_overflows++;
+    }
+    if (eflg & MCP_EFLG_RX1OVR) {
+        g_rx_stats.hw_overflows++;
+    }
+    if (eflg & (MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR)) {
+        MCP2515_BitModify(MCP_REG_EFLG, MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR, 0);
+        eflg &= ~(MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR);
+    }
+    if (canintf & MCP_INT_ERR) {
+        MCP2515_BitModify(MCP_REG_CANINTF, MCP_INT_ERR, 0);
+    }
+    
+    // Rising edges only
+    uint8_t raised = eflg & ~previous;
+    if (raised & MCP_EFLG_EWARN) {
+        g_rx_stats.error_warnings++;
+    }
+    if ((raised & (MCP_EFLG_RXEP | MCP_EFLG_TXEP)) && !(previous & (MCP_EFLG_RXEP | MCP_EFLG_TXEP))) {
+        g_rx_stats.error_passive++;
+    }
+    if (raised & MCP_EFLG_TXBO) {
+        g_rx_stats.bus_off++;
+    }
+    g_rx_stats.eflg = eflg;
+    
+    if (eflg & MCP_EFLG_TXBO) {
+        CAN_SetErrorState(CAN_ERROR_BUS_OFF);
+    } else if (eflg & (MCP_EFLG_TXEP | MCP_EFLG_RXEP)) {
+        CAN_SetErrorState(CAN_ERROR_PASSIVE);
+    } else {
+        CAN_SetErrorState(CAN_ERROR_ACTIVE);
+    }
+    
+    uint8_t counters[2];
+    MCP2515_ReadRegisters(MCP_REG_TEC, counters, 2);
+    g_rx_stats.tec = counters[0];
+    g_rx_stats.rec = counters[1];
+    if (counters[0] > g_rx_stats.max_tec) {
+        g_rx_stats.max_tec = counters[0];
+    }
+    if (counters[1] > g_rx_stats.max_rec) {
+        g_rx_stats.max_rec = counters[1];
+    }
+}
+
+/**
+ * @brief Empty both RX buffers and collect TX completions
+ * @details CANINTF and EFLG come in one two-byte burst per pass; passes
+ *          repeat until no receive flag is left, so frames that arrive
+ *          during the drain are taken in the same wake-up.
+ * @param tx_time_us Time stamped on TX buffers found complete
+ * @return Number of frames received
+ */
+static uint8_t CAN_DrainRx(uint32_t tx_time_us) {
+    uint8_t received = 0;
+    TRACE_BEGIN(TRACE_EV_CAN_DRAIN, 0);
+    
+    for (uint8_t pass = 0; pass < CAN_RX_MAX_PASSES; pass++) {
+        uint8_t flags[2];   // CANINTF, EFLG
+        MCP2515_ReadRegisters(MCP_REG_CANINTF, flags, 2);
+        
+        if ((flags[0] & MCP_INT_ERR) || flags[1] != g_rx_stats.eflg) {
+            CAN_UpdateErrorState(flags[0], flags[1]);
+        }
+        
+        uint8_t tx_flags = flags[0] & (MCP_INT_TX0 | MCP_INT_TX1 | MCP_INT_TX2);
+        if (tx_flags) {
+            for (uint8_t i = 0; i < MCP2515_TX_BUFFERS; i++) {
+                if (tx_flags & (MCP_INT_TX0 << i)) {
+                    g_tx_done_us[i] = tx_time_us;
+                }
+            }
+            MCP2515_BitModify(MCP_REG_CANINTF, tx_flags, 0);
+            __atomic_fetch_or(&g_tx_done_mask, tx_flags / MCP_INT_TX0, __ATOMIC_SEQ_CST);
+        }
+        
+        if ((flags[0] & (MCP_INT_RX0 | MCP_INT_RX1)) == 0) {
+            break;
+        }
+        
+        // With rollover RXB0 holds the older frame
+        CAN_Frame_t frame;
+        if (flags[0] & MCP_INT_RX0) {
+            MCP2515_ReadRxBuffer(MCP_INSTR_READ_RXB0, &frame);
+            frame.timestamp_us = micros();
+            CAN_PushRxFrame(&frame);
+            received++;
+        }
+        if (flags[0] & MCP_INT_RX1) {
+            MCP2515_ReadRxBuffer(MCP_INSTR_READ_RXB1, &frame);
+            frame.timestamp_us = micros();
+            CAN_PushRxFrame(&frame);
+            received++;
+        }
+    }
+    
+    if (received > g_rx_stats.max_burst) {
+        g_rx_stats.max_burst = received;
+    }
+    TRACE_END(TRACE_EV_CAN_DRAIN, received);
+    return received;
+}
+
+/**
+ * @brief Leave bus-off through a configuration/normal mode round trip
+ * @details Registers, filters and queues are untouched. If the controller
+ *          is still bus-off the next attempt waits twice as long.
+ */
+static void CAN_AttemptRecovery(void) {
+    g_err_stats.recovery_attempts++;
+    if (MCP2515_SetMode(MCP_MODE_CONFIG)) {
+        MCP2515_SetMode(MCP_MODE_NORMAL);
+    }
+    
+    uint8_t flags[2];   // CANINTF, EFLG
+    MCP2515_ReadRegisters(MCP_REG_CANINTF, flags, 2);
+    CAN_UpdateErrorState(flags[0], flags[1]);
+    
+    if (g_err_stats.state == CAN_ERROR_BUS_OFF) {
+        g_err_stats.backoff_ms *= 2;
+        if (g_err_stats.backoff_ms > CAN_RECOVERY_BACKOFF_MAX_MS) {
+            g_err_stats.backoff_ms = CAN_RECOVERY_BACKOFF_MAX_MS;
+        }
+        g_recover_at = millis() + g_err_stats.backoff_ms;
+    }
+}
+
+/**
+ * @brief RX task: drains the controller on every INT edge, runs bus-off recovery
+ */
+static void CAN_RxTask(void* param) {
+    int8_t health = Health_Register("can_rx", CAN_RX_HEALTH_BUDGET_US, HEALTH_FLAG_TASK | HEALTH_FLAG_WATCHDOG);
+    HEAP_AUDIT_WATCH();
+    
+    for (;;) {
+        // Edge wake-up; the timeout covers an INT line that never went high again
+        bool woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_RX_POLL_MS)) > 0;
+        Health_Begin(health);
+        
+        if (g_err_stats.state == CAN_ERROR_BUS_OFF && (int32_t)(millis() - g_recover_at) >= 0) {
+            xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+            CAN_AttemptRecovery();
+            xSemaphoreGive(g_ctrl_mutex);
+        }
+        
+        if (!woken && digitalRead(g_pins.mcp2515_int) == HIGH) {
+            Health_End(health);
+            continue;
+        }
+        
+        xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+        CAN_DrainRx(woken ? g_irq_time_us : micros());
+        xSemaphoreGive(g_ctrl_mutex);
+        Health_End(health);
+    }
+}
+
+/**
+ * @brief Configure the controller with the RX task held off
+ */
+static bool CAN_ConfigureLocked(void) {
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    bool ok = MCP2515_Configure();
+    xSemaphoreGive(g_ctrl_mutex);
+    return ok;
+}
+
+/**
+ * @brief Set oscillator, bit rate and SPI clock used by the next initialization
+ * @param config Controller configuration; SPI clock is limited to 10 MHz
+ * @return true if the oscillator/bit rate combination is supported
+ */
+bool CAN_ConfigureController(const MCP2515_Config_t* config) {
+    if (config == nullptr) {
+        return false;
+    }
+    
+    if (MCP2515_FindTiming(config->crystal_hz, config->bitrate) == nullptr) {
+        return false;
+    }
+    
+    g_controller = *config;
+    if (g_controller.spi_clock_hz == 0 || g_controller.spi_clock_hz > MCP2515_SPI_MAX_HZ) {
+        g_controller.spi_clock_hz = MCP2515_SPI_MAX_HZ;
+    }
+    return true;
+}
+
+/**
+ * @brief Get the controller configuration in use
+ */
+const MCP2515_Config_t* CAN_GetControllerConfig(void) {
+    return &g_controller;
+}
+
 /**
  * @brief Initialize MCP2515 CAN controller
  * @param pins Hardware pin configuration
@@ -34,44 +779,423 @@ bool CAN_InitMCP2515(const HardwarePins_t* pins) {
     // Store pin configuration
     g_pins = *pins;
     
+    if (g_ctrl_mutex == nullptr) {
+        g_ctrl_mutex = xSemaphoreCreateMutex();
+        if (g_ctrl_mutex == nullptr) {
+            return false;
+        }
+    }
+    
+    // Chip select is driven by the driver so a whole burst stays selected
+    pinMode(pins->mcp2515_cs, OUTPUT);
+    digitalWrite(pins->mcp2515_cs, HIGH);
+    pinMode(pins->mcp2515_int, INPUT);
+    attachInterrupt(digitalPinToInterrupt(pins->mcp2515_int), CAN_InterruptHandler, FALLING);
+    
     // Initialize SPI with custom pins
-    SPI.begin(pins->spi_sck, pins->spi_miso, pins->spi_mosi, pins->mcp2515_cs);
+    SPI.begin(pins->spi_sck, pins->spi_miso, pins->spi_mosi, -1);
+    g_spi_settings = SPISettings(g_controller.spi_clock_hz, MSBFIRST, SPI_MODE0);
+    
+    // Reset, bit timing (500 kbps OBD2 by default), filters, normal mode
+    if (!CAN_ConfigureLocked()) {
+        return false;
+    }
+    
+    // Receive is interrupt driven from here on
+    if (g_rx_task == nullptr &&
+        xTaskCreatePinnedToCore(CAN_RxTask, "can_rx", CAN_RX_TASK_STACK, nullptr,
+                                CAN_RX_TASK_PRIORITY, &g_rx_task, tskNO_AFFINITY) != pdPASS) {
+        g_rx_task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write a frame into a TX buffer and request transmission
+ * @details Caller holds g_ctrl_mutex.
+ */
+static void CAN_WriteTxBuffer(uint8_t buffer, const CAN_Frame_t* frame, uint8_t priority) {
+    uint8_t tx[MCP2515_BUFFER_HEADER + 8];
+    MCP2515_EncodeId(frame->id, frame->extended, tx);
+    tx[4] = frame->length | (frame->remote ? MCP_DLC_RTR : 0);
+    memcpy(&tx[MCP2515_BUFFER_HEADER], frame->data, frame->length);
+    
+    // Drop a completion left over from an aborted frame in this buffer
+    __atomic_fetch_and(&g_tx_done_mask, (uint8_t)~(1 << buffer), __ATOMIC_SEQ_CST);
+    
+    // Controller arbitrates between loaded buffers by TXP
+    MCP2515_WriteRegister(MCP_REG_TXBCTRL(buffer), priority & MCP_TXB_TXP_MASK);
+    MCP2515_Select();
+    SPI.transfer(MCP_INSTR_LOAD_TXB(buffer));
+    SPI.writeBytes(tx, MCP2515_BUFFER_HEADER + (frame->remote ? 0 : frame->length));
+    MCP2515_Deselect();
+    MCP2515_Instruction(MCP_INSTR_RTS(buffer));
+}
+
+/**
+ * @brief Load a queue entry into a free TX buffer
+ * @details Caller holds g_ctrl_mutex.
+ */
+static void CAN_LoadTxBuffer(uint8_t buffer, const CAN_TxEntry_t* entry) {
+    CAN_WriteTxBuffer(buffer, &entry->frame, entry->priority);
+    
+    CAN_TxBuffer_t* slot = &g_tx_buffers[buffer];
+    slot->busy = true;
+    slot->priority = entry->priority;
+    slot->sequence = entry->sequence;
+    slot->can_id = entry->frame.id;
+    slot->queued_us = entry->queued_us;
+    slot->loaded_us = micros();
+    slot->checked_us = slot->loaded_us;
+}
+
+/**
+ * @brief Release a TX buffer and record the outcome
+ * @details Caller holds g_ctrl_mutex. The TX callback may queue the next
+ *          frame, so it is not called here: the outcome is kept for
+ *          CAN_ReportTx(), which runs after the lock is released.
+ */
+static void CAN_CompleteTx(uint8_t buffer, bool sent, uint32_t tx_time_us) {
+    CAN_TxBuffer_t* slot = &g_tx_buffers[buffer];
+    slot->busy = false;
+    
+    if (sent) {
+        g_tx_stats.sent++;
+        uint32_t latency = tx_time_us - slot->queued_us;
+        if (latency > g_tx_stats.max_latency_us) {
+            g_tx_stats.max_latency_us = latency;
+        }
+    } else {
+        g_tx_stats.failed++;
+    }
+    
+    for (uint8_t i = 0; i < CAN_SEND_WAITERS; i++) {
+        CAN_SendWaiter_t* waiter = g_send_waiters[i];
+        if (waiter != nullptr && waiter->sequence == slot->sequence) {
+            waiter->state = sent ? CAN_SEND_SENT : CAN_SEND_FAILED;
+        }
+    }
+    if (g_tx_callback != nullptr && g_tx_report_count < CAN_TX_REPORT_SIZE) {
+        CAN_TxReport_t* report = &g_tx_reports[g_tx_report_count++];
+        report->sequence = slot->sequence;
+        report->sent = sent;
+        report->can_id = slot->can_id;
+        report->tx_time_us = tx_time_us;
+    }
+}
+
+/**
+ * @brief Pass recorded completions to the TX callback
+ * @details Called without g_ctrl_mutex, after every locked TX sequence.
+ */
+static void CAN_ReportTx(void) {
+    if (g_tx_report_count == 0) {
+        return;
+    }
+    
+    CAN_TxReport_t reports[CAN_TX_REPORT_SIZE];
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    uint8_t count = g_tx_report_count;
+    memcpy(reports, g_tx_reports, count * sizeof(CAN_TxReport_t));
+    g_tx_report_count = 0;
+    xSemaphoreGive(g_ctrl_mutex);
+    
+    CAN_TxCallback_t callback = g_tx_callback;
+    for (uint8_t i = 0; i < count && callback != nullptr; i++) {
+        callback(reports[i].sequence, reports[i].can_id, reports[i].tx_time_us, reports[i].sent);
+    }
+}
+
+/**
+ * @brief Index of the next queue entry to transmit (highest priority, oldest first)
+ */
+static int8_t CAN_NextTxEntry(void) {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < g_tx_queued; i++) {
+        if (best < 0 || g_tx_queue[i].priority > g_tx_queue[best].priority ||
+            (g_tx_queue[i].priority == g_tx_queue[best].priority &&
+             (int16_t)(g_tx_queue[i].sequence - g_tx_queue[best].sequence) < 0)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Whether a frame of this priority may be loaded without overtaking
+ * @details With equal TXP the MCP2515 sends the highest-numbered buffer
+ *          first, so a frame must not be loaded above a busy buffer that
+ *          holds an older frame of the same priority.
+ */
+static bool CAN_TxBufferInOrder(uint8_t buffer, uint8_t priority) {
+    for (uint8_t i = 0; i < buffer; i++) {
+        if (g_tx_buffers[i].busy && g_tx_buffers[i].priority == priority) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Whether CAN_ServiceTxLocked() has anything to do
+ * @details Unlocked hint for the spin loops that call CAN_ProcessTx(); a
+ *          stale answer only delays the work to the next call.
+ */
+static bool CAN_TxIdle(void) {
+    if (g_tx_queued > 0 || __atomic_load_n(&g_tx_done_mask, __ATOMIC_SEQ_CST) != 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < MCP2515_TX_BUFFERS; i++) {
+        if (g_tx_buffers[i].busy) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Retire completed TX buffers and refill them from the queue
+ * @details Caller holds g_ctrl_mutex. Completions are collected by the RX
+ *          task together with received frames, so this is SPI-free unless
+ *          a buffer has to be loaded or one has been waiting for more than
+ *          MCP2515_TX_CHECK_US. Such a buffer's TXBnCTRL is read at that
+ *          interval: errors fail the frame at once, lost arbitration only
+ *          after g_tx_limit_us (see MCP_TxVerdict()).
+ */
+static void CAN_ServiceTxLocked(void) {
+    uint8_t done = __atomic_exchange_n(&g_tx_done_mask, 0, __ATOMIC_SEQ_CST);
+    uint32_t now = micros();
+    
+    for (uint8_t i = 0; i < MCP2515_TX_BUFFERS; i++) {
+        CAN_TxBuffer_t* slot = &g_tx_buffers[i];
+        if (!slot->busy) {
+            continue;
+        }
+        if (done & (1 << i)) {
+            CAN_CompleteTx(i, true, g_tx_done_us[i]);
+            continue;
+        }
+        if ((now - slot->checked_us) < MCP2515_TX_CHECK_US) {
+            continue;
+        }
+        
+        slot->checked_us = now;
+        uint8_t ctrl = MCP2515_ReadRegister(MCP_REG_TXBCTRL(i));
+        MCP_TxVerdict_t verdict = MCP_TxVerdict(ctrl, now - slot->loaded_us, g_tx_limit_us);
+        if (verdict == MCP_TX_FAILED) {
+            if (ctrl & MCP_TXB_TXREQ) {
+                MCP2515_BitModify(MCP_REG_TXBCTRL(i), MCP_TXB_TXREQ, 0);
+            }
+            CAN_CompleteTx(i, false, now);
+        } else if (verdict == MCP_TX_SENT) {
+            CAN_CompleteTx(i, true, now);
+        }
+    }
+    
+    // Fill free buffers from the top, oldest frame in the highest buffer
+    for (int8_t i = MCP2515_TX_BUFFERS - 1; i >= 0 && g_tx_queued > 0; i--) {
+        if (g_tx_buffers[i].busy) {
+            continue;
+        }
+        int8_t next = CAN_NextTxEntry();
+        if (!CAN_TxBufferInOrder(i, g_tx_queue[next].priority)) {
+            continue;
+        }
+        CAN_LoadTxBuffer(i, &g_tx_queue[next]);
+        g_tx_queue[next] = g_tx_queue[--g_tx_queued];
+    }
+}
+
+/**
+ * @brief Append a frame to the TX queue and service the buffers
+ * @details Caller holds g_ctrl_mutex.
+ */
+static Status_t CAN_EnqueueLocked(const CAN_Frame_t* frame, uint8_t priority, uint16_t* sequence) {
+    // Make room from buffers that have completed in the meantime
+    CAN_ServiceTxLocked();
+    if (g_tx_queued >= CAN_TX_QUEUE_SIZE) {
+        g_tx_stats.queue_full++;
+        return STATUS_BUSY;
+    }
+    
+    CAN_TxEntry_t* entry = &g_tx_queue[g_tx_queued++];
+    entry->frame = *frame;
+    entry->priority = priority;
+    entry->sequence = g_tx_next_sequence++;
+    entry->queued_us = micros();
+    if (sequence != nullptr) {
+        *sequence = entry->sequence;
+    }
+    
+    g_tx_stats.queued++;
+    if (g_tx_queued > g_tx_stats.max_queue_depth) {
+        g_tx_stats.max_queue_depth = g_tx_queued;
+    }
+    
+    CAN_ServiceTxLocked();
+    return STATUS_OK;
+}
+
+/**
+ * @brief Queue a frame for transmission
+ * @details The frame is loaded into a TX buffer immediately when one is free
+ *          below the older frames of its priority, so up to three frames are
+ *          in the controller at a time and each priority leaves in order.
+ * @param frame Frame to send (copied)
+ * @param priority CAN_TxPriority_t
+ * @param sequence Optional; receives the number reported to the TX callback
+ * @return STATUS_OK if queued, STATUS_BUSY if the queue is full,
+ *         STATUS_NOT_INITIALIZED before CAN_InitMCP2515()
+ */
+Status_t CAN_QueueFrame(const CAN_Frame_t* frame, uint8_t priority, uint16_t* sequence) {
+    if (frame == nullptr || frame->length > 8 || priority > CAN_TX_PRIORITY_URGENT) {
+        return STATUS_INVALID_PARAM;
+    }
+    if (g_ctrl_mutex == nullptr) {
+        return STATUS_NOT_INITIALIZED;
+    }
+    
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    Status_t status = CAN_EnqueueLocked(frame, priority, sequence);
+    xSemaphoreGive(g_ctrl_mutex);
+    
+    CAN_ReportTx();
+    return status;
+}
+
+/**
+ * @brief Retire completed TX buffers and refill them from the queue
+ * @details Queue and buffer state only change under the controller lock;
+ *          it is not taken while the TX path is idle. The TX callback runs
+ *          here, after the lock is released.
+ */
+void CAN_ProcessTx(void) {
+    if (g_ctrl_mutex == nullptr || CAN_TxIdle()) {
+        CAN_ReportTx();
+        return;
+    }
     
-    // Set MCP2515 pins (CS and INT)
-    CAN.setPins(pins->mcp2515_cs, pins->mcp2515_int);
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    CAN_ServiceTxLocked();
+    xSemaphoreGive(g_ctrl_mutex);
     
-    // Initialize CAN at 500kbps (OBD2 standard)
-    if (!CAN.begin(500E3)) {
+    CAN_ReportTx();
+}
+
+/**
+ * @brief Queue a frame and wait until it is on the bus
+ * @details Reentrant: each caller registers its own waiter, keyed by the
+ *          frame's sequence number, in the same locked section that queues
+ *          the frame, so the completion cannot be missed or taken by
+ *          another caller.
+ */
+static bool CAN_SendFrameWait(const CAN_Frame_t* frame, uint8_t priority) {
+    if (g_ctrl_mutex == nullptr) {
         return false;
     }
-    
-    return true;
+    
+    CAN_SendWaiter_t waiter;
+    waiter.state = CAN_SEND_PENDING;
+    int8_t index = -1;
+    
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < CAN_SEND_WAITERS && index < 0; i++) {
+        if (g_send_waiters[i] == nullptr) {
+            index = i;
+        }
+    }
+    Status_t status = STATUS_BUSY;
+    if (index >= 0) {
+        status = CAN_EnqueueLocked(frame, priority, &waiter.sequence);
+        if (status == STATUS_OK) {
+            g_send_waiters[index] = &waiter;
+        }
+    }
+    xSemaphoreGive(g_ctrl_mutex);
+    CAN_ReportTx();
+    if (status != STATUS_OK) {
+        return false;
+    }
+    
+    uint32_t start_time = millis();
+    while (waiter.state == CAN_SEND_PENDING) {
+        CAN_ProcessTx();
+        if ((millis() - start_time) > CAN_SEND_TIMEOUT_MS) {
+            // Still queued behind other traffic: withdraw it
+            xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+            for (uint8_t i = 0; i < g_tx_queued; i++) {
+                if (g_tx_queue[i].sequence == waiter.sequence) {
+                    g_tx_queue[i] = g_tx_queue[--g_tx_queued];
+                    break;
+                }
+            }
+            if (waiter.state == CAN_SEND_PENDING) {
+                waiter.state = CAN_SEND_FAILED;
+            }
+            xSemaphoreGive(g_ctrl_mutex);
+        }
+    }
+    
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    g_send_waiters[index] = nullptr;
+    xSemaphoreGive(g_ctrl_mutex);
+    return waiter.state == CAN_SEND_SENT;
+}
+
+/**
+ * @brief Send CAN frame
+ * @details Goes through the transmit queue at normal priority and waits
+ *          until the frame is on the bus.
+ * @param frame Pointer to CAN frame to send
+ * @return true if sent successfully, false otherwise
+ */
+bool CAN_SendFrame(const CAN_Frame_t* frame) {
+    if (frame == nullptr || frame->length > 8) {
+        return false;
+    }
+    return CAN_SendFrameWait(frame, CAN_TX_PRIORITY_NORMAL);
+}
+
+/**
+ * @brief Register a transmit completion callback
+ * @param callback Called for every queued frame from CAN_ProcessTx() or
+ *                 CAN_QueueFrame(), without the controller lock, so it may
+ *                 queue the next frame
+ */
+void CAN_SetTxCallback(CAN_TxCallback_t callback) {
+    g_tx_callback = callback;
+}
+
+/**
+ * @brief Get transmit queue statistics
+ * @param stats Output
+ */
+void CAN_GetTxStats(CAN_TxStats_t* stats) {
+    if (stats != nullptr) {
+        *stats = g_tx_stats;
+    }
 }
 
 /**
- * @brief Send CAN frame
- * @param frame Pointer to CAN frame to send
- * @return true if sent successfully, false otherwise
+ * @brief Take the oldest frame from the receive queue
+ * @details Lock-free single consumer; safe with g_ctrl_mutex held.
  */
-bool CAN_SendFrame(const CAN_Frame_t* frame) {
-    if (frame == nullptr) {
+static bool CAN_PopRxFrame(CAN_Frame_t* frame) {
+    uint16_t tail = g_rx_tail;
+    if (tail == g_rx_head) {
         return false;
     }
-    
-    // Set packet ID and RTR flag
-    CAN.beginPacket(frame->id, frame->length, frame->remote);
-    
-    // Send data bytes
-    for (uint8_t i = 0; i < frame->length; i++) {
-        CAN.write(frame->data[i]);
-    }
-    
-    // End packet transmission
-    return CAN.endPacket() == 1;
+    *frame = g_rx_queue[tail];
+    __sync_synchronize();   // Copy is complete before the slot is released
+    g_rx_tail = (tail + 1) % CAN_RX_QUEUE_SIZE;
+    return true;
 }
 
 /**
  * @brief Receive CAN frame
+ * @details Takes the oldest frame from the receive queue filled by the RX
+ *          task; timestamp_us is the time it was read from the controller.
  * @param frame Pointer to buffer for received frame
  * @return true if frame received, false otherwise
  */
@@ -80,73 +1204,351 @@ bool CAN_ReceiveFrame(CAN_Frame_t* frame) {
         return false;
     }
     
-    // Check if packet available
-    int packetSize = CAN.parsePacket();
-    if (packetSize <= 0) {
-        return false;
+    // Response waits spin here; keep the transmit pipeline moving
+    CAN_ProcessTx();
+    return CAN_PopRxFrame(frame);
+}
+
+/**
+ * @brief Receive a batch of CAN frames
+ * @details Copies the oldest queued frames into a contiguous array with at
+ *          most two block copies (the queue may wrap), then releases the
+ *          slots in one index update. Waits up to timeout_ms for the first
+ *          frame; never waits for more once any are queued.
+ * @param frames Output array
+ * @param max Capacity of frames
+ * @param timeout_ms Wait for the first frame, 0 to return at once
+ * @return Number of frames copied
+ */
+uint16_t CAN_ReceiveFrames(CAN_Frame_t* frames, uint16_t max, uint32_t timeout_ms) {
+    if (frames == nullptr || max == 0) {
+        return 0;
     }
     
-    // Get packet information
-    frame->id = CAN.packetId();
-    frame->length = packetSize;
-    frame->remote = CAN.packetRtr();
-    frame->extended = CAN.packetExtended();
+    CAN_ProcessTx();
     
-    // Read data bytes
-    for (int i = 0; i < packetSize && i < 8; i++) {
-        frame->data[i] = CAN.read();
+    uint32_t start = millis();
+    uint16_t tail = g_rx_tail;
+    uint16_t pending = (g_rx_head + CAN_RX_QUEUE_SIZE - tail) % CAN_RX_QUEUE_SIZE;
+    while (pending == 0) {
+        if (millis() - start >= timeout_ms) {
+            return 0;
+        }
+        delay(1);
+        CAN_ProcessTx();
+        pending = (g_rx_head + CAN_RX_QUEUE_SIZE - tail) % CAN_RX_QUEUE_SIZE;
     }
+    __sync_synchronize();   // Frames are read after the index that published them
     
-    return true;
+    uint16_t count = pending < max ? pending : max;
+    TRACE_BEGIN(TRACE_EV_CAN_RECEIVE, 0);
+    uint16_t first = CAN_RX_QUEUE_SIZE - tail;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(frames, &g_rx_queue[tail], first * sizeof(CAN_Frame_t));
+    memcpy(frames + first, &g_rx_queue[0], (count - first) * sizeof(CAN_Frame_t));
+    __sync_synchronize();   // Copies are complete before the slots are released
+    g_rx_tail = (tail + count) % CAN_RX_QUEUE_SIZE;
+    TRACE_END(TRACE_EV_CAN_RECEIVE, count);
+    return count;
 }
 
 /**
  * @brief Check if CAN frame is available
- * @return true if frame is available to read
+ * @return true if frame is available to read (does not consume it)
  */
 bool CAN_Available(void) {
-    return CAN.parsePacket() > 0;
+    return g_rx_tail != g_rx_head;
+}
+
+/**
+ * @brief Number of frames waiting in the receive queue (does not consume them)
+ * @return Queued frame count
+ */
+uint16_t CAN_RxPending(void) {
+    return (g_rx_head + CAN_RX_QUEUE_SIZE - g_rx_tail) % CAN_RX_QUEUE_SIZE;
+}
+
+/**
+ * @brief Get receive path statistics
+ * @param stats Output
+ */
+void CAN_GetRxStats(CAN_RxStats_t* stats) {
+    if (stats != nullptr) {
+        *stats = g_rx_stats;
+    }
+}
+
+/**
+ * @brief Copy the per-ID table (any task)
+ * @details Entries are copied while the RX task updates them, so counters
+ *          of one entry may be one frame apart.
+ * @param table Receives the IDs seen, in table order
+ * @param max Capacity of table
+ * @param untracked Optional; frames of IDs that did not fit the table
+ * @return Number of entries written
+ */
+uint8_t CAN_GetIdStats(CAN_IdStats_t* table, uint8_t max, uint32_t* untracked) {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < CAN_ID_STATS_SIZE && table != nullptr && count < max; i++) {
+        if (g_id_stats[i].frames != 0) {
+            table[count++] = g_id_stats[i];
+        }
+    }
+    if (untracked != nullptr) {
+        *untracked = g_id_stats_untracked;
+    }
+    return count;
+}
+
+/* Empty the per-ID table; done by the RX task with its next frame */
+void CAN_ClearIdStats(void) {
+    g_id_stats_clear = true;
+}
+
+/**
+ * @brief Get fault confinement state, residency and bus-off recovery metrics
+ * @param stats Output; residency includes the time spent in the current state so far
+ */
+void CAN_GetErrorStats(CAN_ErrorStats_t* stats) {
+    if (stats == nullptr) {
+        return;
+    }
+    *stats = g_err_stats;
+    stats->residency_ms[stats->state] += millis() - g_err_state_since;
+}
+
+/**
+ * @brief Name of a fault confinement state
+ */
+const char* CAN_ErrorStateName(uint8_t state) {
+    switch (state) {
+        case CAN_ERROR_ACTIVE:  return "active";
+        case CAN_ERROR_PASSIVE: return "passive";
+        case CAN_ERROR_BUS_OFF: return "bus_off";
+        default:                return "unknown";
+    }
+}
+
+/**
+ * @brief Count gaps in a sequence-numbered test stream
+ * @param can_id ID carrying a big-endian uint32 counter in bytes 0-3 (IDs
+ *        above 0x7FF match 29-bit frames), CAN_SEQUENCE_CHECK_OFF to disable;
+ *        counters restart on every call
+ */
+void CAN_SetSequenceCheck(uint32_t can_id) {
+    g_seq_id = CAN_SEQUENCE_CHECK_OFF;
+    g_seq_synced = false;
+    g_rx_stats.seq_frames = 0;
+    g_rx_stats.seq_lost = 0;
+    g_seq_id = (can_id > 0x7FF && can_id != CAN_SEQUENCE_CHECK_OFF) ? (can_id | CAN_ID_EXTENDED_FLAG) : can_id;
 }
 
 /**
- * @brief Set CAN filter for OBD2 responses
- * @param filter_id CAN ID to filter for
- * @param mask_id Mask for filtering
+ * @brief Set MCP2515 acceptance filter (both RX buffers)
+ * @param filter_id CAN ID to accept
+ * @param mask_id Bits of the ID that must match; 0 accepts every frame
  * @return true if filter set successfully
  */
 bool CAN_SetFilter(uint32_t filter_id, uint32_t mask_id) {
-    // MCP2515 library handles filtering internally
-    // This is a placeholder for advanced filtering if needed
-    return true;
+    g_filter_id = filter_id;
+    g_filter_mask = mask_id;
+    if (g_ctrl_mutex == nullptr) {
+        return true;    // Applied by CAN_InitMCP2515()
+    }
+    
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    bool ok = MCP2515_SetMode(MCP_MODE_CONFIG);
+    if (ok) {
+        MCP2515_WriteFilters(filter_id, mask_id);
+        ok = MCP2515_SetMode(MCP_MODE_NORMAL);
+    }
+    xSemaphoreGive(g_ctrl_mutex);
+    return ok;
+}
+
+/**
+ * @brief Register receiver for non-OBD2 traffic (e.g. broadcast signals)
+ * @param callback Function called with every frame that is not an OBD2 response
+ */
+void CAN_SetPassiveFrameCallback(CAN_FrameCallback_t callback) {
+    g_passive_callback = callback;
 }
 
 /**
  * @brief Reset MCP2515 controller
+ * @details Last resort; bus-off is recovered by the RX task without a reset.
  * @return true if reset successful
  */
 bool CAN_Reset(void) {
-    // Stop current CAN operation
-    CAN.end();
+    // Soft reset over SPI; bit timing and filters are restored
+    return CAN_ConfigureLocked();
+}
+
+/**
+ * @brief Listen with one candidate bit timing
+ * @details Listen-only mode never acknowledges or sends error frames, so a
+ *          wrong guess cannot disturb the vehicle bus. Valid frames reach
+ *          the receive queue through the RX task; receive errors show up
+ *          as MERRF, which is polled and cleared here.
+ */
+static uint8_t CAN_ProbeTiming(const MCP2515_Timing_t* timing, uint32_t window_ms) {
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    bool ok = MCP2515_SetMode(MCP_MODE_CONFIG);
+    if (ok) {
+        uint8_t cnf[3] = { timing->cnf3, timing->cnf2, timing->cnf1 };
+        MCP2515_WriteRegisters(MCP_REG_CNF3, cnf, 3);
+        MCP2515_BitModify(MCP_REG_CANINTF, MCP_INT_MERR, 0);
+        ok = MCP2515_SetMode(MCP_MODE_LISTEN_ONLY);
+    }
+    xSemaphoreGive(g_ctrl_mutex);
+    if (!ok) {
+        return CAN_PROBE_ERRORS;
+    }
+    
+    uint32_t frames_before = g_rx_stats.frames;
+    uint32_t frames = 0;
+    uint8_t errors = 0;
+    uint32_t start_time = millis();
+    
+    while ((millis() - start_time) < window_ms) {
+        delay(5);
+        
+        xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+        if (MCP2515_ReadRegister(MCP_REG_CANINTF) & MCP_INT_MERR) {
+            MCP2515_BitModify(MCP_REG_CANINTF, MCP_INT_MERR, 0);
+            errors++;
+        }
+        xSemaphoreGive(g_ctrl_mutex);
+        
+        frames = g_rx_stats.frames - frames_before;
+        if (errors >= CAN_DETECT_MAX_ERRORS) {
+            return CAN_PROBE_ERRORS;
+        }
+        if (frames >= CAN_DETECT_MIN_FRAMES && errors == 0) {
+            return CAN_PROBE_LOCKED;    // Early exit keeps a warm start short
+        }
+    }
+    
+    if (errors > 0) {
+        return CAN_PROBE_ERRORS;
+    }
+    return (frames > 0) ? CAN_PROBE_LOCKED : CAN_PROBE_SILENT;
+}
+
+/**
+ * @brief Detect the bus bit rate from live traffic
+ * @details The bit rate cached in NVS by the last successful detection is
+ *          tried first. A silent bus ends the search at once (there is
+ *          nothing to detect; the cached or configured bit rate is kept),
+ *          otherwise the 125k-1M candidates for the configured oscillator
+ *          are probed in listen-only mode. The controller is left in
+ *          normal mode.
+ *
+ *          The oscillator is not detected: listening only measures the bit
+ *          time in oscillator cycles, and 8 MHz at a given bit rate looks
+ *          exactly like 16 MHz at twice it. With crystal_hz set wrong the
+ *          controller still receives and sends correctly, but the bit rate
+ *          reported here is off by that factor.
+ * @param window_ms Listen time per candidate
+ * @param result Optional; receives the configuration in use afterwards
+ * @return STATUS_OK if locked on, STATUS_TIMEOUT if the bus was silent,
+ *         STATUS_ERROR if no candidate received error-free traffic
+ */
+Status_t CAN_AutoDetect(uint32_t window_ms, MCP2515_Config_t* result) {
+    if (g_ctrl_mutex == nullptr) {
+        return STATUS_NOT_INITIALIZED;
+    }
+    
+    Preferences prefs;
+    const MCP2515_Timing_t* cached = nullptr;
+    if (prefs.begin(CAN_NVS_NAMESPACE, true)) {
+        cached = MCP2515_FindTiming(g_controller.crystal_hz, prefs.getUInt("bitrate", 0));
+        prefs.end();
+    }
+    
+    const MCP2515_Timing_t* found = nullptr;
+    Status_t status = STATUS_ERROR;
+    // Without a cached timing go straight to the sweep
+    uint8_t first = (cached != nullptr) ? CAN_ProbeTiming(cached, window_ms) : CAN_PROBE_ERRORS;
+    
+    if (first == CAN_PROBE_LOCKED) {
+        found = cached;
+        status = STATUS_OK;
+    } else if (first == CAN_PROBE_SILENT) {
+        found = cached;
+        status = STATUS_TIMEOUT;
+    } else {
+        bool first_candidate = true;
+        for (uint8_t i = 0; i < MCP2515_TIMING_COUNT; i++) {
+            // Entries for the other oscillator repeat the same bit times
+            if (g_timings[i].crystal_hz != g_controller.crystal_hz || &g_timings[i] == cached) {
+                continue;
+            }
+            uint8_t probe = CAN_ProbeTiming(&g_timings[i], window_ms);
+            if (probe == CAN_PROBE_LOCKED) {
+                found = &g_timings[i];
+                status = STATUS_OK;
+                break;
+            }
+            if (probe == CAN_PROBE_SILENT && first_candidate && cached == nullptr) {
+                status = STATUS_TIMEOUT;
+                break;
+            }
+            first_candidate = false;
+        }
+    }
     
-    // Stop SPI if needed
-    SPI.end();
+    if (found != nullptr) {
+        g_controller.bitrate = found->bitrate;
+    }
+    if (status == STATUS_OK && found != cached && prefs.begin(CAN_NVS_NAMESPACE, false)) {
+        prefs.putUInt("bitrate", found->bitrate);
+        prefs.end();
+    }
     
-    // Reinitialize with stored pins
-    return CAN_InitMCP2515(&g_pins);
+    // Back to normal mode with the chosen (or unchanged) timing
+    if (!CAN_ConfigureLocked()) {
+        return STATUS_ERROR;
+    }
+    if (result != nullptr) {
+        *result = g_controller;
+    }
+    return status;
 }
 
 /**
- * @brief Generic CAN initialization (compatibility wrapper)
+ * @brief Generic CAN initialization
+ * @details Pins come from CAN_InitMCP2515(); rx_pin/tx_pin do not apply to
+ *          an SPI controller. A fixed baudrate reconfigures the bit timing
+ *          for the configured oscillator; CAN_BAUDRATE_AUTO detects it.
  * @param config CAN configuration
- * @return STATUS_OK if successful
+ * @return STATUS_OK if the controller is running (also when the bus is
+ *         silent during auto-detection)
  */
 Status_t CAN_Init(const CAN_Config_t* config) {
-    // For now, ignore the config and use default MCP2515 pins
-    // In a real implementation, you might want to map these properly
-    if (CAN_InitMCP2515(&g_pins)) {
-        return STATUS_OK;
+    if (config == nullptr) {
+        return STATUS_INVALID_PARAM;
     }
-    return STATUS_ERROR;
+    
+    if (config->baudrate != CAN_BAUDRATE_AUTO) {
+        MCP2515_Config_t controller = g_controller;
+        controller.bitrate = config->baudrate;
+        if (!CAN_ConfigureController(&controller)) {
+            return STATUS_INVALID_PARAM;
+        }
+    }
+    
+    if (!CAN_InitMCP2515(&g_pins)) {
+        return STATUS_ERROR;
+    }
+    
+    if (config->baudrate == CAN_BAUDRATE_AUTO) {
+        Status_t status = CAN_AutoDetect(CAN_DETECT_WINDOW_MS, nullptr);
+        return (status == STATUS_ERROR) ? STATUS_ERROR : STATUS_OK;
+    }
+    return STATUS_OK;
 }
 
 /**
@@ -155,26 +1557,146 @@ Status_t CAN_Init(const CAN_Config_t* config) {
  * @return STATUS_OK if successful
  */
 Status_t CAN_SendOBD2Request(uint8_t pid) {
-    CAN_Frame_t frame;
-    frame.id = 0x7DF;  // OBD2 functional addressing
-    frame.length = 8;
-    frame.extended = false;
-    frame.remote = false;
+    return CAN_SendOBD2ModeRequest(OBD2_MODE_CURRENT_DATA, &pid, 1);
+}
+
+/**
+ * @brief Send OBD2 request for an arbitrary service (mode)
+ * @param mode OBD2 service ID (e.g. 0x01 current data, 0x02 freeze frame)
+ * @param params Request parameters following the mode byte (PID, frame number...)
+ * @param param_count Number of parameter bytes (0-6)
+ * @return STATUS_OK if successful
+ */
+Status_t CAN_SendOBD2ModeRequest(uint8_t mode, const uint8_t* params, uint8_t param_count) {
+    uint8_t target = (mode < CAN_OBD2_MODE_SLOTS) ? g_obd2_target[mode] : 0;
+    
+    // Functional broadcast until discovery has assigned an ECU to the service
+    uint32_t request_id = (target == 0) ? CAN_GetOBD2FunctionalId() : CAN_GetOBD2RequestId(target - 1);
+    return CAN_SendOBD2To(request_id, mode, params, param_count);
+}
+
+/**
+ * @brief Select 11-bit (0x7DF/0x7E0/0x7E8) or 29-bit (0x18DB33F1/0x18DAxxF1/0x18DAF1xx) OBD2 addressing
+ * @details Clears all physical targets and the learned 29-bit ECU addresses.
+ * @param extended true for 29-bit identifiers
+ */
+void CAN_SetOBD2Addressing(bool extended) {
+    g_obd2_extended = extended;
+    g_ecu_count = 0;
+    memset(g_obd2_target, 0, sizeof(g_obd2_target));
+}
+
+/**
+ * @brief Check whether OBD2 traffic uses 29-bit identifiers
+ */
+bool CAN_IsOBD2Extended(void) {
+    return g_obd2_extended;
+}
+
+/**
+ * @brief Functional (broadcast) request ID for the current addressing
+ */
+uint32_t CAN_GetOBD2FunctionalId(void) {
+    return g_obd2_extended ? CAN_OBD2_EXT_FUNCTIONAL_ID : CAN_OBD2_FUNCTIONAL_ID;
+}
+
+/**
+ * @brief Physical request ID of ECU n
+ * @return 0x7E0 + n, or 0x18DA<address>F1 for a learned 29-bit ECU (0 if unknown)
+ */
+uint32_t CAN_GetOBD2RequestId(uint8_t ecu) {
+    if (!g_obd2_extended) {
+        return CAN_OBD2_REQUEST_BASE + ecu;
+    }
+    return (ecu < g_ecu_count) ? CAN_OBD2_EXT_REQUEST_BASE | ((uint32_t)g_ecu_address[ecu] << 8) : 0;
+}
+
+/**
+ * @brief Response ID of ECU n
+ * @return 0x7E8 + n, or 0x18DAF1<address> for a learned 29-bit ECU (0 if unknown)
+ */
+uint32_t CAN_GetOBD2ResponseId(uint8_t ecu) {
+    if (!g_obd2_extended) {
+        return CAN_OBD2_RESPONSE_BASE + ecu;
+    }
+    return (ecu < g_ecu_count) ? CAN_OBD2_EXT_RESPONSE_BASE | g_ecu_address[ecu] : 0;
+}
+
+/**
+ * @brief Address an OBD2 service to one ECU or back to functional broadcast
+ * @param mode OBD2 service ID
+ * @param ecu ECU index 0-7 (see CAN_GetOBD2RequestId) or CAN_OBD2_FUNCTIONAL
+ * @return STATUS_OK if successful
+ */
+Status_t CAN_SetOBD2Target(uint8_t mode, uint8_t ecu) {
+    if (mode >= CAN_OBD2_MODE_SLOTS || (ecu >= CAN_OBD2_MAX_ECUS && ecu != CAN_OBD2_FUNCTIONAL) ||
+        (g_obd2_extended && ecu != CAN_OBD2_FUNCTIONAL && ecu >= g_ecu_count)) {
+        return STATUS_INVALID_PARAM;
+    }
     
-    // OBD2 request format: [Length, Mode, PID, padding...]
-    frame.data[0] = 0x02;    // Length
-    frame.data[1] = 0x01;    // Mode 01 (current data)
-    frame.data[2] = pid;     // Parameter ID
-    frame.data[3] = 0x00;    // Padding
-    frame.data[4] = 0x00;
-    frame.data[5] = 0x00;
-    frame.data[6] = 0x00;
-    frame.data[7] = 0x00;
+    g_obd2_target[mode] = (ecu == CAN_OBD2_FUNCTIONAL) ? 0 : ecu + 1;
+    return STATUS_OK;
+}
+
+/**
+ * @brief Get the ECU addressed for an OBD2 service
+ * @param mode OBD2 service ID
+ * @return ECU index 0-7, or CAN_OBD2_FUNCTIONAL
+ */
+uint8_t CAN_GetOBD2Target(uint8_t mode) {
+    uint8_t target = (mode < CAN_OBD2_MODE_SLOTS) ? g_obd2_target[mode] : 0;
+    return (target == 0) ? CAN_OBD2_FUNCTIONAL : target - 1;
+}
+
+/**
+ * @brief Find which ECUs answer an OBD2 service
+ * @details Sends the request functionally (0x7DF or 0x18DB33F1) and collects
+ *          every positive response until the timeout expires.
+ * @param mode OBD2 service ID
+ * @param params Request parameters following the mode byte
+ * @param param_count Number of parameter bytes (0-6)
+ * @param responder_mask Bit n set if ECU n (0x7E8+n, or the n-th 29-bit address) responded
+ * @param timeout_ms Collection window in milliseconds
+ * @return STATUS_OK if at least one ECU responded
+ */
+Status_t CAN_DiscoverOBD2Responders(uint8_t mode, const uint8_t* params, uint8_t param_count,
+                                    uint8_t* responder_mask, uint32_t timeout_ms) {
+    if (responder_mask == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
     
-    if (CAN_SendFrame(&frame)) {
-        return STATUS_OK;
+    *responder_mask = 0;
+    Status_t status = CAN_SendOBD2To(CAN_GetOBD2FunctionalId(), mode, params, param_count);
+    if (status != STATUS_OK) {
+        return status;
     }
-    return STATUS_ERROR;
+    
+    uint32_t start_time = millis();
+    CAN_Frame_t frame;
+    
+    while ((millis() - start_time) < timeout_ms) {
+        if (!CAN_ReceiveFrame(&frame)) {
+            delay(1);
+            continue;
+        }
+        
+        int8_t slot = CAN_OBD2Slot(&frame);
+        if (slot < 0) {
+            if (g_passive_callback != nullptr) {
+                g_passive_callback(&frame);
+            }
+            continue;
+        }
+        
+        // Single frame [len, mode+0x40, ...] or first frame [0x1L, LL, mode+0x40, ...]
+        uint8_t pci_type = frame.data[0] >> 4;
+        uint8_t sid = (pci_type == 0x1) ? frame.data[2] : frame.data[1];
+        if (frame.length >= 3 && pci_type <= 0x1 && sid == (uint8_t)(mode + 0x40)) {
+            *responder_mask |= 1 << slot;
+        }
+    }
+    
+    return (*responder_mask != 0) ? STATUS_OK : STATUS_TIMEOUT;
 }
 
 /**
@@ -186,6 +1708,12 @@ Status_t CAN_SendOBD2Request(uint8_t pid) {
  * @return STATUS_OK if successful
  */
 Status_t CAN_ReceiveOBD2Response(uint8_t pid, uint8_t* data, uint8_t* length, uint32_t timeout_ms) {
+    return CAN_ReceiveOBD2ModeResponse(OBD2_MODE_CURRENT_DATA, pid, data, length, timeout_ms);
+}
+
+/* Wait for a single-frame response to mode/pid; busy_poll skips the 1 ms sleep */
+static Status_t CAN_WaitOBD2Response(uint8_t mode, uint8_t pid, uint8_t* data, uint8_t* length,
+                                     uint32_t* rx_time_us, uint32_t timeout_ms, bool busy_poll) {
     if (data == nullptr || length == nullptr) {
         return STATUS_INVALID_PARAM;
     }
@@ -195,21 +1723,270 @@ Status_t CAN_ReceiveOBD2Response(uint8_t pid, uint8_t* data, uint8_t* length, ui
     
     while ((millis() - start_time) < timeout_ms) {
         if (CAN_ReceiveFrame(&frame)) {
-            // Check if this is an OBD2 response (ID range 0x7E8-0x7EF)
-            if (frame.id >= 0x7E8 && frame.id <= 0x7EF) {
-                // Check if response matches requested PID
-                if (frame.length >= 3 && frame.data[1] == 0x41 && frame.data[2] == pid) {
+            // Check if this is an OBD2 response (0x7E8-0x7EF or 0x18DAF1xx)
+            int8_t slot = CAN_OBD2Slot(&frame);
+            if (slot >= 0) {
+                // Check if response comes from the addressed ECU and matches requested mode and PID
+                if (CAN_IsFromTarget(slot, mode) && frame.length >= 3 && frame.data[1] == (uint8_t)(mode + 0x40) && frame.data[2] == pid) {
                     // Extract data (skip length, mode, and PID bytes)
                     *length = frame.length - 3;
                     for (uint8_t i = 0; i < *length && i < 5; i++) {  // Max 5 bytes of data
                         data[i] = frame.data[3 + i];
                     }
+                    if (rx_time_us != nullptr) {
+                        *rx_time_us = frame.timestamp_us;
+                    }
                     return STATUS_OK;
                 }
+            } else if (g_passive_callback != nullptr) {
+                g_passive_callback(&frame);
+            }
+        } else if (!busy_poll) {
+            delay(1);  // Small delay to prevent busy waiting
+        }
+    }
+    
+    return STATUS_TIMEOUT;
+}
+
+/**
+ * @brief Receive single-frame OBD2 response for an arbitrary service (mode)
+ * @param mode Service ID of the request (response carries mode + 0x40)
+ * @param pid Expected parameter ID
+ * @param data Buffer for response data (at least 5 bytes, starts after the PID byte)
+ * @param length Pointer to length variable
+ * @param timeout_ms Timeout in milliseconds
+ * @return STATUS_OK if successful
+ */
+Status_t CAN_ReceiveOBD2ModeResponse(uint8_t mode, uint8_t pid, uint8_t* data, uint8_t* length, uint32_t timeout_ms) {
+    return CAN_WaitOBD2Response(mode, pid, data, length, nullptr, timeout_ms, false);
+}
+
+/**
+ * @brief Receive single-frame OBD2 response with the time its frame was read
+ * @details Waits like CAN_ReceiveOBD2ModeResponse(); the timestamp comes from
+ *          the RX task, so it does not depend on how often this loop polls.
+ * @param mode Service ID of the request (response carries mode + 0x40)
+ * @param pid Expected parameter ID
+ * @param data Buffer for response data (at least 5 bytes, starts after the PID byte)
+ * @param length Pointer to length variable
+ * @param rx_time_us micros() when the response was read from the controller
+ * @param timeout_ms Timeout in milliseconds
+ * @return STATUS_OK if successful
+ */
+Status_t CAN_ReceiveOBD2Stamped(uint8_t mode, uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us, uint32_t timeout_ms) {
+    if (rx_time_us == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+    return CAN_WaitOBD2Response(mode, pid, data, length, rx_time_us, timeout_ms, false);
+}
+
+/**
+ * @brief Receive single-frame OBD2 response with its receive timestamp
+ * @details Polls the controller without sleeping, so the timestamp is taken
+ *          within one poll of the frame arriving. Intended for short
+ *          measurement bursts that own the bus.
+ * @param mode Service ID of the request (response carries mode + 0x40)
+ * @param pid Expected parameter ID
+ * @param data Buffer for response data (at least 5 bytes, starts after the PID byte)
+ * @param length Pointer to length variable
+ * @param rx_time_us Receive time of the response frame in micros()
+ * @param timeout_ms Timeout in milliseconds
+ * @return STATUS_OK if successful
+ */
+Status_t CAN_ReceiveOBD2Timed(uint8_t mode, uint8_t pid, uint8_t* data, uint8_t* length, uint32_t* rx_time_us, uint32_t timeout_ms) {
+    if (rx_time_us == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+    return CAN_WaitOBD2Response(mode, pid, data, length, rx_time_us, timeout_ms, true);
+}
+
+/**
+ * @brief Receive OBD2 response that may span several frames (ISO 15765-2)
+ * @details Accepts a single frame or a first frame followed by consecutive
+ *          frames. Flow control (continue, no block limit, no STmin) is sent
+ *          to the physical request ID of the responding ECU.
+ * @param mode Service ID of the request (response carries mode + 0x40)
+ * @param pid Expected parameter ID
+ * @param data Buffer for response payload (starts after the PID byte)
+ * @param max_length Size of data buffer
+ * @param length Pointer to received payload length
+ * @param timeout_ms Timeout in milliseconds for the whole transfer
+ * @return STATUS_OK if successful
+ */
+Status_t CAN_ReceiveOBD2MultiFrame(uint8_t mode, uint8_t pid, uint8_t* data, uint16_t max_length, uint16_t* length, uint32_t timeout_ms) {
+    if (data == nullptr || length == nullptr) {
+        return STATUS_INVALID_PARAM;
+    }
+    
+    uint32_t start_time = millis();
+    int8_t responder = -1;      // ECU index of the first frame
+    uint16_t total = 0;         // Message length incl. mode and PID bytes
+    uint16_t received = 0;      // Message bytes received so far
+    uint8_t next_sequence = 1;
+    CAN_Frame_t frame;
+    
+    while ((millis() - start_time) < timeout_ms) {
+        if (!CAN_ReceiveFrame(&frame)) {
+            delay(1);
+            continue;
+        }
+        
+        int8_t slot = CAN_OBD2Slot(&frame);
+        if (slot < 0) {
+            if (g_passive_callback != nullptr) {
+                g_passive_callback(&frame);
+            }
+            continue;
+        }
+        if (frame.length < 2 || !CAN_IsFromTarget(slot, mode)) {
+            continue;
+        }
+        
+        uint8_t pci_type = frame.data[0] >> 4;
+        
+        if (responder < 0) {
+            if (pci_type == 0x0) {
+                // Single frame: [len, mode+0x40, pid, payload...]
+                uint8_t sf_len = frame.data[0] & 0x0F;
+                if (sf_len < 2 || sf_len > 7 || frame.data[1] != (uint8_t)(mode + 0x40) || frame.data[2] != pid) {
+                    continue;
+                }
+                *length = 0;
+                for (uint8_t i = 3; i <= sf_len && *length < max_length; i++) {
+                    data[(*length)++] = frame.data[i];
+                }
+                return STATUS_OK;
+            }
+            
+            if (pci_type == 0x1) {
+                // First frame: [0x1L, LL, mode+0x40, pid, payload(4)]
+                total = ((uint16_t)(frame.data[0] & 0x0F) << 8) | frame.data[1];
+                if (total < 8 || frame.data[2] != (uint8_t)(mode + 0x40) || frame.data[3] != pid) {
+                    continue;
+                }
+                
+                responder = slot;
+                *length = 0;
+                for (uint8_t i = 4; i < 8 && *length < max_length; i++) {
+                    data[(*length)++] = frame.data[i];
+                }
+                received = 6;
+                
+                CAN_Frame_t flow;
+                flow.id = CAN_GetOBD2RequestId(responder);
+                flow.length = 8;
+                flow.extended = g_obd2_extended;
+                flow.remote = false;
+                memset(flow.data, 0, sizeof(flow.data));
+                flow.data[0] = 0x30;    // Continue to send, block size 0, STmin 0
+                if (!CAN_SendFrameWait(&flow, CAN_TX_PRIORITY_URGENT)) {
+                    return STATUS_ERROR;
+                }
+            }
+            continue;
+        }
+        
+        // Consecutive frames from the same ECU
+        if (slot != responder || pci_type != 0x2) {
+            continue;
+        }
+        if ((frame.data[0] & 0x0F) != next_sequence) {
+            return STATUS_ERROR;
+        }
+        next_sequence = (next_sequence + 1) & 0x0F;
+        
+        for (uint8_t i = 1; i < 8 && received < total; i++, received++) {
+            if (*length < max_length) {
+                data[(*length)++] = frame.data[i];
             }
         }
-        delay(1);  // Small delay to prevent busy waiting
+        if (received >= total) {
+            return STATUS_OK;
+        }
     }
     
     return STATUS_TIMEOUT;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Measure the receive path in internal loopback mode
+ * @details Each frame is transmitted and looped back inside the MCP2515;
+ *          the drain that reads it (flag/EFLG burst plus READ RX BUFFER)
+ *          is timed on its own with the RX task held off. The bus is not
+ *          touched. Run before OBD2 traffic starts; normal mode is restored.
+ *          Frames go straight into TX buffer 0, bypassing the queue, its
+ *          stats and the TX callback.
+ * @param frame_count Number of 8-byte frames to receive
+ * @param result Per-frame cost and the frame rate it sustains
+ * @return STATUS_OK if every frame was received, STATUS_BUSY while frames
+ *         are queued for transmission
+ */
+Status_t CAN_RunBenchmark(uint16_t frame_count, CAN_Benchmark_t* result) {
+    if (result == nullptr || frame_count == 0) {
+        return STATUS_INVALID_PARAM;
+    }
+    if (g_ctrl_mutex == nullptr) {
+        return STATUS_NOT_INITIALIZED;
+    }
+    memset(result, 0, sizeof(*result));
+    result->spi_clock_hz = g_controller.spi_clock_hz;
+    // 8-byte standard data frame: 108 bits plus 3 bits interframe space, no stuffing
+    result->bus_frame_rate = g_controller.bitrate / 111;
+    
+    xSemaphoreTake(g_ctrl_mutex, portMAX_DELAY);
+    if (!CAN_TxIdle()) {
+        xSemaphoreGive(g_ctrl_mutex);
+        return STATUS_BUSY;
+    }
+    if (!MCP2515_SetMode(MCP_MODE_LOOPBACK)) {
+        xSemaphoreGive(g_ctrl_mutex);
+        return STATUS_ERROR;
+    }
+    
+    CAN_Frame_t tx = {};
+    tx.id = 0x123;
+    tx.length = 8;
+    CAN_Frame_t rx;
+    uint64_t total_us = 0;
+    
+    for (uint16_t i = 0; i < frame_count; i++) {
+        memcpy(tx.data, &i, sizeof(i));
+        CAN_WriteTxBuffer(0, &tx, CAN_TX_PRIORITY_NORMAL);
+        
+        // Loopback completes within one frame time
+        uint32_t wait_start = micros();
+        uint32_t elapsed = 0;
+        uint8_t received = 0;
+        while (received == 0 && (micros() - wait_start) < 1000) {
+            if (digitalRead(g_pins.mcp2515_int) == LOW) {
+                uint32_t start = micros();
+                received = CAN_DrainRx(start);
+                elapsed = micros() - start;
+            }
+        }
+        // CAN_ReceiveFrame() would service TX and take the lock again
+        if (received == 0 || !CAN_PopRxFrame(&rx) || rx.id != tx.id) {
+            break;
+        }
+        
+        total_us += elapsed;
+        if (elapsed > result->max_us) {
+            result->max_us = elapsed;
+        }
+        result->frames++;
+    }
+    
+    // A frame that never looped back must not go out in normal mode; the
+    // drain flagged buffer 0 as completed, but no queued frame was in it
+    MCP2515_BitModify(MCP_REG_TXBCTRL(0), MCP_TXB_TXREQ, 0);
+    __atomic_fetch_and(&g_tx_done_mask, (uint8_t)~1, __ATOMIC_SEQ_CST);
+    MCP2515_SetMode(MCP_MODE_NORMAL);
+    xSemaphoreGive(g_ctrl_mutex);
+    
+    if (result->frames > 0) {
+        result->mean_ns = (uint32_t)(total_us * 1000 / result->frames);
+        result->max_frame_rate = (result->mean_ns > 0) ? 1000000000UL / result->mean_ns : 0;
+    }
+    return (result->frames == frame_count) ? STATUS_OK : STATUS_ERROR;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file trace.cpp
+ * @brief Hot-path event tracing - BSW layer
+ * @version 1.0
+ * @date 2025-11-12
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "trace.h"
+
+#define TRACE_RING_MASK             (TRACE_RING_SIZE - 1)
+#define TRACE_SYNC_CYCLES           ((uint32_t)(F_CPU / 1000) * TRACE_SYNC_INTERVAL_MS)
+
+static TraceRecord_t g_rings[TRACE_CORES][TRACE_RING_SIZE];
+static volatile uint32_t g_heads[TRACE_CORES];         /* Records ever claimed per core, written by that core */
+static volatile uint32_t g_last_sync[TRACE_CORES];
+static volatile bool g_enabled = true;
+static volatile uint32_t g_paused = 0;                  /* Dumps and clears in progress */
+
+static const char* const g_event_names[TRACE_EV_COUNT] = {
+    "sync",
+    "can_irq",
+    "can_drain",
+    "can_receive",
+    "obd_poll",
+    "obd_broadcast",
+    "obd_decode",
+    "data_callback",
+    "ble_send",
+    "http_request"
+};
+
+/* Fill a claimed slot; an ISR preempting us has claimed a later one */
+static inline void IRAM_ATTR Trace_Write(TraceRecord_t* record, uint32_t cycles, uint16_t event, uint8_t phase, uint32_t arg) {
+    record->cycles = cycles;
+    record->arg = arg;
+    record->event = event;
+    record->phase = phase;
+}
+
+/**
+ * @brief Append one record to the calling core's ring (task or ISR context)
+ * @param event TraceEventId_t
+ * @param phase TracePhase_t
+ * @param arg Event argument
+ */
+void IRAM_ATTR Trace_Record(uint16_t event, uint8_t phase, uint32_t arg) {
+    if (!g_enabled || g_paused != 0) {
+        return;
+    }
+
+    // Claim the slot and read the counter as one step, so a ring stays in time order
+    uint32_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint32_t core = xPortGetCoreID();
+    uint32_t cycles = ESP.getCycleCount();
+    // Anchor the cycle counter to wall time before it can wrap unseen
+    bool sync = (cycles - g_last_sync[core]) >= TRACE_SYNC_CYCLES;
+    if (sync) {
+        g_last_sync[core] = cycles;
+    }
+    uint32_t index = g_heads[core];
+    g_heads[core] = index + (sync ? 2 : 1);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+
+    if (sync) {
+        Trace_Write(&g_rings[core][index++ & TRACE_RING_MASK], cycles, TRACE_EV_SYNC, TRACE_PHASE_INSTANT,
+                    (uint32_t)esp_timer_get_time());
+    }
+    Trace_Write(&g_rings[core][index & TRACE_RING_MASK], cycles, event, phase, arg);
+}
+
+void Trace_SetEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+bool Trace_IsEnabled(void) {
+    return g_enabled;
+}
+
+void Trace_Clear(void) {
+    __atomic_fetch_add(&g_paused, 1, __ATOMIC_SEQ_CST);
+    for (uint8_t core = 0; core < TRACE_CORES; core++) {
+        g_heads[core] = 0;
+        g_last_sync[core] = ESP.getCycleCount() - TRACE_SYNC_CYCLES;    // First record syncs
+    }
+    __atomic_fetch_sub(&g_paused, 1, __ATOMIC_SEQ_CST);
+}
+
+const char* Trace_EventName(uint16_t event) {
+    return (event < TRACE_EV_COUNT) ? g_event_names[event] : "unknown";
+}
+
+/**
+ * @brief Write both rings as text, oldest record first
+ * @details Recording pauses for the dump so slots are not overwritten
+ *          while they are read. Dumps may overlap (console and HTTP);
+ *          recording resumes when the last one ends. Format, one item
+ *          per line:
+ *            # trace cpu_hz=<hz> ring=<records per core>
+ *            # event <id> <name>
+ *            <core> <cycles> <event> <phase> <arg>
+ * @param writer Output function
+ * @param context Passed to writer
+ */
+void Trace_Dump(TraceWriter_t writer, void* context) {
+    if (writer == nullptr) {
+        return;
+    }
+
+    char line[64];
+    int length;
+
+    __atomic_fetch_add(&g_paused, 1, __ATOMIC_SEQ_CST);
+
+    length = snprintf(line, sizeof(line), "# trace cpu_hz=%lu ring=%u\n",
+                      (unsigned long)ESP.getCpuFreqMHz() * 1000000UL, (unsigned)TRACE_RING_SIZE);
+    writer(line, length, context);
+    for (uint16_t event = 0; event < TRACE_EV_COUNT; event++) {
+        length = snprintf(line, sizeof(line), "# event %u %s\n", event, g_event_names[event]);
+        writer(line, length, context);
+    }
+
+    for (uint8_t core = 0; core < TRACE_CORES; core++) {
+        uint32_t head = g_heads[core];
+        uint32_t start = (head > TRACE_RING_SIZE) ? head - TRACE_RING_SIZE : 0;
+
+        for (uint32_t i = start; i < head; i++) {
+            const TraceRecord_t* record = &g_rings[core][i & TRACE_RING_MASK];
+            length = snprintf(line, sizeof(line), "%u %lu %u %u %lu\n", core, (unsigned long)record->cycles,
+                              record->event, record->phase, (unsigned long)record->arg);
+            writer(line, length, context);
+        }
+    }
+
+    __atomic_fetch_sub(&g_paused, 1, __ATOMIC_SEQ_CST);
+}
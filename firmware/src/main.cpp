@@ -15,20 +15,66 @@
  */
 
 #include <Arduino.h>
-#include <WiFi.h>
-#include <WebServer.h>
 #include "common_types.h"
 #include "hal_interface.h"
 #include "can_interface.h"
 #include "obd2_handler.h"
-#include "ble_service.h"
+#include "event_capture.h"
+#include "vehicle_profile.h"
+#include "signal_store.h"
+#include "derived_metrics.h"
+#include "signal_stats.h"
+#include "anomaly_detector.h"
+#include "perf_timer.h"
+#include "signal_filter.h"
+#include "trace.h"
+#include "latency_monitor.h"
+#include "health_monitor.h"
+#include "logger.h"
+#include "heap_audit.h"
+#include "output_sinks.h"
+#include "settings.h"
+#include "console.h"
 
-// System Configuration
-const char* ssid = "YOUR_WIFI_SSID";
-const char* password = "YOUR_WIFI_PASSWORD";
+// CAN controller configuration (MCP2515 module with 16 MHz crystal)
+static const MCP2515_Config_t can_controller_config = {
+    .spi_clock_hz = 10000000,       /* MCP2515 maximum */
+    .crystal_hz = 16000000,        /* Must match the board: auto-detection cannot tell */
+    .bitrate = 500000               /* OBD2 on CAN */
+};
+#define RUN_CAN_BENCHMARK false  // Set to true to measure the CAN receive path at boot
+
+// Event capture configuration
+static const CaptureConfig_t capture_config = {
+    .pre_trigger_ms = 10000,        /* 10 s of history before the trigger */
+    .post_trigger_ms = 5000,        /* 5 s after the trigger */
+    .coolant_limit_c = 105,         /* Coolant overheat limit */
+    .rpm_spike_delta = 3000         /* RPM jump between two 200 ms samples */
+};
+
+// Derived metrics configuration
+static const DerivedConfig_t derived_config = {
+    .rpm_band_edges = { 3000, 6000, 9000 },
+    .fuel_coefficient = 2793,       /* Theoretical; calibrate against fill-ups */
+    .idle_load_pct = 20
+};
+
+// Anomaly rules; z-score and trend rules need the signal tracked by Stats
+static const AnomalyRule_t anomaly_rules[] = {
+    /* name, signal, type, threshold, clear, hold_ms, gate_min */
+    { "coolant_overheat", "coolant_temp", ANOMALY_ABOVE,       110.0f, 105.0f, 2000,  0.0f },
+    { "coolant_rising",   "coolant_temp", ANOMALY_TREND_ABOVE,   3.0f,   1.0f, 10000, 90.0f },
+    { "rpm_unstable",     "rpm",          ANOMALY_ZSCORE,        4.0f,   2.0f, 1000,  500.0f }
+};
 
-// BLE Configuration
-#define ENABLE_BLE true  // Set to false to disable BLE
+// Display smoothing; acquisition runs at 200 ms, displays render at ~60 Hz
+static const FilterConfig_t display_filters[] = {
+    /* key, median, smoother, ema alpha, kalman q, kalman r, extrapolate */
+    { "rpm",               3, FILTER_SMOOTH_KALMAN, 0,   10000, 10000, true },
+    { "speed",             0, FILTER_SMOOTH_EMA,    160, 0,     0,     true },
+    { "throttle_position", 3, FILTER_SMOOTH_EMA,    160, 0,     0,     true },
+    { "coolant_temp",      0, FILTER_SMOOTH_EMA,    32,  0,     0,     false }
+};
 
 // Hardware Pins Configuration for MCP2515
 static const HardwarePins_t hardware_pins = {
@@ -40,23 +86,27 @@ static const HardwarePins_t hardware_pins = {
     .status_led = 25                /* Status LED pin */
 };
 
+// Health monitor budgets; a run still open after HEALTH_STALL_MS is reported
+#define LOOP_BUDGET_US      200000  // One loop() pass including OBD polling
+#define OBD_POLL_BUDGET_US  150000  // One OBD2_ReadAllData() or Perf_Process() slice
+
 // Global Variables
-WebServer server(80);
 SystemState_t current_state = SYSTEM_STATE_INIT;
 VehicleData_t last_vehicle_data = {0};
+static int8_t loop_health = -1;
+static int8_t obd_health = -1;
 
 // Function Prototypes
 void system_init(void);
+void select_vehicle_profile(void);
 void vehicle_data_callback(const VehicleData_t* data);
 void system_task(void);
-void handleRoot(void);
-void handleData(void);
+void print_perf_result(const PerfResult_t* result);
 
 // Function declarations
 void system_init(void);
 void system_task(void);
 void vehicle_data_callback(VehicleData_t* data);
-void output_vehicle_data_json(void);
 
 void setup() {
     Serial.begin(115200);
@@ -68,41 +118,41 @@ void setup() {
     
     system_init();
     
+    // Saved rates, poll periods and filters override the compiled ones
+    if (Settings_Init() == STATUS_OK) {
+        Serial.println("Saved settings applied");
+    }
+    
+    // Output sinks selected for this build (sink_config.h)
+    ActiveSinks::begin();
+    
+    // The loop task feeds the watchdog from here on; a stalled OBD read resets it
+    loop_health = Health_Register("loop", LOOP_BUDGET_US, HEALTH_FLAG_TASK | HEALTH_FLAG_WATCHDOG);
+    obd_health = Health_Register("obd_poll", OBD_POLL_BUDGET_US, 0);
+    HEAP_AUDIT_WATCH();
+    
+    // Commands from the serial monitor, handled off the loop task
+    if (Console_Init() != STATUS_OK) {
+        Serial.println("Warning: Console task not started");
+    }
+    
     Serial.println("System initialization complete!");
     Serial.println("========================================");
+    
+    // Steady state from here on: every buffer is static or on the stack
+    HEAP_AUDIT_ARM();
 }
 
 void loop() {
-    static unsigned long last_json_output = 0;
-    static unsigned long last_ble_send = 0;
-    const unsigned long JSON_OUTPUT_INTERVAL = 1000; // Output every 1 second
-    const unsigned long BLE_SEND_INTERVAL = 200;     // BLE update every 200ms
-    
-    unsigned long current_time = millis();
-    
-    // Handle web server
-    server.handleClient();
+    Health_Begin(loop_health);
     
     // Run system tasks
     system_task();
     
-    // Update BLE connection status
-    BLE_UpdateStatus();
-    
-    // Send data via BLE if connected
-    if (ENABLE_BLE && BLE_IsConnected()) {
-        if (current_time - last_ble_send >= BLE_SEND_INTERVAL) {
-            BLE_SendVehicleData(&last_vehicle_data);
-            last_ble_send = current_time;
-        }
-    }
-    
-    // Output JSON data to Serial for debugging
-    if (current_time - last_json_output >= JSON_OUTPUT_INTERVAL) {
-        output_vehicle_data_json();
-        last_json_output = current_time;
-    }
+    // Web, display, BLE and serial output; each sink keeps its own rate
+    ActiveSinks::service(millis());
     
+    Health_End(loop_health);
     delay(10);
 }
 
@@ -110,30 +160,26 @@ void loop() {
 #define STATUS_LED hardware_pins.status_led
 
 void system_init(void) {
+    // Logger and health monitor first, so everything created below can use them
+    if (Log_Init() != STATUS_OK) {
+        Serial.println("Warning: Log task not started, LOG_* output is lost");
+    }
+    
+    if (Health_Init() != STATUS_OK) {
+        Serial.println("Warning: Health monitor task not started");
+    }
+    HealthSystem_t health;
+    Health_GetSystem(&health);
+    if (health.watchdog_reset) {
+        Serial.println("Warning: Previous run ended in a watchdog reset");
+    }
+    
     // Initialize GPIO for status LED
     HAL_GPIO_Init(hardware_pins.status_led, HAL_GPIO_MODE_OUTPUT);
     HAL_GPIO_Write(hardware_pins.status_led, GPIO_LEVEL_LOW);
     
-    // Initialize BLE Service
-    if (ENABLE_BLE) {
-        Serial.println("Initializing BLE service...");
-        BLEConfig_t ble_config = {
-            .device_name = BLE_DEVICE_NAME,
-            .auto_advertise = true,
-            .mtu_size = 517  // Maximum MTU for better throughput
-        };
-        
-        Status_t ble_status = BLE_Init(&ble_config);
-        if (ble_status == STATUS_OK) {
-            Serial.println("✓ BLE service initialized successfully");
-            Serial.println("  Device is now discoverable as: " BLE_DEVICE_NAME);
-            Serial.println("  Desktop app can connect via Bluetooth");
-        } else {
-            Serial.println("✗ BLE initialization failed");
-        }
-    }
-    
     // Initialize MCP2515 CAN controller
+    CAN_ConfigureController(&can_controller_config);
     if (!CAN_InitMCP2515(&hardware_pins)) {
         Serial.println("Error: MCP2515 CAN initialization failed");
         current_state = SYSTEM_STATE_ERROR;
@@ -141,99 +187,198 @@ void system_init(void) {
     }
     Serial.println("MCP2515 CAN controller initialized");
     
+    if (RUN_CAN_BENCHMARK) {
+        CAN_Benchmark_t bench;
+        Status_t bench_status = CAN_RunBenchmark(1000, &bench);
+        Serial.printf("CAN benchmark (%s): %u frames, SPI %lu Hz\n",
+                      bench_status == STATUS_OK ? "ok" : "incomplete",
+                      bench.frames, (unsigned long)bench.spi_clock_hz);
+        Serial.printf("  %.2f us/frame (max %lu us) -> %lu frames/s, bus max %lu frames/s\n",
+                      bench.mean_ns / 1000.0f, (unsigned long)bench.max_us,
+                      (unsigned long)bench.max_frame_rate, (unsigned long)bench.bus_frame_rate);
+    }
+    
+    // Signal registry shared by acquisition and all output sinks
+    SignalStore_Init();
+    Latency_Init();
+    
     // Initialize OBD2 handler
     OBD2_Config_t obd2_config;
     obd2_config.update_interval_ms = 100;
+    obd2_config.can_rx_pin = 0;     // Unused with the SPI controller
+    obd2_config.can_tx_pin = 0;
+    obd2_config.can_baudrate = CAN_BAUDRATE_AUTO;
     
     Status_t status = OBD2_Init(&obd2_config);
     if (status == STATUS_OK) {
+        const MCP2515_Config_t* can_config = CAN_GetControllerConfig();
+        Serial.printf("CAN bus at %lu kbps (MCP2515 configured for %lu MHz)\n",
+                      (unsigned long)(can_config->bitrate / 1000), (unsigned long)(can_config->crystal_hz / 1000000));
         Serial.println("OBD2 handler initialized");
         OBD2_RegisterCallback(vehicle_data_callback);
         current_state = SYSTEM_STATE_IDLE;
+        
+        select_vehicle_profile();
+        
+        // Address the responding ECU directly from now on
+        uint8_t ecu;
+        if (OBD2_SetupAddressing(&ecu) == STATUS_OK) {
+            Serial.printf(CAN_IsOBD2Extended() ? "OBD2 ECU: request 0x%08lX, response 0x%08lX (29-bit)\n"
+                                               : "OBD2 ECU: request 0x%03lX, response 0x%03lX\n",
+                          (unsigned long)CAN_GetOBD2RequestId(ecu), (unsigned long)CAN_GetOBD2ResponseId(ecu));
+        } else {
+            Serial.println("OBD2 ECU discovery failed, using functional addressing");
+        }
+        Derived_Init(&derived_config, OBD2_GetActiveProfile());
+        
+        Stats_Init();
+        Stats_Track("coolant_temp", 0.05f, true);
+        Stats_Track("rpm", 0.2f, false);
+        if (Anomaly_Init(anomaly_rules, sizeof(anomaly_rules) / sizeof(anomaly_rules[0])) != STATUS_OK) {
+            Serial.println("Warning: Anomaly rules reference unknown signals");
+        }
+        Filter_Init(display_filters, sizeof(display_filters) / sizeof(display_filters[0]));
+        
+        if (Capture_Init(&capture_config) == STATUS_OK) {
+            Serial.println("Event capture initialized");
+        } else {
+            Serial.println("Warning: Event capture unavailable (LittleFS)");
+        }
+        
+        if (Perf_Init() != STATUS_OK) {
+            Serial.println("Warning: Performance results will not be stored (LittleFS)");
+        }
     } else {
         Serial.println("Error: OBD2 initialization failed");
         current_state = SYSTEM_STATE_ERROR;
         return;
     }
     
-    // Initialize WiFi
-    WiFi.begin(ssid, password);
-    current_state = SYSTEM_STATE_CONNECTING;
+    HAL_GPIO_Write(STATUS_LED, GPIO_LEVEL_HIGH);
+}
+
+void select_vehicle_profile(void) {
+    char vin[VIN_LENGTH + 1];
+    const VehicleProfile_t* profile = nullptr;
     
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.print(".");
-        HAL_GPIO_Toggle(STATUS_LED);
-        attempts++;
+    if (OBD2_ReadVIN(vin, sizeof(vin)) == STATUS_OK) {
+        Serial.printf("VIN: %s\n", vin);
+        profile = Profile_FindByVIN(vin);
+        
+        // Unknown bike: fall back to supported-PID discovery
+        if (profile == nullptr) {
+            uint32_t supported_pids[3];
+            if (OBD2_DiscoverSupportedPIDs(supported_pids) == STATUS_OK) {
+                profile = Profile_BuildGeneric(supported_pids);
+            }
+        }
+    } else {
+        Serial.println("VIN not available (ignition off?), using default profile");
     }
     
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\nWiFi connected!");
-        Serial.print("IP address: ");
-        Serial.println(WiFi.localIP());
-        current_state = SYSTEM_STATE_CONNECTED;
-    } else {
-        Serial.println("\nWiFi connection failed, continuing without WiFi");
-        current_state = SYSTEM_STATE_IDLE;
+    if (profile == nullptr) {
+        profile = Profile_GetDefault();
     }
     
-    // Setup web server
-    server.on("/", handleRoot);
-    server.on("/data", handleData);
-    server.begin();
+    OBD2_ApplyProfile(profile);
+    Serial.printf("Vehicle profile: %s (%d PIDs)\n", profile->name, profile->pid_count);
     
-    HAL_GPIO_Write(STATUS_LED, GPIO_LEVEL_HIGH);
+    // Saved poll periods that were loaded before the profile existed
+    Settings_ApplyPIDPeriods();
 }
 
 void vehicle_data_callback(const VehicleData_t* data) {
     if (data != nullptr) {
         last_vehicle_data = *data;
-        
-        Serial.printf("RPM: %d, Speed: %d km/h, Temp: %dC, Throttle: %d%%\n",
-                     data->rpm, data->speed, data->coolantTemp, data->throttlePosition);
+        Capture_AddSample(data);
+        Derived_ProcessSample(data);
+        Stats_Update();
+        Anomaly_Evaluate(millis());
     }
 }
 
 void system_task(void) {
-    static uint32_t last_data_read = 0;
     static uint32_t last_led_blink = 0;
-    static uint32_t last_ble_check = 0;
-    static uint32_t debug_counter = 0;
+    static uint32_t last_dtc_check = 0;
+    static uint8_t last_dtc_count = 0;
+    static bool have_dtc_count = false;
+    static uint32_t last_alert_change = 0;
+    static uint8_t last_can_state = CAN_ERROR_ACTIVE;
     
     uint32_t current_time = millis();
     
-    // Debug: Print every 5 seconds
-    if (debug_counter++ % 250 == 0) {  // 250 * 20ms = 5s
-        Serial.printf("DEBUG: time=%lu, last_ble_check=%lu, diff=%lu\n", 
-                      current_time, last_ble_check, current_time - last_ble_check);
-    }
-    
-    // Check BLE connection timeout every 2 seconds
-    if (current_time - last_ble_check >= 2000) {
-        Serial.println("MAIN: Calling BLE check..."); // DEBUG
-        if (g_bleService) {
-            g_bleService->checkConnectionTimeout();
-        } else {
-            Serial.println("MAIN: g_bleService is NULL!"); // DEBUG
+    // A performance run owns the bus until it finishes or is cancelled
+    if (Perf_GetState() != PERF_STATE_IDLE) {
+        Health_Begin(obd_health);
+        bool finished = Perf_Process();
+        Health_End(obd_health);
+        if (finished) {
+            print_perf_result(Perf_GetLastResult());
+        }
+    } else if (current_state != SYSTEM_STATE_ERROR) {
+        // Read OBD2 data; per-PID rates come from the active vehicle profile
+        Health_Begin(obd_health);
+        Status_t status = OBD2_ReadAllData();
+        Health_End(obd_health);
+        
+        if (status == STATUS_OK) {
+            current_state = SYSTEM_STATE_CONNECTED;
         }
-        last_ble_check = current_time;
     }
     
-    // Read OBD2 data periodically
-    if (current_time - last_data_read >= 200) {
-        if (current_state != SYSTEM_STATE_ERROR) {
-            Status_t status = OBD2_ReadAllData();
+    // Poll DTC count and capture the freeze frame when a new DTC sets
+    if (current_time - last_dtc_check >= 5000) {
+        if (current_state != SYSTEM_STATE_ERROR && Perf_GetState() == PERF_STATE_IDLE) {
+            bool mil_on = false;
+            uint8_t dtc_count = 0;
             
-            if (status == STATUS_OK) {
-                current_state = SYSTEM_STATE_CONNECTED;
+            if (OBD2_ReadMonitorStatus(&mil_on, &dtc_count) == STATUS_OK) {
+                // DTCs stored before power-up are the baseline, not a new event
+                if (have_dtc_count && dtc_count > last_dtc_count) {
+                    FreezeFrame_t freeze_frame;
+                    
+                    if (OBD2_ReadFreezeFrame(0, &freeze_frame) == STATUS_OK) {
+                        LOG_WARN("DTC set: raw 0x%04X (MIL %s)", freeze_frame.dtc, mil_on ? "on" : "off");
+                        Capture_Trigger(CAPTURE_TRIGGER_DTC, &freeze_frame);
+                    } else {
+                        Capture_Trigger(CAPTURE_TRIGGER_DTC, nullptr);
+                    }
+                }
+                last_dtc_count = dtc_count;
+                have_dtc_count = true;
             }
         }
-        last_data_read = current_time;
+        last_dtc_check = current_time;
+    }
+    
+    // Report CAN fault confinement changes; bus-off recovery runs in the CAN driver
+    CAN_ErrorStats_t can_errors;
+    CAN_GetErrorStats(&can_errors);
+    if (can_errors.state != last_can_state) {
+        if (last_can_state == CAN_ERROR_BUS_OFF) {
+            LOG_INFO("CAN: bus-off recovered in %lu ms (%lu attempts total)",
+                     (unsigned long)can_errors.last_recovery_ms, (unsigned long)can_errors.recovery_attempts);
+        }
+        LOG_WARN("CAN: error %s", CAN_ErrorStateName(can_errors.state));
+        last_can_state = can_errors.state;
+    }
+    
+    // Log alert changes; the BLE sink pushes them to the app
+    uint32_t alert_change = Anomaly_GetChangeCount();
+    if (alert_change != last_alert_change) {
+        const char* alerts[ALERT_MAX_ACTIVE];
+        uint8_t alert_count = Anomaly_GetActiveNames(alerts, ALERT_MAX_ACTIVE);
+        
+        LOG_INFO("Alerts (%u)", alert_count);
+        for (uint8_t i = 0; i < alert_count; i++) {
+            LOG_INFO("  alert: %s", alerts[i]);    // Rule names are static
+        }
+        last_alert_change = alert_change;
     }
     
-    // Blink status LED
-    if (current_time - last_led_blink >= 1000) {
+    // Blink status LED; fast blink while an alert is active
+    uint32_t blink_interval = (Anomaly_GetActiveMask() != 0) ? 100 : 1000;
+    if (current_time - last_led_blink >= blink_interval) {
         HAL_GPIO_Toggle(STATUS_LED);
         last_led_blink = current_time;
     }
@@ -248,145 +393,20 @@ void system_task(void) {
     }
 }
 
-void handleRoot() {
-    String html = R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <title>Svartpilen 401 OBD2 Monitor</title>
-    <meta http-equiv='refresh' content='2'>
-    <meta name='viewport' content='width=device-width, initial-scale=1'>
-    <style>
-        body { 
-            font-family: Arial, sans-serif; 
-            margin: 0; 
-            padding: 20px; 
-            background: linear-gradient(135deg, #1a1a1a, #2d2d2d); 
-            color: #fff; 
-        }
-        .container { 
-            max-width: 800px; 
-            margin: 0 auto; 
-        }
-        .header {
-            text-align: center;
-            margin-bottom: 30px;
-            padding: 20px;
-            background: rgba(255, 107, 53, 0.1);
-            border-radius: 10px;
-            border: 2px solid #ff6b35;
-        }
-        .gauge { 
-            display: inline-block; 
-            margin: 15px; 
-            text-align: center; 
-            background: rgba(255, 255, 255, 0.1);
-            padding: 20px;
-            border-radius: 10px;
-            min-width: 150px;
-        }
-        .gauge-value { 
-            font-size: 2.5em; 
-            font-weight: bold; 
-            color: #ff6b35; 
-            margin-bottom: 10px;
-        }
-        .gauge-label { 
-            font-size: 1.2em; 
-            color: #ccc;
-        }
-        .status { 
-            padding: 15px; 
-            border-radius: 10px; 
-            margin: 20px 0; 
-            text-align: center;
-            font-size: 1.3em;
-            font-weight: bold;
-        }
-        .running { 
-            background: linear-gradient(135deg, #4CAF50, #45a049); 
-        }
-        .stopped { 
-            background: linear-gradient(135deg, #f44336, #d32f2f); 
-        }
-    </style>
-</head>
-<body>
-    <div class='container'>
-        <div class='header'>
-            <h1> Husqvarna Svartpilen 401</h1>
-            <h2>Professional OBD2 Diagnostics</h2>
-            <p>Layered Architecture System</p>
-        </div>
-        
-        <div class='status )";
-  
-    html += last_vehicle_data.engineRunning ? "running'> Engine: RUNNING" : "stopped'> Engine: STOPPED";
-    html += R"('></div>
-        
-        <div style='text-align: center;'>
-            <div class='gauge'>
-                <div class='gauge-value'>)" + String(last_vehicle_data.rpm) + R"(</div>
-                <div class='gauge-label'>Engine RPM</div>
-            </div>
-            <div class='gauge'>
-                <div class='gauge-value'>)" + String(last_vehicle_data.speed) + R"(</div>
-                <div class='gauge-label'>Speed (km/h)</div>
-            </div>
-            <div class='gauge'>
-                <div class='gauge-value'>)" + String(last_vehicle_data.coolantTemp) + R"(</div>
-                <div class='gauge-label'>Coolant (C)</div>
-            </div>
-            <div class='gauge'>
-                <div class='gauge-value'>)" + String(last_vehicle_data.throttlePosition) + R"(</div>
-                <div class='gauge-label'>Throttle (%)</div>
-            </div>
-        </div>
-        
-        <div style='text-align: center; margin-top: 30px; color: #888;'>
-            <p>System State: )" + String(current_state) + R"(</p>
-            <p>Last update: )" + String(millis() - last_vehicle_data.lastUpdate) + R"( ms ago</p>
-            <p>Uptime: )" + String(millis() / 1000) + R"( seconds</p>
-        </div>
-    </div>
-</body>
-</html>)";
-    
-    server.send(200, "text/html", html);
-}
-
-void handleData() {
-    String json = "{";
-    json += "\"rpm\":" + String(last_vehicle_data.rpm) + ",";
-    json += "\"speed\":" + String(last_vehicle_data.speed) + ",";
-    json += "\"coolantTemp\":" + String(last_vehicle_data.coolantTemp) + ",";
-    json += "\"throttlePosition\":" + String(last_vehicle_data.throttlePosition) + ",";
-    json += "\"engineRunning\":" + String(last_vehicle_data.engineRunning ? "true" : "false") + ",";
-    json += "\"dataValid\":" + String(last_vehicle_data.dataValid ? "true" : "false") + ",";
-    json += "\"systemState\":" + String(current_state) + ",";
-    json += "\"lastUpdate\":" + String(last_vehicle_data.lastUpdate) + ",";
-    json += "\"uptime\":" + String(millis());
-    json += "}";
+void print_perf_result(const PerfResult_t* result) {
+    if (result == nullptr) {
+        return;
+    }
     
-    server.sendHeader("Access-Control-Allow-Origin", "*");
-    server.send(200, "application/json", json);
-}
-
-// JSON output for desktop application
-void output_vehicle_data_json() {
-    // Create JSON object
-    Serial.println("{");
-    Serial.printf("  \"timestamp\": %lu,\n", millis());
-    Serial.printf("  \"rpm\": %d,\n", last_vehicle_data.rpm);
-    Serial.printf("  \"speed\": %d,\n", last_vehicle_data.speed);
-    Serial.printf("  \"coolant_temp\": %d,\n", last_vehicle_data.coolantTemp);
-    Serial.printf("  \"throttle_position\": %d,\n", last_vehicle_data.throttlePosition);
-    Serial.printf("  \"system_state\": \"%s\",\n", 
-        (current_state == SYSTEM_STATE_CONNECTED) ? "CONNECTED" :
-        (current_state == SYSTEM_STATE_IDLE) ? "IDLE" :
-        (current_state == SYSTEM_STATE_ERROR) ? "ERROR" : 
-        (current_state == SYSTEM_STATE_CONNECTING) ? "CONNECTING" : "UNKNOWN");
-    Serial.printf("  \"wifi_connected\": %s,\n", WiFi.isConnected() ? "true" : "false");
-    Serial.printf("  \"wifi_rssi\": %d\n", WiFi.RSSI());
-    Serial.println("}");
+    // Through the logger: the loop must not wait for the serial port (console dumps hold it)
+    if (!result->valid) {
+        LOG_WARN("PERF: %s run aborted after %u samples", Perf_RunName(result->type), result->sample_count);
+        return;
+    }
+    LOG_INFO("PERF: %s %lu ms, %u.%02u km/h at %lu.%u m", Perf_RunName(result->type),
+             (unsigned long)(result->elapsed_us / 1000), result->finish_speed_x100 / 100,
+             result->finish_speed_x100 % 100, (unsigned long)(result->distance_mm / 1000),
+             (unsigned)(result->distance_mm % 1000 / 100));
+    LOG_INFO("PERF: %u samples, every %lu us, max gap %lu us", result->sample_count,
+             (unsigned long)result->mean_interval_us, (unsigned long)result->max_interval_us);
 }
@@ -0,0 +1,56 @@
+/**
+ * @file mcp2515_tx_test.cpp
+ * @brief Host test: TX buffer verdicts the MCP2515 driver acts on
+ *
+ * Feeds MCP_TxVerdict() the TXBnCTRL states a loaded buffer goes through:
+ * waiting for the bus, losing arbitration, transmit errors, an abort, and
+ * a frame that went out before its completion flag was drained. A frame
+ * that only loses arbitration must stay pending until the limit.
+ *
+ * Example:
+ *     g++ -O2 -std=gnu++11 -I firmware/include tools/mcp2515_tx_test.cpp \
+ *         -o mcp2515_tx_test && ./mcp2515_tx_test
+ */
+
+#include <cstdio>
+#include "mcp2515_registers.h"
+
+#define TEST_LIMIT_US               20480   /* 64 frames of 160 bits at 500 kbit/s */
+
+static int failures = 0;
+
+static void expect(const char* name, uint8_t txbctrl, uint32_t loaded_for_us, MCP_TxVerdict_t expected) {
+    static const char* const names[] = { "pending", "sent", "failed" };
+    MCP_TxVerdict_t verdict = MCP_TxVerdict(txbctrl, loaded_for_us, TEST_LIMIT_US);
+    printf("%-44s %-8s %s\n", name, names[verdict], (verdict == expected) ? "ok" : "FAIL");
+    if (verdict != expected) {
+        failures++;
+    }
+}
+
+int main() {
+    const uint8_t txp = 0x01;
+    
+    expect("waiting for the bus", MCP_TXB_TXREQ | txp, 2000, MCP_TX_PENDING);
+    expect("waiting for the bus past the limit", MCP_TXB_TXREQ | txp, TEST_LIMIT_US + 1, MCP_TX_FAILED);
+    
+    // Arbitration loss: the controller retries on its own
+    expect("lost arbitration", MCP_TXB_TXREQ | MCP_TXB_MLOA | txp, 1500, MCP_TX_PENDING);
+    expect("lost arbitration just inside the limit", MCP_TXB_TXREQ | MCP_TXB_MLOA | txp, TEST_LIMIT_US,
+           MCP_TX_PENDING);
+    expect("lost arbitration past the limit", MCP_TXB_TXREQ | MCP_TXB_MLOA | txp, TEST_LIMIT_US + 1,
+           MCP_TX_FAILED);
+    
+    expect("transmit error", MCP_TXB_TXREQ | MCP_TXB_TXERR | txp, 1500, MCP_TX_FAILED);
+    expect("transmit error after lost arbitration", MCP_TXB_TXREQ | MCP_TXB_TXERR | MCP_TXB_MLOA, 1500,
+           MCP_TX_FAILED);
+    expect("aborted", MCP_TXB_ABTF | txp, 1500, MCP_TX_FAILED);
+    
+    // Sent; the RX task has not drained TXnIF yet
+    expect("sent, completion not drained", txp, 1500, MCP_TX_PENDING);
+    expect("sent after lost arbitration, not drained", MCP_TXB_MLOA | txp, 1500, MCP_TX_PENDING);
+    expect("sent, completion never drained", txp, TEST_LIMIT_US + 1, MCP_TX_SENT);
+    
+    printf("%s\n", failures == 0 ? "all passed" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Convert an OBD2 reader trace dump to Chrome trace-event JSON
+
+The dump comes from the reader's /trace endpoint or the "trace" serial
+command. Each core's cycle counter is unwrapped and mapped to microseconds
+through the sync records, so both cores share one time axis. Begin/end
+pairs become complete ("X") events; open the output in chrome://tracing
+or https://ui.perfetto.dev.
+
+Example:
+    python trace_to_chrome.py --host 192.168.1.50 -o trace.json
+    python trace_to_chrome.py dump.txt -o trace.json
+"""
+
+import argparse
+import json
+import sys
+
+PHASE_BEGIN = 0
+PHASE_END = 1
+PHASE_INSTANT = 2
+EVENT_SYNC = 0
+
+HTTP_ROUTES = ["/", "/data", "/stats", "/perf", "/can", "/trace"]
+
+
+def parse_dump(lines):
+    """Header values, event names and per-core record lists"""
+    cpu_hz = 240000000
+    names = {}
+    cores = {}
+    for line in lines:
+        line = line.strip()
+        if not line:
+            continue
+        if line.startswith("# trace"):
+            for field in line.split()[2:]:
+                key, _, value = field.partition("=")
+                if key == "cpu_hz":
+                    cpu_hz = int(value)
+        elif line.startswith("# event"):
+            _, _, event, name = line.split(maxsplit=3)
+            names[int(event)] = name
+        else:
+            # Serial captures carry the reader's other output too; keep record lines only
+            fields = line.split()
+            if len(fields) != 5 or not all(f.isdigit() for f in fields):
+                continue
+            core, cycles, event, phase, arg = (int(f) for f in fields)
+            cores.setdefault(core, []).append((cycles, event, phase, arg))
+    return cpu_hz, names, cores
+
+
+def unwrap(values):
+    """Extend a wrapping 32-bit sequence to a monotonic one"""
+    offset = 0
+    previous = None
+    result = []
+    for value in values:
+        # Only a drop of more than half the range is a wrap, not a small step back
+        if previous is not None and previous - value > 1 << 31:
+            offset += 1 << 32
+        previous = value
+        result.append(value + offset)
+    return result
+
+
+def to_microseconds(records, cpu_mhz):
+    """Timestamp of every record, anchored on the nearest earlier sync record"""
+    cycles = unwrap([r[0] for r in records])
+    syncs = [(cycles[i], r[3]) for i, r in enumerate(records) if r[1] == EVENT_SYNC]
+    sync_us = unwrap([us for _, us in syncs])
+    anchors = [(c, us) for (c, _), us in zip(syncs, sync_us)]
+    if not anchors:
+        anchors = [(cycles[0], 0)]
+
+    times = []
+    anchor = 0
+    for c in cycles:
+        while anchor + 1 < len(anchors) and anchors[anchor + 1][0] <= c:
+            anchor += 1
+        base_cycles, base_us = anchors[anchor]
+        times.append(base_us + (c - base_cycles) / cpu_mhz)
+    return times
+
+
+def convert(cpu_hz, names, cores):
+    events = []
+    for core, records in sorted(cores.items()):
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core,
+                       "args": {"name": f"core {core}"}})
+        if not records:
+            continue
+        times = to_microseconds(records, cpu_hz / 1e6)
+        open_events = {}
+
+        for (_, event, phase, arg), ts in zip(records, times):
+            name = names.get(event, f"event_{event}")
+            if event == EVENT_SYNC:
+                continue
+            args = {"arg": arg}
+            if name == "http_request" and arg < len(HTTP_ROUTES):
+                args["route"] = HTTP_ROUTES[arg]
+
+            if phase == PHASE_BEGIN:
+                open_events.setdefault(event, []).append((ts, args))
+            elif phase == PHASE_END:
+                # Tasks and ISRs interleave on a core, so pair by event rather than by nesting
+                stack = open_events.get(event)
+                if not stack:
+                    continue
+                start, begin_args = stack.pop()
+                begin_args.update({"end_arg": arg})
+                events.append({"name": name, "ph": "X", "ts": start, "dur": ts - start,
+                               "pid": 0, "tid": core, "args": begin_args})
+            else:
+                events.append({"name": name, "ph": "i", "s": "t", "ts": ts,
+                               "pid": 0, "tid": core, "args": args})
+
+    # Chrome tolerates negative times badly; start the trace at zero
+    timed = [e for e in events if "ts" in e]
+    if timed:
+        origin = min(e["ts"] for e in timed)
+        for e in timed:
+            e["ts"] = round(e["ts"] - origin, 3)
+            if "dur" in e:
+                e["dur"] = round(e["dur"], 3)
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert an OBD2 reader trace dump to Chrome trace JSON")
+    parser.add_argument("dump", nargs="?", help="Dump file (serial capture); omit with --host")
+    parser.add_argument("--host", help="Fetch the dump from http://<host>/trace")
+    parser.add_argument("-o", "--output", default="trace.json", help="Output JSON file")
+    args = parser.parse_args()
+
+    if args.host:
+        import requests
+        response = requests.get(f"http://{args.host}/trace", timeout=10)
+        response.raise_for_status()
+        lines = response.text.splitlines()
+    elif args.dump:
+        with open(args.dump, encoding="utf-8", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        parser.error("give a dump file or --host")
+
+    cpu_hz, names, cores = parse_dump(lines)
+    if not cores:
+        raise SystemExit("No trace records found")
+    trace = convert(cpu_hz, names, cores)
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(trace, f)
+    records = sum(len(r) for r in cores.values())
+    print(f"{records} records from {len(cores)} core(s) -> {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())